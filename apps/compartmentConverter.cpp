@@ -89,6 +89,7 @@ int main(const int argc, char** argv)
         ("gids,g", po::value< std::vector< uint32_t >>()->multitoken(),
          "List of whitespace separated GIDs to convert")
         ("compare,c", "Compare written report with input")
+        ("stats,s", "Write the per-frame statistics of the output report")
         ("dump,d", "Dump input report information (no output conversion)");
 
     po::options_description hidden;
@@ -329,6 +330,20 @@ int main(const int argc, char** argv)
               << gids.size() << " cells X " << nFrames << " frames)"
               << std::endl;
 
+    if (vm.count("stats"))
+    {
+        clock.reset();
+        const brion::CompartmentReportStatistics stats(outURI);
+        if (stats.getPath().empty())
+        {
+            std::cerr << "Could not write the statistics of " << outURI
+                      << std::endl;
+            return EXIT_FAILURE;
+        }
+        std::cout << "Wrote statistics " << stats.getPath() << " in "
+                  << size_t(clock.getTimef()) << " ms" << std::endl;
+    }
+
     if (vm.count("compare"))
     {
         progress.restart(nFrames);
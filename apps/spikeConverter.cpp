@@ -39,8 +39,32 @@
 #include <boost/program_options.hpp>
 #include <boost/progress.hpp>
 
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
 namespace po = boost::program_options;
 
+namespace
+{
+// @return the peak resident memory of the process in MB, 0 if unknown
+float _getPeakMemory()
+{
+#ifdef _WIN32
+    return 0.f;
+#else
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0.f;
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024.f / 1024.f; // bytes
+#else
+    return usage.ru_maxrss / 1024.f; // kilobytes
+#endif
+#endif
+}
+}
+
 int main(int argc, char* argv[])
 {
     // clang-format off
@@ -48,7 +72,12 @@ int main(int argc, char* argv[])
                                     lunchbox::term::getSize().first);
     options.add_options()
         ( "help,h", "Produce help message" )
-        ( "version,v", "Show program name/version banner and exit" );
+        ( "version,v", "Show program name/version banner and exit" )
+        ( "window,w", po::value<float>()->default_value(10.f),
+          "Time window in ms converted at once. The next window is read "
+          "while the current one is written. Binary and time sorted SONATA "
+          "inputs are read window by window, ASCII, NEST and unsorted "
+          "SONATA inputs are loaded entirely when opened" );
 
     po::options_description hidden;
     hidden.add_options()
@@ -120,6 +149,13 @@ int main(int argc, char* argv[])
         return EXIT_FAILURE;
     }
 
+    const float window = vm["window"].as<float>();
+    if (!(window > 0))
+    {
+        std::cerr << "Invalid time window " << window << " ms" << std::endl;
+        return EXIT_FAILURE;
+    }
+
     try
     {
         lunchbox::Clock clock;
@@ -133,19 +169,39 @@ int main(int argc, char* argv[])
                                brion::MODE_WRITE);
         writeTime += clock.resetTimef();
 
-        const float step = 10.f; // ms, arbitrary value
-        while (in.getState() == brion::SpikeReport::State::ok)
+        // Double buffering: the next window is read by the executor of the
+        // input report while the current one is written
+        size_t numSpikes = 0;
+        auto next = in.readUntil(in.getCurrentTime() + window);
+        for (;;)
         {
-            const auto spikes = in.readUntil(in.getCurrentTime() + step).get();
+            const auto spikes = next.get();
             readTime += clock.resetTimef();
 
+            const bool more = in.getState() == brion::SpikeReport::State::ok;
+            if (more)
+                next = in.readUntil(in.getCurrentTime() + window);
+
             out.write(spikes);
+            numSpikes += spikes.size();
             writeTime += clock.resetTimef();
+            if (!more)
+                break;
         }
+        out.close();
+        writeTime += clock.resetTimef();
 
-        std::cout << "Converted " << input << " => "
-                  << vm["output"].as<std::string>() << " in " << readTime
-                  << " + " << writeTime << " ms" << std::endl;
+        const float seconds = (readTime + writeTime) / 1000.f;
+        const float megabytes = numSpikes * sizeof(brion::Spike) / 1048576.f;
+        std::cout << "Converted " << numSpikes << " spikes " << input
+                  << " => " << vm["output"].as<std::string>() << " in "
+                  << readTime << " + " << writeTime << " ms ("
+                  << numSpikes / seconds << " spikes/s, "
+                  << megabytes / seconds << " MB/s)" << std::endl;
+
+        const float peakMemory = _getPeakMemory();
+        if (peakMemory > 0)
+            std::cout << "Peak memory: " << peakMemory << " MB" << std::endl;
     }
     catch (const std::exception& exception)
     {
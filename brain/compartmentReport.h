@@ -135,5 +135,6 @@ private:
     std::shared_ptr<detail::CompartmentReportReader> _impl;
 
     friend class CompartmentReportView;
+    friend class CompartmentReportGroup;
 };
 }
@@ -0,0 +1,355 @@
+/* Copyright (c) 2018, EPFL/Blue Brain Project
+ *
+ * This file is part of Brion <https://github.com/BlueBrain/Brion>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "compartmentReportGroup.h"
+#include "detail/compartmentReport.h"
+
+#include <lunchbox/log.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <mutex>
+
+namespace brain
+{
+namespace
+{
+bool _isEqual(const double a, const double b)
+{
+    // Using double epsilon is too strict for times computed in float
+    return std::abs(a - b) <= std::numeric_limits<float>::epsilon() *
+                                  std::max(std::abs(a), std::abs(b));
+}
+
+bool _haveSameLayout(const brion::CompartmentReport& a,
+                     const brion::CompartmentReport& b)
+{
+    return a.getFrameSize() == b.getFrameSize() &&
+           a.getGIDs() == b.getGIDs() &&
+           a.getCompartmentCounts() == b.getCompartmentCounts() &&
+           a.getOffsets() == b.getOffsets();
+}
+
+template <typename T>
+using Load = std::function<std::future<T>()>;
+
+// @return the results of loads run in tasks of the default executor, in a
+// future set by the last task to complete. The loads of the reports post
+// to the same executor, so they run inline in these tasks instead of being
+// waited for by them, which could deadlock.
+template <typename T>
+std::future<std::vector<T>> _whenAll(const std::vector<Load<T>>& loads)
+{
+    struct State
+    {
+        std::vector<T> results;
+        std::atomic<size_t> pending;
+        std::mutex mutex;
+        std::exception_ptr error;
+        std::promise<std::vector<T>> promise;
+    };
+    auto state = std::make_shared<State>();
+    state->results.resize(loads.size());
+    state->pending = loads.size();
+    auto future = state->promise.get_future();
+    if (loads.empty())
+    {
+        state->promise.set_value(std::vector<T>());
+        return future;
+    }
+
+    auto executor = brion::Executor::getDefault();
+    for (size_t i = 0; i < loads.size(); ++i)
+    {
+        const Load<T> load = loads[i];
+        executor->post([state, load, i] {
+            try
+            {
+                state->results[i] = load().get();
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                if (!state->error)
+                    state->error = std::current_exception();
+            }
+            if (--state->pending > 0)
+                return;
+
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (state->error)
+                state->promise.set_exception(state->error);
+            else
+                state->promise.set_value(std::move(state->results));
+        });
+    }
+    return future;
+}
+}
+
+namespace detail
+{
+struct CompartmentReportGroup
+{
+    explicit CompartmentReportGroup(const URIs& uris)
+    {
+        if (uris.empty())
+            LBTHROW(std::runtime_error("Empty compartment report group"));
+
+        // Opening the reports concurrently, the mappings are parsed in
+        // parallel
+        auto executor = brion::Executor::getDefault();
+        std::vector<std::future<std::shared_ptr<CompartmentReportReader>>>
+            futures;
+        for (const auto& uri : uris)
+            futures.push_back(executor->post([uri] {
+                return std::make_shared<CompartmentReportReader>(uri);
+            }));
+        for (auto& future : futures)
+            readers.push_back(future.get());
+
+        const auto& first = readers.front()->metaData;
+        metaData.startTime = first.startTime;
+        metaData.endTime = first.endTime;
+        metaData.timeStep = first.timeStep;
+        metaData.timeUnit = first.timeUnit;
+        metaData.frameCount = first.frameCount;
+        gids = readers.front()->getGIDs();
+
+        for (const auto& reader : readers)
+        {
+            const auto& other = reader->metaData;
+            if (!_isEqual(other.startTime, metaData.startTime) ||
+                !_isEqual(other.timeStep, metaData.timeStep) ||
+                other.timeUnit != metaData.timeUnit)
+            {
+                LBTHROW(std::runtime_error(
+                    "Compartment report " + std::to_string(reader->uri) +
+                    " does not have the time base of " +
+                    std::to_string(readers.front()->uri)));
+            }
+            metaData.endTime = std::min(metaData.endTime, other.endTime);
+            metaData.frameCount =
+                std::min(metaData.frameCount, other.frameCount);
+
+            GIDSet common;
+            std::set_intersection(gids.begin(), gids.end(),
+                                  reader->getGIDs().begin(),
+                                  reader->getGIDs().end(),
+                                  std::inserter(common, common.end()));
+            gids.swap(common);
+        }
+    }
+
+    std::vector<std::shared_ptr<CompartmentReportReader>> readers;
+    std::vector<brain::CompartmentReport> reports;
+    CompartmentReportMetaData metaData;
+    GIDSet gids;
+};
+
+struct CompartmentReportGroupView
+{
+    std::vector<brain::CompartmentReportView> views;
+    std::vector<std::shared_ptr<brion::CompartmentReport>> reports;
+    CompartmentReportMetaData metaData;
+    GIDSet gids;
+};
+}
+
+CompartmentReportGroup::CompartmentReportGroup(const URIs& uris)
+    : _impl(new detail::CompartmentReportGroup(uris))
+{
+    for (const auto& reader : _impl->readers)
+        _impl->reports.push_back(CompartmentReport(reader));
+}
+
+CompartmentReportGroup::~CompartmentReportGroup()
+{
+}
+
+CompartmentReportGroup::CompartmentReportGroup(CompartmentReportGroup&&) =
+    default;
+CompartmentReportGroup& CompartmentReportGroup::operator=(
+    CompartmentReportGroup&&) = default;
+
+const CompartmentReportMetaData& CompartmentReportGroup::getMetaData() const
+{
+    return _impl->metaData;
+}
+
+size_t CompartmentReportGroup::getSize() const
+{
+    return _impl->reports.size();
+}
+
+CompartmentReport& CompartmentReportGroup::getReport(const size_t index)
+{
+    return _impl->reports.at(index);
+}
+
+const GIDSet& CompartmentReportGroup::getGIDs() const
+{
+    return _impl->gids;
+}
+
+CompartmentReportGroupView CompartmentReportGroup::createView(
+    const GIDSet& gids)
+{
+    if (!std::includes(_impl->gids.begin(), _impl->gids.end(), gids.begin(),
+                       gids.end()))
+    {
+        LBTHROW(std::runtime_error("GIDs not present in all the reports"));
+    }
+
+    std::unique_ptr<detail::CompartmentReportGroupView> view(
+        new detail::CompartmentReportGroupView);
+    view->metaData = _impl->metaData;
+    view->gids = gids.empty() ? _impl->gids : gids;
+    if (view->gids.empty())
+        LBTHROW(std::runtime_error("No GIDs present in all the reports"));
+
+    // The mappings of the subset are resolved concurrently, the resulting
+    // layouts are compared to share the index of the views
+    auto executor = brion::Executor::getDefault();
+    std::vector<std::future<std::shared_ptr<brion::CompartmentReport>>>
+        futures;
+    for (const auto& reader : _impl->readers)
+    {
+        const auto uri = reader->uri;
+        const auto subset = view->gids;
+        futures.push_back(executor->post([uri, subset] {
+            return std::make_shared<brion::CompartmentReport>(
+                uri, brion::MODE_READ, subset);
+        }));
+    }
+
+    std::vector<const detail::CompartmentReportView*> layouts;
+    for (size_t i = 0; i < futures.size(); ++i)
+    {
+        const auto report = futures[i].get();
+        const detail::CompartmentReportView* sameLayout = nullptr;
+        for (const auto* layout : layouts)
+        {
+            if (_haveSameLayout(*layout->report, *report))
+            {
+                sameLayout = layout;
+                break;
+            }
+        }
+
+        std::unique_ptr<detail::CompartmentReportView> impl(
+            new detail::CompartmentReportView(_impl->readers[i], report,
+                                              sameLayout));
+        if (!sameLayout)
+            layouts.push_back(impl.get());
+        view->reports.push_back(report);
+        view->views.push_back(CompartmentReportView(std::move(impl)));
+    }
+    return CompartmentReportGroupView(std::move(view));
+}
+
+CompartmentReportGroupView CompartmentReportGroup::createView()
+{
+    return createView(GIDSet());
+}
+
+CompartmentReportGroupView::CompartmentReportGroupView(
+    std::unique_ptr<detail::CompartmentReportGroupView> impl)
+    : _impl(std::move(impl))
+{
+}
+
+CompartmentReportGroupView::CompartmentReportGroupView(
+    CompartmentReportGroupView&&) = default;
+CompartmentReportGroupView& CompartmentReportGroupView::operator=(
+    CompartmentReportGroupView&&) = default;
+
+CompartmentReportGroupView::~CompartmentReportGroupView()
+{
+}
+
+const GIDSet& CompartmentReportGroupView::getGIDs() const
+{
+    return _impl->gids;
+}
+
+size_t CompartmentReportGroupView::getSize() const
+{
+    return _impl->views.size();
+}
+
+CompartmentReportView& CompartmentReportGroupView::getView(const size_t index)
+{
+    return _impl->views.at(index);
+}
+
+std::future<std::vector<brion::Frame>> CompartmentReportGroupView::load(
+    const double timestamp)
+{
+    if (timestamp < _impl->metaData.startTime ||
+        timestamp >= _impl->metaData.endTime)
+    {
+        throw std::logic_error("Invalid timestamp");
+    }
+
+    std::vector<Load<brion::Frame>> loads;
+    for (const auto& report : _impl->reports)
+        loads.push_back([report, timestamp] {
+            return report->loadFrame(timestamp);
+        });
+    return _whenAll(loads);
+}
+
+std::future<std::vector<brion::Frames>> CompartmentReportGroupView::load(
+    double start, double end)
+{
+    if (end <= start)
+        throw std::logic_error("Invalid interval");
+
+    start = std::max(start, _impl->metaData.startTime);
+    end = std::min(end, _impl->metaData.endTime);
+
+    std::vector<Load<brion::Frames>> loads;
+    for (const auto& report : _impl->reports)
+    {
+        if (end <= start)
+            loads.push_back([] {
+                std::promise<brion::Frames> empty;
+                brion::Frames frames;
+                frames.timeStamps.reset(new brion::doubles);
+                frames.data.reset(new brion::floats);
+                empty.set_value(frames);
+                return empty.get_future();
+            });
+        else
+            loads.push_back([report, start, end] {
+                return report->loadFrames(start, end);
+            });
+    }
+    return _whenAll(loads);
+}
+
+std::future<std::vector<brion::Frames>> CompartmentReportGroupView::loadAll()
+{
+    return load(_impl->metaData.startTime, _impl->metaData.endTime);
+}
+}
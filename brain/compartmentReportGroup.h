@@ -0,0 +1,173 @@
+/* Copyright (c) 2018, EPFL/Blue Brain Project
+ *
+ * This file is part of Brion <https://github.com/BlueBrain/Brion>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#pragma once
+
+#include "compartmentReport.h"
+
+#include <brain/api.h>
+#include <brain/types.h>
+#include <future>
+
+namespace brain
+{
+namespace detail
+{
+struct CompartmentReportGroup;
+struct CompartmentReportGroupView;
+}
+
+/**
+ * Reader for several compartment reports of the same simulation.
+ *
+ * The reports, e.g. soma voltages, compartment voltages and currents, share
+ * a time base and are opened concurrently. Their views are created for the
+ * same cells and load the same frames of all the reports at once.
+ */
+class CompartmentReportGroup
+{
+public:
+    /**
+     * Open several reports in read mode.
+     *
+     * @param uris the URIs of the compartment reports
+     * @throw std::runtime_error if a report can't be opened, or if the
+     *        reports don't have the same start time, timestep and time unit.
+     * @version 3.0
+     */
+    BRAIN_API explicit CompartmentReportGroup(const URIs& uris);
+    BRAIN_API ~CompartmentReportGroup();
+
+    BRAIN_API CompartmentReportGroup(CompartmentReportGroup&&);
+    BRAIN_API CompartmentReportGroup& operator=(CompartmentReportGroup&&);
+
+    /**
+     * @return the time base shared by the reports. The end time and frame
+     *         count are the ones of the shortest report, the data unit is
+     *         empty.
+     * @version 3.0
+     */
+    BRAIN_API const CompartmentReportMetaData& getMetaData() const;
+
+    /** @return the number of reports. @version 3.0 */
+    BRAIN_API size_t getSize() const;
+
+    /**
+     * @return a report of the group, in the order of the URIs
+     * @throw std::out_of_range if index >= getSize()
+     * @version 3.0
+     */
+    BRAIN_API CompartmentReport& getReport(size_t index);
+
+    /** @return the GIDs present in all the reports. @version 3.0 */
+    BRAIN_API const GIDSet& getGIDs() const;
+
+    /**
+     * Create the views of a subset of neurons in all the reports.
+     *
+     * The subset is resolved once for all the reports. Views of reports with
+     * the same layout share their mapping index.
+     *
+     * @param gids the neurons of interest, all the neurons present in all the
+     *        reports if empty
+     * @throw std::runtime_error if a GID is not in all the reports
+     * @version 3.0
+     */
+    BRAIN_API CompartmentReportGroupView createView(const GIDSet& gids);
+
+    /**
+     * Create the views of all the neurons present in all the reports.
+     *
+     * @version 3.0
+     */
+    BRAIN_API CompartmentReportGroupView createView();
+
+private:
+    CompartmentReportGroup(const CompartmentReportGroup&) = delete;
+    CompartmentReportGroup& operator=(const CompartmentReportGroup&) = delete;
+
+    std::unique_ptr<detail::CompartmentReportGroup> _impl;
+};
+
+/**
+ * Views of the same neurons in a group of compartment reports.
+ *
+ * The frames of all the reports are loaded for the same timestamps. The reads
+ * of the reports are issued together, so that they are served concurrently.
+ */
+class CompartmentReportGroupView
+{
+public:
+    BRAIN_API CompartmentReportGroupView(CompartmentReportGroupView&&);
+    BRAIN_API CompartmentReportGroupView& operator=(
+        CompartmentReportGroupView&&);
+    BRAIN_API ~CompartmentReportGroupView();
+
+    /** @return the considered GIDs. @version 3.0 */
+    BRAIN_API const GIDSet& getGIDs() const;
+
+    /** @return the number of views. @version 3.0 */
+    BRAIN_API size_t getSize() const;
+
+    /**
+     * @return the view of a report, in the order of the reports of the group
+     * @throw std::out_of_range if index >= getSize()
+     * @version 3.0
+     */
+    BRAIN_API CompartmentReportView& getView(size_t index);
+
+    /**
+     * Load the frames of all the reports at the given time stamp.
+     *
+     * @param timestamp the time stamp of interest
+     * @return a frame per report, in the order of the reports
+     * @throw std::logic_error if timestamp is outside of the shared time
+     *        range of the reports
+     * @version 3.0
+     */
+    BRAIN_API std::future<std::vector<brion::Frame>> load(double timestamp);
+
+    /**
+     * Load the frames of all the reports between start and end time stamps.
+     *
+     * @param start the start time stamp
+     * @param end the end time stamp
+     * @return the frames of each report overlapped by the given time window,
+     *         in the order of the reports. The time window is clamped to the
+     *         shared time range of the reports, so the frames of all the
+     *         reports have the same timestamps.
+     * @throw std::logic_error if invalid interval
+     * @version 3.0
+     */
+    BRAIN_API std::future<std::vector<brion::Frames>> load(double start,
+                                                           double end);
+
+    /**
+     * Load all the frames of the shared time range of the reports.
+     *
+     * @version 3.0
+     */
+    BRAIN_API std::future<std::vector<brion::Frames>> loadAll();
+
+private:
+    explicit CompartmentReportGroupView(
+        std::unique_ptr<detail::CompartmentReportGroupView> impl);
+
+    std::unique_ptr<detail::CompartmentReportGroupView> _impl;
+    friend class CompartmentReportGroup;
+};
+}
@@ -31,7 +31,7 @@ CompartmentReportMapping::CompartmentReportMapping(
 const CompartmentReportMapping::Index& CompartmentReportMapping::getIndex()
     const
 {
-    return _viewImpl->indices;
+    return *_viewImpl->indices;
 }
 
 const brion::SectionOffsets& CompartmentReportMapping::getOffsets() const
@@ -20,6 +20,8 @@
 #include "compartmentReportView.h"
 #include "detail/compartmentReport.h"
 
+#include <brion/detail/trace.h>
+
 namespace brain
 {
 namespace
@@ -40,6 +42,12 @@ CompartmentReportView::CompartmentReportView(
 {
 }
 
+CompartmentReportView::CompartmentReportView(
+    std::unique_ptr<detail::CompartmentReportView> impl)
+    : _impl(std::move(impl))
+{
+}
+
 CompartmentReportView::CompartmentReportView(CompartmentReportView&& other)
 {
     _impl = std::move(other._impl);
@@ -121,6 +129,7 @@ std::future<brion::Frames> CompartmentReportView::load(double start, double end,
     end = std::max(start + reportTimeStep * 0.5, end);
 
     auto task = [this, start, end, step] {
+        BRION_TRACE("CompartmentReportView::load", "report");
 
         brion::Frames frames;
         frames.timeStamps.reset(new brion::doubles);
@@ -141,11 +150,21 @@ std::future<brion::Frames> CompartmentReportView::load(double start, double end,
         return frames;
     };
 
-    return lunchbox::ThreadPool::getInstance().post(task);
+    return brion::Executor::getDefault()->post(task);
 }
 
 std::future<brion::Frames> CompartmentReportView::loadAll()
 {
     return load(_impl->report->getStartTime(), _impl->report->getEndTime());
 }
+
+IOStatistics CompartmentReportView::getIOStatistics() const
+{
+    return _impl->report->getIOStatistics();
+}
+
+void CompartmentReportView::resetIOStatistics()
+{
+    _impl->report->resetIOStatistics();
+}
 }
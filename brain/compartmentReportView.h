@@ -100,11 +100,26 @@ public:
      */
     BRAIN_API std::future<brion::Frames> loadAll();
 
+    /**
+     * @return the cumulative I/O counters of the report opened by this view.
+     * \if pybind
+     * @return A dictionary with the counters.
+     * \endif
+     * @version 3.0
+     */
+    BRAIN_API IOStatistics getIOStatistics() const;
+
+    /** Reset the I/O counters of this view. @version 3.0 */
+    BRAIN_API void resetIOStatistics();
+
 private:
     CompartmentReportView(
         const std::shared_ptr<detail::CompartmentReportReader>&,
         const brion::GIDSet& gids);
+    explicit CompartmentReportView(
+        std::unique_ptr<detail::CompartmentReportView> impl);
     std::unique_ptr<detail::CompartmentReportView> _impl;
     friend class CompartmentReport;
+    friend class CompartmentReportGroup;
 };
 }
@@ -29,6 +29,7 @@
 #include <brion/circuitConfig.h>
 #include <brion/csvConfig.h>
 #include <brion/detail/hdf5Mutex.h>
+#include <brion/detail/trace.h>
 #include <brion/morphology.h>
 #include <brion/nodes.h>
 #include <brion/synapse.h>
@@ -143,6 +144,31 @@ std::vector<bool> _getAttribute<bool>(const brion::NodeGroup& nodeGroup,
 using CachedMorphologies =
     std::unordered_map<std::string, neuron::MorphologyPtr>;
 using CachedSynapses = std::unordered_map<std::string, brion::SynapseMatrix>;
+
+#ifdef BRION_USE_KEYV
+// The cache configured for keyv, or a local file store named by
+// BRION_LOCAL_CACHE if there is none.
+keyv::MapPtr _createCache()
+{
+    keyv::MapPtr cache = keyv::Map::createCache();
+    const char* path = ::getenv("BRION_LOCAL_CACHE");
+    if (cache || !path || !*path)
+        return cache;
+
+    const brion::URI uri("local://" + fs::absolute(path).string());
+    try
+    {
+        cache.reset(new keyv::Map(uri));
+        LBINFO << "Using local cache " << uri << std::endl;
+    }
+    catch (const std::runtime_error& e)
+    {
+        LBWARN << "Cannot open local cache " << uri << ": " << e.what()
+               << std::endl;
+    }
+    return cache;
+}
+#endif
 } // namespace
 
 #ifdef BRION_USE_KEYV
@@ -192,6 +218,7 @@ public:
         CachedSynapses loaded;
         if (!_cache)
             return loaded;
+        BRION_TRACE("SynapseCache::loadPositions", "cache");
         LBDEBUG << "Using cache for synapses position loading" << std::endl;
         typedef std::future<std::pair<std::string, brion::SynapseMatrix>>
             Future;
@@ -319,6 +346,7 @@ public:
         if (!_cache)
             return loaded;
 
+        BRION_TRACE("MorphologyCache::load", "cache");
         LBDEBUG << "Using cache for morphology loading" << std::endl;
         typedef std::future<std::pair<std::string, neuron::MorphologyPtr>>
             Future;
@@ -733,7 +761,7 @@ public:
         , _synapseSource(config.getSynapseSource())
         , _targets(config)
 #ifdef BRION_USE_KEYV
-        , _cache(keyv::Map::createCache())
+        , _cache(_createCache())
         , _morphologyCache(_cache, config.getCircuitSource())
         , _synapseCache(_cache, _synapseSource)
 #endif
@@ -1031,7 +1059,7 @@ struct MVD3 : public BBPCircuit
         const ::MVD3::Range& range = _getRange(gids);
         try
         {
-            std::lock_guard<std::mutex> lock(brion::detail::hdf5Mutex());
+            brion::detail::HDF5Lock lock;
             HighFive::SilenceHDF5 silence;
             const ::MVD3::Positions& positions = _circuit.getPositions(range);
             _assign(range, gids, positions, results, _toVector3f);
@@ -1053,7 +1081,7 @@ struct MVD3 : public BBPCircuit
         const ::MVD3::Range& range = _getRange(gids);
         try
         {
-            std::lock_guard<std::mutex> lock(brion::detail::hdf5Mutex());
+            brion::detail::HDF5Lock lock;
             HighFive::SilenceHDF5 silence;
             const size_ts& mtypes = _circuit.getIndexMtypes(range);
             _assign(range, gids, mtypes, results, _nop<size_t>);
@@ -1068,7 +1096,7 @@ struct MVD3 : public BBPCircuit
 
     Strings getMorphologyTypeNames() const final
     {
-        std::lock_guard<std::mutex> lock(brion::detail::hdf5Mutex());
+        brion::detail::HDF5Lock lock;
         return _circuit.listAllMtypes();
     }
 
@@ -1081,7 +1109,7 @@ struct MVD3 : public BBPCircuit
         const ::MVD3::Range& range = _getRange(gids);
         try
         {
-            std::lock_guard<std::mutex> lock(brion::detail::hdf5Mutex());
+            brion::detail::HDF5Lock lock;
             HighFive::SilenceHDF5 silence;
             const size_ts& etypes = _circuit.getIndexEtypes(range);
             _assign(range, gids, etypes, results, _nop<size_t>);
@@ -1096,7 +1124,7 @@ struct MVD3 : public BBPCircuit
 
     Strings getElectrophysiologyTypeNames() const final
     {
-        std::lock_guard<std::mutex> lock(brion::detail::hdf5Mutex());
+        brion::detail::HDF5Lock lock;
         return _circuit.listAllEtypes();
     }
 
@@ -1109,7 +1137,7 @@ struct MVD3 : public BBPCircuit
         const ::MVD3::Range& range = _getRange(gids);
         try
         {
-            std::lock_guard<std::mutex> lock(brion::detail::hdf5Mutex());
+            brion::detail::HDF5Lock lock;
             HighFive::SilenceHDF5 silence;
             const ::MVD3::Rotations& rotations = _circuit.getRotations(range);
             _assign(range, gids, rotations, results, _toQuaternion);
@@ -1131,7 +1159,7 @@ struct MVD3 : public BBPCircuit
         const ::MVD3::Range& range = _getRange(gids);
         try
         {
-            std::lock_guard<std::mutex> lock(brion::detail::hdf5Mutex());
+            brion::detail::HDF5Lock lock;
             HighFive::SilenceHDF5 silence;
             const Strings& morphos = _circuit.getMorphologies(range);
             _assign(range, gids, morphos, results, _nop<std::string>);
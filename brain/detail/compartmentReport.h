@@ -22,8 +22,8 @@
 #include "../compartmentReport.h"
 #include "../compartmentReportMapping.h"
 #include "brion/compartmentReport.h"
+#include "brion/executor.h"
 
-#include <lunchbox/threadPool.h>
 #include <lunchbox/types.h>
 
 namespace brain
@@ -57,18 +57,31 @@ struct CompartmentReportView
     CompartmentReportView(
         const std::shared_ptr<CompartmentReportReader>& readerImpl_,
         const brion::GIDSet& gids)
-        : report(std::make_shared<brion::CompartmentReport>(readerImpl_->uri,
-                                                            brion::MODE_READ,
-                                                            gids))
+        : CompartmentReportView(readerImpl_,
+                                std::make_shared<brion::CompartmentReport>(
+                                    readerImpl_->uri, brion::MODE_READ, gids),
+                                nullptr)
+    {
+    }
+
+    // Shares the index of a view of a report with the same layout, if any
+    CompartmentReportView(
+        const std::shared_ptr<CompartmentReportReader>& readerImpl_,
+        const std::shared_ptr<brion::CompartmentReport>& report_,
+        const CompartmentReportView* sameLayout)
+        : report(report_)
         , readerImpl{readerImpl_}
     {
-        _initIndices();
+        if (sameLayout)
+            indices = sameLayout->indices;
+        else
+            _initIndices();
     }
 
     std::shared_ptr<brion::CompartmentReport> report;
     std::shared_ptr<CompartmentReportReader> readerImpl;
     brain::CompartmentReportMapping mapping{this};
-    brain::CompartmentReportMapping::Index indices;
+    std::shared_ptr<const brain::CompartmentReportMapping::Index> indices;
 
 private:
     inline void _initIndices();
@@ -76,7 +89,8 @@ private:
 
 void CompartmentReportView::_initIndices()
 {
-    indices.resize(report->getFrameSize());
+    auto index = std::make_shared<brain::CompartmentReportMapping::Index>(
+        report->getFrameSize());
 
     const auto& gids = report->getGIDs();
     const std::vector<uint32_t> gidList(report->getGIDs().begin(),
@@ -96,12 +110,13 @@ void CompartmentReportView::_initIndices()
             const auto count = compartments[section];
             for (size_t k = 0; k != count; ++k)
             {
-                indices[offset + k].gid = gid;
-                indices[offset + k].section = section;
+                (*index)[offset + k].gid = gid;
+                (*index)[offset + k].section = section;
             }
         }
         ++i;
     }
+    indices = index;
 }
 }
 } // namespaces
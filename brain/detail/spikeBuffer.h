@@ -0,0 +1,131 @@
+/* Copyright (c) 2018, EPFL/Blue Brain Project
+ *
+ * This file is part of Brion <https://github.com/BlueBrain/Brion>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#pragma once
+
+#include <brain/types.h>
+
+#include <lunchbox/log.h>
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <limits>
+
+namespace brain
+{
+namespace detail
+{
+/**
+ * The spikes received from a stream report, in blocks sorted by time.
+ *
+ * The oldest blocks are discarded once they are older than the time horizon
+ * before the latest spike or once the spikes use more than the byte budget.
+ * The latest block is always kept.
+ */
+class SpikeBuffer
+{
+public:
+    /** Change the retention policy, discarding the spikes outside of it. */
+    void setRetention(const float horizon, const size_t maxBytes)
+    {
+        if (!(horizon > 0))
+            LBTHROW(std::logic_error("Retention horizon must be positive"));
+        _horizon = horizon;
+        _maxBytes = maxBytes;
+        _trim();
+    }
+
+    /** Append spikes sorted by time, after the ones already added. */
+    void append(const Spikes& spikes)
+    {
+        if (spikes.empty())
+            return;
+
+        // Small reads are merged to keep the number of blocks low
+        if (_blocks.empty() || _blocks.back().size() >= _blockSize)
+            _blocks.emplace_back();
+        auto& block = _blocks.back();
+        block.insert(block.end(), spikes.begin(), spikes.end());
+        _size += spikes.size();
+        _trim();
+    }
+
+    /**
+     * @return the spikes in [start, end)
+     * @throw std::runtime_error if spikes after start have been discarded
+     */
+    Spikes getSpikes(const float start, const float end) const
+    {
+        if (start < _start)
+            LBTHROW(std::runtime_error(
+                "Can't get spikes from " + std::to_string(start) +
+                ": spikes before " + std::to_string(_start) +
+                " have been discarded by the retention policy"));
+
+        Spikes spikes;
+        const auto last = [](const Spikes& block, const float time) {
+            return block.back().first < time;
+        };
+        for (auto i = std::lower_bound(_blocks.begin(), _blocks.end(), start,
+                                       last);
+             i != _blocks.end() && i->front().first < end; ++i)
+        {
+            spikes.insert(spikes.end(),
+                          std::lower_bound(i->begin(), i->end(), start, _byTime),
+                          std::lower_bound(i->begin(), i->end(), end, _byTime));
+        }
+        return spikes;
+    }
+
+private:
+    // Spikes per block, the granularity at which spikes are discarded
+    static constexpr size_t _blockSize = 1 << 16;
+
+    std::deque<Spikes> _blocks;
+    size_t _size = 0; // number of spikes in all blocks
+    float _horizon = std::numeric_limits<float>::infinity();
+    size_t _maxBytes = 0;
+    // The time from which all the spikes received are available
+    float _start = -std::numeric_limits<float>::infinity();
+
+    static bool _byTime(const Spike& spike, const float time)
+    {
+        return spike.first < time;
+    }
+
+    void _trim()
+    {
+        if (_blocks.empty())
+            return;
+        const float oldest = _blocks.back().back().first - _horizon;
+        while (_blocks.size() > 1 &&
+               (_blocks.front().back().first < oldest ||
+                (_maxBytes != 0 && _size * sizeof(Spike) > _maxBytes)))
+        {
+            // Spikes at the time of the last discarded one may be left in
+            // the next block, so that time is not available any more
+            _start = std::nextafter(_blocks.front().back().first,
+                                    std::numeric_limits<float>::infinity());
+            _size -= _blocks.front().size();
+            _blocks.pop_front();
+        }
+    }
+};
+}
+}
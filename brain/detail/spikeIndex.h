@@ -0,0 +1,320 @@
+/* Copyright (c) 2018, EPFL/Blue Brain Project
+ *
+ * This file is part of Brion <https://github.com/BlueBrain/Brion>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#pragma once
+
+#include <brain/types.h>
+
+#include <brion/executor.h>
+
+#include <lunchbox/log.h>
+
+#include <algorithm>
+#include <bitset>
+#include <cstring>
+#include <fstream>
+
+namespace brain
+{
+namespace detail
+{
+/**
+ * Spike times grouped by cell, in compressed sparse row layout: the times of
+ * gids[i] are times[offsets[i]] to times[offsets[i + 1]], in ascending order.
+ */
+class SpikeIndex
+{
+public:
+    /** The report and subset of cells an index was built from. */
+    struct Source
+    {
+        std::string path;
+        uint64_t size = 0;
+        int64_t time = 0;
+        uint64_t subsetHash = 0;
+
+        bool operator==(const Source& other) const
+        {
+            return path == other.path && size == other.size &&
+                   time == other.time && subsetHash == other.subsetHash;
+        }
+    };
+
+    /** @return the FNV-1a hash of a subset of cells, 0 if empty. */
+    static uint64_t hashSubset(const GIDSet& gids)
+    {
+        if (gids.empty())
+            return 0;
+        uint64_t hash = 14695981039346656037ull;
+        for (const uint32_t gid : gids)
+        {
+            for (size_t i = 0; i < sizeof(gid); ++i)
+            {
+                hash ^= (gid >> (i * 8)) & 0xff;
+                hash *= 1099511628211ull;
+            }
+        }
+        return hash;
+    }
+
+    /** Build the index from spikes sorted by time. */
+    explicit SpikeIndex(const Spikes& spikes)
+    {
+        if (spikes.empty())
+        {
+            _offsets.push_back(0);
+            return;
+        }
+
+        // Rank the distinct GIDs with a bitmap over their range, or by
+        // binary search if the range is too sparse for a bitmap.
+        uint32_t minGID = spikes[0].second;
+        uint32_t maxGID = minGID;
+        for (const auto& spike : spikes)
+        {
+            minGID = std::min(minGID, spike.second);
+            maxGID = std::max(maxGID, spike.second);
+        }
+        const size_t numWords = (size_t(maxGID - minGID) >> 6) + 1;
+        const bool dense = numWords <= spikes.size();
+        std::vector<uint64_t> bits;
+        std::vector<uint32_t> ranks;
+        if (dense)
+        {
+            bits.resize(numWords, 0);
+            for (const auto& spike : spikes)
+            {
+                const uint32_t i = spike.second - minGID;
+                bits[i >> 6] |= uint64_t(1) << (i & 63);
+            }
+            ranks.resize(numWords);
+            uint32_t rank = 0;
+            for (size_t w = 0; w < numWords; ++w)
+            {
+                ranks[w] = rank;
+                for (uint64_t word = bits[w]; word; word &= word - 1)
+                {
+                    const uint64_t lowest = word & (~word + 1);
+                    _gids.push_back(minGID +
+                                    uint32_t(w * 64 + _count(lowest - 1)));
+                }
+                rank += _count(bits[w]);
+            }
+        }
+        else
+        {
+            _gids.reserve(spikes.size());
+            for (const auto& spike : spikes)
+                _gids.push_back(spike.second);
+            std::sort(_gids.begin(), _gids.end());
+            _gids.erase(std::unique(_gids.begin(), _gids.end()), _gids.end());
+        }
+        const auto key = [&](const uint32_t gid) -> size_t {
+            if (!dense)
+                return std::lower_bound(_gids.begin(), _gids.end(), gid) -
+                       _gids.begin();
+            const uint32_t i = gid - minGID;
+            return ranks[i >> 6] +
+                   _count(bits[i >> 6] & ((uint64_t(1) << (i & 63)) - 1));
+        };
+
+        // Parallel counting sort. Each task counts the spikes per cell in
+        // its chunk, then scatters them after the spikes of the previous
+        // chunks, which keeps the times of each cell sorted. The number of
+        // tasks is limited to keep the counters smaller than the spikes.
+        const size_t numCells = _gids.size();
+        const size_t numChunks = std::max(
+            size_t(1),
+            std::min(brion::Executor::getDefault()->getSize(),
+                     spikes.size() / (numCells * 4)));
+        std::vector<std::vector<uint64_t>> counts(numChunks);
+        const auto chunkBegin = [&](const size_t chunk) {
+            return spikes.size() * chunk / numChunks;
+        };
+        _parallel(numChunks, [&](const size_t chunk) {
+            auto& count = counts[chunk];
+            count.resize(numCells, 0);
+            for (size_t i = chunkBegin(chunk); i < chunkBegin(chunk + 1); ++i)
+                ++count[key(spikes[i].second)];
+        });
+
+        // Turn the counts into the write position of each chunk and cell
+        _offsets.resize(numCells + 1);
+        uint64_t offset = 0;
+        for (size_t cell = 0; cell < numCells; ++cell)
+        {
+            _offsets[cell] = offset;
+            for (auto& count : counts)
+            {
+                const uint64_t size = count[cell];
+                count[cell] = offset;
+                offset += size;
+            }
+        }
+        _offsets[numCells] = offset;
+
+        _times.resize(spikes.size());
+        _parallel(numChunks, [&](const size_t chunk) {
+            auto& position = counts[chunk];
+            for (size_t i = chunkBegin(chunk); i < chunkBegin(chunk + 1); ++i)
+                _times[position[key(spikes[i].second)]++] = spikes[i].first;
+        });
+    }
+
+    /**
+     * Load an index saved with save().
+     * @throw std::runtime_error on error or if the index was not built from
+     *        the given source
+     */
+    SpikeIndex(const std::string& filename, const Source& source)
+    {
+        std::ifstream file(filename, std::ios::binary);
+        Header header;
+        file.read(reinterpret_cast<char*>(&header), sizeof(header));
+        if (!file ||
+            std::memcmp(header.magic, Header().magic, sizeof(header.magic)) ||
+            header.version != Header().version)
+        {
+            LBTHROW(std::runtime_error("Invalid spike index " + filename));
+        }
+
+        Source saved;
+        saved.path.resize(header.pathSize);
+        file.read(&saved.path[0], saved.path.size());
+        saved.size = header.reportSize;
+        saved.time = header.reportTime;
+        saved.subsetHash = header.subsetHash;
+        if (!file)
+            LBTHROW(std::runtime_error("Invalid spike index " + filename));
+        if (!(saved == source))
+            LBTHROW(std::runtime_error("Spike index " + filename +
+                                       " was built from another report "
+                                       "or subset of cells"));
+
+        _gids.resize(header.numCells);
+        _offsets.resize(header.numCells + 1);
+        _times.resize(header.numSpikes);
+        _read(file, _gids);
+        _read(file, _offsets);
+        _read(file, _times);
+        if (!file || _offsets.back() != header.numSpikes)
+            LBTHROW(std::runtime_error("Invalid spike index " + filename));
+    }
+
+    /**
+     * Save the index built from the given source to a file.
+     * @throw std::runtime_error on error
+     */
+    void save(const std::string& filename, const Source& source) const
+    {
+        std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+        Header header;
+        header.numCells = _gids.size();
+        header.numSpikes = _times.size();
+        header.reportSize = source.size;
+        header.reportTime = source.time;
+        header.subsetHash = source.subsetHash;
+        header.pathSize = source.path.size();
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(source.path.data(), source.path.size());
+        _write(file, _gids);
+        _write(file, _offsets);
+        _write(file, _times);
+        if (!file)
+            LBTHROW(std::runtime_error("Cannot write spike index " +
+                                       filename));
+    }
+
+    /** @return the spikes of the given cells in [start, end), sorted by time */
+    Spikes getSpikes(const GIDSet& gids, const float start,
+                     const float end) const
+    {
+        Spikes spikes;
+        for (const uint32_t gid : gids)
+        {
+            const auto i = std::lower_bound(_gids.begin(), _gids.end(), gid);
+            if (i == _gids.end() || *i != gid)
+                continue;
+
+            const size_t cell = i - _gids.begin();
+            const float* times = _times.data();
+            const float* first = std::lower_bound(times + _offsets[cell],
+                                                  times + _offsets[cell + 1],
+                                                  start);
+            const float* last =
+                std::lower_bound(first, times + _offsets[cell + 1], end);
+            for (; first != last; ++first)
+                spikes.emplace_back(*first, gid);
+        }
+        std::sort(spikes.begin(), spikes.end());
+        return spikes;
+    }
+
+private:
+    struct Header
+    {
+        char magic[8] = {'B', 'R', 'N', 'S', 'P', 'I', 'D', 'X'};
+        uint64_t version = 2;
+        uint64_t numCells = 0;
+        uint64_t numSpikes = 0;
+        uint64_t reportSize = 0;
+        int64_t reportTime = 0;
+        uint64_t subsetHash = 0;
+        uint64_t pathSize = 0; // followed by the path of the report
+    };
+
+    uint32_ts _gids;
+    std::vector<uint64_t> _offsets;
+    floats _times;
+
+    static uint32_t _count(const uint64_t bits)
+    {
+        return uint32_t(std::bitset<64>(bits).count());
+    }
+
+    template <typename F>
+    static void _parallel(const size_t numTasks, const F& task)
+    {
+        auto executor = brion::Executor::getDefault();
+        std::vector<std::future<void>> tasks;
+        for (size_t i = 0; i < numTasks; ++i)
+            tasks.push_back(executor->post([&task, i] { task(i); },
+                                           brion::Executor::Priority::bulk));
+        // The tasks refer to the caller's stack, wait for all of them before
+        // rethrowing the first exception
+        for (auto& future : tasks)
+            future.wait();
+        for (auto& future : tasks)
+            future.get();
+    }
+
+    template <typename T>
+    static void _read(std::istream& in, std::vector<T>& data)
+    {
+        in.read(reinterpret_cast<char*>(data.data()), data.size() * sizeof(T));
+    }
+
+    template <typename T>
+    static void _write(std::ostream& out, const std::vector<T>& data)
+    {
+        out.write(reinterpret_cast<const char*>(data.data()),
+                  data.size() * sizeof(T));
+    }
+};
+}
+}
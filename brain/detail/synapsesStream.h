@@ -21,8 +21,12 @@
 #define BRAIN_DETAIL_SYNAPSESSTREAM
 
 #include <brain/circuit.h>
+#include <brion/detail/trace.h>
+#include <brion/executor.h>
 
+#include <condition_variable>
 #include <future>
+#include <mutex>
 
 namespace brain
 {
@@ -62,6 +66,14 @@ struct SynapsesStream
     {
     }
 
+    /** Wait for the reads still queued on the executor, they refer to the
+        GIDs and filters of this stream. */
+    ~SynapsesStream()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _done.wait(lock, [this] { return _pending == 0; });
+    }
+
     const Circuit& _circuit;
     const bool _afferent;
     const GIDSet _gids;
@@ -71,6 +83,25 @@ struct SynapsesStream
     const SynapsePrefetch _prefetch;
     GIDSet::const_iterator _it;
 
+    std::mutex _mutex;
+    std::condition_variable _done;
+    size_t _pending = 0;
+
+    struct PendingRead
+    {
+        explicit PendingRead(SynapsesStream& stream)
+            : _stream(stream)
+        {
+        }
+        ~PendingRead()
+        {
+            std::lock_guard<std::mutex> lock(_stream._mutex);
+            if (--_stream._pending == 0)
+                _stream._done.notify_all();
+        }
+        SynapsesStream& _stream;
+    };
+
     size_t getRemaining() const
     {
         return size_t(std::abs(std::distance(_it, _gids.end())));
@@ -83,17 +114,30 @@ struct SynapsesStream
         std::advance(_it, count);
         GIDSet::const_iterator end = _it;
 
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            ++_pending;
+        }
+        auto executor = brion::Executor::getDefault();
         if (_externalSource.empty())
         {
-            return std::async(std::launch::async, [&, start, end] {
-                return Synapses(_circuit, GIDSet(start, end), _filterGIDs,
-                                _afferent, _prefetch);
-            });
+            return executor->post(
+                [this, start, end] {
+                    const PendingRead pending(*this);
+                    BRION_TRACE("SynapsesStream::read", "synapse");
+                    return Synapses(_circuit, GIDSet(start, end), _filterGIDs,
+                                    _afferent, _prefetch);
+                },
+                brion::Executor::Priority::bulk);
         }
-        return std::async(std::launch::async, [&, start, end] {
-            return Synapses(_circuit, GIDSet(start, end), _externalSource,
-                            _prefetch);
-        });
+        return executor->post(
+            [this, start, end] {
+                const PendingRead pending(*this);
+                BRION_TRACE("SynapsesStream::read", "synapse");
+                return Synapses(_circuit, GIDSet(start, end), _externalSource,
+                                _prefetch);
+            },
+            brion::Executor::Priority::bulk);
     }
 };
 }
@@ -38,6 +38,7 @@ void export_Simulation();
 void export_Spikes();
 void export_SpikeReportReader();
 void export_SpikeReportWriter();
+void export_SpikeStatistics();
 void export_Synapses();
 void export_test();
 void export_CompartmentReport();
@@ -109,5 +110,6 @@ BOOST_PYTHON_MODULE(_brain)
     brain::export_Spikes();
     brain::export_SpikeReportReader();
     brain::export_SpikeReportWriter();
+    brain::export_SpikeStatistics();
     brain::export_Synapses();
 }
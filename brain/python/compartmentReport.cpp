@@ -23,7 +23,10 @@
 #include "helpers.h"
 
 #include <brain/compartmentReport.h>
+#include <brain/compartmentReportGroup.h>
 #include <brain/compartmentReportMapping.h>
+#include <brain/spikeReportReader.h>
+#include <brain/spikeTriggeredFrames.h>
 
 #include <brain/types.h>
 
@@ -36,6 +39,9 @@ namespace brain
 using namespace brain_python;
 
 typedef boost::shared_ptr<CompartmentReportView> CompartmentReportViewPtr;
+typedef std::shared_ptr<CompartmentReportGroup> CompartmentReportGroupPtr;
+typedef boost::shared_ptr<CompartmentReportGroupView>
+    CompartmentReportGroupViewPtr;
 
 // This proxy object is needed because when converting C++ vectors to numpy
 // arrays we need a shared_ptr to act as a custodian. As
@@ -88,10 +94,8 @@ CompartmentReportViewPtr CompartmentReport_createView(CompartmentReport& reader,
     return CompartmentReportViewPtr(new CompartmentReportView(std::move(view)));
 }
 
-bp::object CompartmentReport_getMetaData(const CompartmentReport& reader)
+bp::object metaDataToDict(const CompartmentReportMetaData& md)
 {
-    const CompartmentReportMetaData& md = reader.getMetaData();
-
     bp::dict dict;
     dict["start_time"] = md.startTime;
     dict["end_time"] = md.endTime;
@@ -103,6 +107,11 @@ bp::object CompartmentReport_getMetaData(const CompartmentReport& reader)
     return dict;
 }
 
+bp::object CompartmentReport_getMetaData(const CompartmentReport& reader)
+{
+    return metaDataToDict(reader.getMetaData());
+}
+
 bp::object CompartmentReport_getGids(const CompartmentReport& report)
 {
     return toNumpy(toVector(report.getGIDs()));
@@ -143,6 +152,12 @@ bp::object CompartmentReportView_loadAll(CompartmentReportView& view)
     return framesToTuple(view.loadAll().get());
 }
 
+bp::object CompartmentReportView_getIOStatistics(
+    const CompartmentReportView& view)
+{
+    return toPythonDict(view.getIOStatistics());
+}
+
 bp::object CompartmentReportMapping_getIndex(
     const CompartmentReportMappingProxy& mapping)
 {
@@ -176,6 +191,92 @@ bp::object CompartmentReportMapping_getCompartmentCounts(
     return result;
 }
 
+CompartmentReportGroupPtr CompartmentReportGroup_initURIs(bp::object uris)
+{
+    brion::URIs result;
+    for (const auto& uri :
+         vectorFromIterable<std::string>(uris, "Expected a list of URIs"))
+    {
+        result.push_back(brion::URI(uri));
+    }
+    return std::make_shared<CompartmentReportGroup>(result);
+}
+
+bp::object CompartmentReportGroup_getMetaData(
+    const CompartmentReportGroup& group)
+{
+    return metaDataToDict(group.getMetaData());
+}
+
+bp::object CompartmentReportGroup_getGids(const CompartmentReportGroup& group)
+{
+    return toNumpy(toVector(group.getGIDs()));
+}
+
+CompartmentReportGroupViewPtr CompartmentReportGroup_createViewEmptyGIDs(
+    CompartmentReportGroup& group)
+{
+    auto view = group.createView();
+    return CompartmentReportGroupViewPtr(
+        new CompartmentReportGroupView(std::move(view)));
+}
+
+CompartmentReportGroupViewPtr CompartmentReportGroup_createView(
+    CompartmentReportGroup& group, bp::object gids)
+{
+    auto view = group.createView(gidsFromPython(gids));
+    return CompartmentReportGroupViewPtr(
+        new CompartmentReportGroupView(std::move(view)));
+}
+
+bp::object CompartmentReportGroupView_getGids(
+    const CompartmentReportGroupView& view)
+{
+    return toNumpy(toVector(view.getGIDs()));
+}
+
+bp::object CompartmentReportGroupView_loadAt(CompartmentReportGroupView& view,
+                                             const double time)
+{
+    bp::list result;
+    for (auto& frame : view.load(time).get())
+        result.append(frameToTuple(std::move(frame)));
+    return result;
+}
+
+bp::object CompartmentReportGroupView_load(CompartmentReportGroupView& view,
+                                           const double start,
+                                           const double end)
+{
+    bp::list result;
+    for (auto& frames : view.load(start, end).get())
+        result.append(framesToTuple(std::move(frames)));
+    return result;
+}
+
+bp::object CompartmentReportGroupView_loadAll(CompartmentReportGroupView& view)
+{
+    bp::list result;
+    for (auto& frames : view.loadAll().get())
+        result.append(framesToTuple(std::move(frames)));
+    return result;
+}
+
+bp::object loadSpikeTriggeredFrames_(SpikeReportReader& reader, bp::object gids,
+                                     const float start, const float end,
+                                     CompartmentReportView& view,
+                                     const double before, const double after)
+{
+    auto result = loadSpikeTriggeredFrames(reader, gidsFromPython(gids), start,
+                                           end, view, before, after);
+    const auto shape = bp::make_tuple(result.spikes.size(), result.numFrames,
+                                      result.frameSize);
+    return bp::make_tuple(toNumpy(std::move(result.spikes)),
+                          toNumpy(std::move(result.startTimes)),
+                          toNumpy(std::move(result.data)).attr("reshape")(
+                              shape));
+}
+
 void export_CompartmentReport()
 // clang-format off
 {
@@ -226,7 +327,56 @@ bp::class_<CompartmentReportView, CompartmentReportViewPtr, boost::noncopyable>(
          (selfarg, bp::arg("start"), bp::arg("end"), bp::arg("stride")),
          DOXY_FN(brain::CompartmentReportView::load(double,double,double)))
     .def("load_all", CompartmentReportView_loadAll, (selfarg),
-         DOXY_FN(brain::CompartmentReportView::loadAll));
+         DOXY_FN(brain::CompartmentReportView::loadAll))
+    .def("io_statistics", CompartmentReportView_getIOStatistics, (selfarg),
+         DOXY_FN(brain::CompartmentReportView::getIOStatistics))
+    .def("reset_io_statistics", &CompartmentReportView::resetIOStatistics,
+         DOXY_FN(brain::CompartmentReportView::resetIOStatistics));
+
+bp::class_<CompartmentReportGroup, boost::noncopyable,
+           CompartmentReportGroupPtr>("CompartmentReportGroup", bp::no_init)
+    .def("__init__", bp::make_constructor(CompartmentReportGroup_initURIs),
+         DOXY_FN(brain::CompartmentReportGroup::CompartmentReportGroup))
+    .add_property("metadata", CompartmentReportGroup_getMetaData,
+                  DOXY_FN(brain::CompartmentReportGroup::getMetaData))
+    .add_property("gids", CompartmentReportGroup_getGids,
+                  DOXY_FN(brain::CompartmentReportGroup::getGIDs))
+    .def("__len__", &CompartmentReportGroup::getSize,
+         DOXY_FN(brain::CompartmentReportGroup::getSize))
+    .def("report", &CompartmentReportGroup::getReport,
+         (selfarg, bp::arg("index")),
+         bp::return_internal_reference<>(),
+         DOXY_FN(brain::CompartmentReportGroup::getReport))
+    .def("create_view", CompartmentReportGroup_createView,
+         (selfarg, bp::arg("gids")),
+         DOXY_FN(brain::CompartmentReportGroup::createView(const GIDSet&)))
+    .def("create_view", CompartmentReportGroup_createViewEmptyGIDs, (selfarg),
+         DOXY_FN(brain::CompartmentReportGroup::createView()));
+
+bp::class_<CompartmentReportGroupView, CompartmentReportGroupViewPtr,
+           boost::noncopyable>("CompartmentReportGroupView", bp::no_init)
+    .add_property("gids", CompartmentReportGroupView_getGids,
+                  DOXY_FN(brain::CompartmentReportGroupView::getGIDs))
+    .def("__len__", &CompartmentReportGroupView::getSize,
+         DOXY_FN(brain::CompartmentReportGroupView::getSize))
+    .def("view", &CompartmentReportGroupView::getView,
+         (selfarg, bp::arg("index")),
+         bp::return_internal_reference<>(),
+         DOXY_FN(brain::CompartmentReportGroupView::getView))
+    .def("load", CompartmentReportGroupView_loadAt,
+         (selfarg, bp::arg("time")),
+         DOXY_FN(brain::CompartmentReportGroupView::load(double)))
+    .def("load", CompartmentReportGroupView_load,
+         (selfarg, bp::arg("start"), bp::arg("end")),
+         DOXY_FN(brain::CompartmentReportGroupView::load(double,double)))
+    .def("load_all", CompartmentReportGroupView_loadAll, (selfarg),
+         DOXY_FN(brain::CompartmentReportGroupView::loadAll));
+
+bp::def("load_spike_triggered_frames", loadSpikeTriggeredFrames_,
+        (bp::arg("reader"), bp::arg("gids"), bp::arg("start_time"),
+         bp::arg("stop_time"), bp::arg("view"), bp::arg("before"),
+         bp::arg("after")),
+        DOXY_FN(brain::loadSpikeTriggeredFrames));
 }
 // clang-format on
 }
@@ -63,6 +63,19 @@ inline brain::uint32_ts toVector(const brain::GIDSet& gids)
     return brain::uint32_ts(gids.begin(), gids.end());
 }
 
+inline boost::python::dict toPythonDict(const brain::IOStatistics& stats)
+{
+    boost::python::dict dict;
+    dict["bytes_requested"] = stats.bytesRequested;
+    dict["bytes_read"] = stats.bytesRead;
+    dict["read_operations"] = stats.readOperations;
+    dict["cache_hits"] = stats.cacheHits;
+    dict["cache_misses"] = stats.cacheMisses;
+    dict["lock_wait_time"] = stats.lockWaitTime;
+    dict["decode_time"] = stats.decodeTime;
+    return dict;
+}
+
 inline boost::python::object toPythonSet(const brain::GIDSet& ids)
 {
     boost::python::object set(boost::python::handle<>(PySet_New(0)));
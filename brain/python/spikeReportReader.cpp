@@ -51,6 +51,28 @@ bp::object SpikeReportReader_getSpikes(SpikeReportReader& reader,
 {
     return toNumpy(reader.getSpikes(startTime, endTime));
 }
+
+bp::object SpikeReportReader_getCellSpikes(SpikeReportReader& reader,
+                                           bp::object gids,
+                                           const float startTime,
+                                           const float endTime)
+{
+    return toNumpy(
+        reader.getSpikes(gidsFromPython(gids), startTime, endTime));
+}
+
+bp::object SpikeReportReader_getSpikesView(const SpikeReportReaderPtr& reader,
+                                           const float startTime,
+                                           const float endTime)
+{
+    const auto view = reader->getSpikesView(startTime, endTime);
+    return toNumpy(view.data, view.size, reader);
+}
+
+bp::object SpikeReportReader_getIOStatistics(const SpikeReportReader& reader)
+{
+    return toPythonDict(reader.getIOStatistics());
+}
 }
 
 void export_SpikeReportReader()
@@ -68,11 +90,31 @@ bp::class_<SpikeReportReader, boost::noncopyable, SpikeReportReaderPtr>(
          DOXY_FN(brain::SpikeReportReader::close))
     .def("get_spikes", SpikeReportReader_getSpikes,
          (selfarg, bp::arg("start_time"), bp::arg("stop_time")),
-         DOXY_FN(brain::SpikeReportReader::getSpikes))
+         DOXY_FN(brain::SpikeReportReader::getSpikes(const float, const float)))
+    .def("get_spikes", SpikeReportReader_getCellSpikes,
+         (selfarg, bp::arg("gids"), bp::arg("start_time"),
+          bp::arg("stop_time")),
+         DOXY_FN(brain::SpikeReportReader::getSpikes(const GIDSet&, float, float)))
+    .def("get_spikes_view", SpikeReportReader_getSpikesView,
+         (selfarg, bp::arg("start_time"), bp::arg("stop_time")),
+         DOXY_FN(brain::SpikeReportReader::getSpikesView))
+    .add_property("supports_spikes_view",
+                  &SpikeReportReader::supportsSpikesView,
+                  DOXY_FN(brain::SpikeReportReader::supportsSpikesView))
+    .def("build_index", &SpikeReportReader::buildIndex,
+         (selfarg, bp::arg("cache_file") = std::string()),
+         DOXY_FN(brain::SpikeReportReader::buildIndex))
+    .def("set_retention", &SpikeReportReader::setRetention,
+         (selfarg, bp::arg("horizon"), bp::arg("max_bytes") = 0),
+         DOXY_FN(brain::SpikeReportReader::setRetention))
     .add_property("end_time", &SpikeReportReader::getEndTime,
                   DOXY_FN(brain::SpikeReportReader::getEndTime))
     .add_property("has_ended", &SpikeReportReader::hasEnded,
-                  DOXY_FN(brain::SpikeReportReader::hasEnded));
+                  DOXY_FN(brain::SpikeReportReader::hasEnded))
+    .def("io_statistics", SpikeReportReader_getIOStatistics, (selfarg),
+         DOXY_FN(brain::SpikeReportReader::getIOStatistics))
+    .def("reset_io_statistics", &SpikeReportReader::resetIOStatistics,
+         DOXY_FN(brain::SpikeReportReader::resetIOStatistics));
     // clang-format on
 }
 }
@@ -0,0 +1,110 @@
+/* Copyright (c) 2018, EPFL/Blue Brain Project
+ *
+ * This file is part of Brion <https://github.com/BlueBrain/Brion>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <boost/python.hpp>
+
+#include "arrayHelpers.h"
+#include "docstrings.h"
+#include "helpers.h"
+
+#include <brain/spikeReportReader.h>
+#include <brain/spikeStatistics.h>
+
+namespace bp = boost::python;
+
+namespace brain
+{
+namespace
+{
+using namespace brain_python;
+
+std::vector<GIDSet> _groupsFromPython(const bp::object& groups)
+{
+    std::vector<GIDSet> result;
+    bp::stl_input_iterator<bp::object> i(groups), end;
+    for (; i != end; ++i)
+        result.push_back(gidsFromPython(*i));
+    return result;
+}
+
+template <typename T>
+bp::list _toPythonList(std::vector<std::vector<T>>&& arrays)
+{
+    bp::list result;
+    for (auto& array : arrays)
+        result.append(toNumpy(std::move(array)));
+    return result;
+}
+
+bp::object computeSpikeCounts(SpikeReportReader& reader, bp::object groups,
+                              const float start, const float end,
+                              const float binSize)
+{
+    return _toPythonList(
+        spikeStatistics::computeSpikeCounts(reader, _groupsFromPython(groups),
+                                            start, end, binSize));
+}
+
+bp::object computePopulationRates(SpikeReportReader& reader,
+                                  bp::object groups, const float start,
+                                  const float end, const float binSize)
+{
+    return _toPythonList(spikeStatistics::computePopulationRates(
+        reader, _groupsFromPython(groups), start, end, binSize));
+}
+
+bp::object computeFiringRates(SpikeReportReader& reader, bp::object gids,
+                              const float start, const float end)
+{
+    return toNumpy(spikeStatistics::computeFiringRates(
+        reader, gidsFromPython(gids), start, end));
+}
+
+bp::object computePSTH(SpikeReportReader& reader, bp::object gids,
+                       bp::object stimuli, const float before,
+                       const float after, const float binSize)
+{
+    const auto times =
+        vectorFromIterable<float>(stimuli, "Cannot convert stimuli to floats");
+    return toNumpy(spikeStatistics::computePSTH(
+        reader, gidsFromPython(gids), times, before, after, binSize));
+}
+}
+
+void export_SpikeStatistics()
+{
+    // clang-format off
+bp::def("compute_spike_counts", computeSpikeCounts,
+        (bp::arg("reader"), bp::arg("groups"), bp::arg("start_time"),
+         bp::arg("stop_time"), bp::arg("bin_size")),
+        DOXY_FN(brain::spikeStatistics::computeSpikeCounts));
+bp::def("compute_population_rates", computePopulationRates,
+        (bp::arg("reader"), bp::arg("groups"), bp::arg("start_time"),
+         bp::arg("stop_time"), bp::arg("bin_size")),
+        DOXY_FN(brain::spikeStatistics::computePopulationRates));
+bp::def("compute_firing_rates", computeFiringRates,
+        (bp::arg("reader"), bp::arg("gids"), bp::arg("start_time"),
+         bp::arg("stop_time")),
+        DOXY_FN(brain::spikeStatistics::computeFiringRates));
+bp::def("compute_psth", computePSTH,
+        (bp::arg("reader"), bp::arg("gids"), bp::arg("stimuli"),
+         bp::arg("before"), bp::arg("after"), bp::arg("bin_size")),
+        DOXY_FN(brain::spikeStatistics::computePSTH));
+    // clang-format on
+}
+}
@@ -18,11 +18,15 @@
  */
 
 #include "spikeReportReader.h"
+#include "detail/spikeBuffer.h"
+#include "detail/spikeIndex.h"
 
 #include <brion/spikeReport.h>
 
 #include <lunchbox/log.h>
 
+#include <boost/filesystem/operations.hpp>
+
 namespace brain
 {
 class SpikeReportReader::_Impl
@@ -35,11 +39,34 @@ public:
 
     _Impl(const brion::URI& uri, const GIDSet& subset)
         : _report(uri, subset)
+        , _subsetHash(detail::SpikeIndex::hashSubset(subset))
+    {
+    }
+
+    /** @return the report and subset an index built by this reader is from,
+     *  with no path if the report is not a single file. */
+    detail::SpikeIndex::Source getIndexSource() const
     {
+        namespace fs = boost::filesystem;
+        detail::SpikeIndex::Source source;
+        boost::system::error_code error;
+        const fs::path path =
+            fs::canonical(_report.getURI().getPath(), error);
+        if (error || !fs::is_regular_file(path, error))
+            return source;
+        source.size = fs::file_size(path, error);
+        source.time = fs::last_write_time(path, error);
+        if (error)
+            return source;
+        source.path = path.string();
+        source.subsetHash = _subsetHash;
+        return source;
     }
 
     brion::SpikeReport _report;
-    brion::Spikes _collected;
+    const uint64_t _subsetHash = 0;
+    detail::SpikeBuffer _collected;
+    std::unique_ptr<detail::SpikeIndex> _index;
 };
 
 SpikeReportReader::SpikeReportReader(const brion::URI& uri)
@@ -74,22 +101,68 @@ Spikes SpikeReportReader::getSpikes(const float startTime, const float endTime)
     // the latest value possible. We also try to read always, even if all spikes
     // in the requested window have been already collected.
     auto& collected = _impl->_collected;
-    auto spikes = _impl->_report.read(endTime).get();
-    if (!spikes.empty())
+    collected.append(_impl->_report.read(endTime).get());
+    return collected.getSpikes(startTime, endTime);
+}
+
+Spikes SpikeReportReader::getSpikes(const GIDSet& gids, const float startTime,
+                                   const float endTime)
+{
+    if (endTime <= startTime)
+        LBTHROW(std::logic_error(
+            "Start time should be strictly inferior to end time"));
+
+    if (!_impl->_index)
+        buildIndex();
+    return _impl->_index->getSpikes(gids, startTime, endTime);
+}
+
+SpikesView SpikeReportReader::getSpikesView(const float startTime,
+                                            const float endTime) const
+{
+    return _impl->_report.getView(startTime, endTime);
+}
+
+bool SpikeReportReader::supportsSpikesView() const
+{
+    return _impl->_report.supportsViews();
+}
+
+void SpikeReportReader::buildIndex(const std::string& cacheFile)
+{
+    if (!_impl->_report.supportsBackwardSeek())
+        LBTHROW(std::logic_error("Can't index spikes of a stream report"));
+
+    // A cache is only reused if it was built from the same report file, in
+    // its current state, and subset of cells
+    const auto source = _impl->getIndexSource();
+    if (!cacheFile.empty() && !source.path.empty() &&
+        boost::filesystem::exists(cacheFile))
     {
-        collected.reserve(collected.size() + spikes.size());
-        collected.insert(collected.end(), spikes.begin(), spikes.end());
+        try
+        {
+            _impl->_index.reset(new detail::SpikeIndex(cacheFile, source));
+            return;
+        }
+        catch (const std::runtime_error& e)
+        {
+            LBWARN << e.what() << ", rebuilding it" << std::endl;
+        }
     }
 
-    return Spikes(std::lower_bound(collected.begin(), collected.end(),
-                                   startTime,
-                                   [](const Spike& spike, const float val) {
-                                       return spike.first < val;
-                                   }),
-                  std::lower_bound(collected.begin(), collected.end(), endTime,
-                                   [](const Spike& spike, const float val) {
-                                       return spike.first < val;
-                                   }));
+    // Read through a cursor to leave the position of the report unchanged
+    auto cursor = _impl->_report.createCursor();
+    const auto spikes = cursor.read(brion::UNDEFINED_TIMESTAMP).get();
+    _impl->_index.reset(new detail::SpikeIndex(spikes));
+
+    if (!cacheFile.empty())
+        _impl->_index->save(cacheFile, source);
+}
+
+void SpikeReportReader::setRetention(const float horizon,
+                                     const size_t maxBytes)
+{
+    _impl->_collected.setRetention(horizon, maxBytes);
 }
 
 float SpikeReportReader::getEndTime() const
@@ -106,4 +179,14 @@ void SpikeReportReader::close()
 {
     _impl->_report.close();
 }
+
+IOStatistics SpikeReportReader::getIOStatistics() const
+{
+    return _impl->_report.getIOStatistics();
+}
+
+void SpikeReportReader::resetIOStatistics()
+{
+    _impl->_report.resetIOStatistics();
+}
 }
@@ -79,10 +79,86 @@ public:
      * @return A numpy array of dytpe = "f4, u4"
      * \endif
      * @throw std::logic_error if the precondition is not fulfilled.
+     * @throw std::runtime_error if the spikes of a stream report after start
+     *        have been discarded, see setRetention().
      * @version 1.0
      */
     BRAIN_API Spikes getSpikes(const float start, const float end);
 
+    /**
+     * Get the spikes of some cells inside a time window.
+     *
+     * The first call builds the per-cell spike index, see buildIndex().
+     * Precondition : start < end
+     * \if pybind
+     * @return A numpy array of dytpe = "f4, u4", sorted by time
+     * \endif
+     * @throw std::logic_error if the precondition is not fulfilled or the
+     *        report is a stream.
+     * @version 3.0
+     */
+    BRAIN_API Spikes getSpikes(const GIDSet& gids, float start, float end);
+
+    /**
+     * Get all spikes inside a time window without copying them.
+     *
+     * The spikes point into the memory mapped report, they are valid until
+     * the reader is destroyed. This method does not change the state of the
+     * reader and it may be called concurrently from several threads.
+     * Precondition : start < end
+     * \if pybind
+     * @return A read-only numpy array of dytpe = "f4, u4"
+     * \endif
+     * @throw std::logic_error if the precondition is not fulfilled.
+     * @throw std::runtime_error if the report does not support views, see
+     *        supportsSpikesView().
+     * @version 3.0
+     */
+    BRAIN_API SpikesView getSpikesView(float start, float end) const;
+
+    /**
+     * @return true if getSpikesView() is supported by the report.
+     * @version 3.0
+     */
+    BRAIN_API bool supportsSpikesView() const;
+
+    /**
+     * Build the index of the spike times of each cell.
+     *
+     * The index reads the whole report once and makes the queries for a set
+     * of cells independent of the size of the report. Only reports which
+     * support backward seeking can be indexed. The index only contains the
+     * cells of the subset given at construction, if any. The report is read
+     * through a cursor, so the state of this reader is unchanged.
+     *
+     * @param cacheFile if not empty, the index is loaded from this file if it
+     *        was built from the same report file, with the same size and
+     *        modification time, and the same subset. Otherwise it is built
+     *        and saved to this file.
+     * @throw std::logic_error if the report is a stream.
+     * @throw std::runtime_error if the cache file can not be written.
+     * @version 3.0
+     */
+    BRAIN_API void buildIndex(const std::string& cacheFile = std::string());
+
+    /**
+     * Limit the spikes kept in memory for stream reports.
+     *
+     * Reports which do not support backward seeking keep the spikes read by
+     * getSpikes() to answer later queries. By default they are all kept. With
+     * a retention policy, the oldest spikes are discarded in blocks once they
+     * are older than the horizon before the latest spike received, or once
+     * the spikes kept use more than maxBytes. The latest block of spikes is
+     * always kept. getSpikes() throws std::runtime_error for windows starting
+     * before the discarded spikes.
+     *
+     * @param horizon the duration of the spikes to keep, may be infinite.
+     * @param maxBytes the memory budget of the spikes kept, 0 for no limit.
+     * @throw std::logic_error if horizon <= 0
+     * @version 3.0
+     */
+    BRAIN_API void setRetention(float horizon, size_t maxBytes = 0);
+
     /**
      * @return the end timestamp of the report. This is the timestamp of the
      *         last spike known to be available or larger if the implementation
@@ -113,6 +189,18 @@ public:
      */
     BRAIN_API void close();
 
+    /**
+     * @return the cumulative I/O counters of the underlying report.
+     * \if pybind
+     * @return A dictionary with the counters.
+     * \endif
+     * @version 3.0
+     */
+    BRAIN_API IOStatistics getIOStatistics() const;
+
+    /** Reset the I/O counters of the underlying report. @version 3.0 */
+    BRAIN_API void resetIOStatistics();
+
 private:
     SpikeReportReader(const SpikeReportReader& other) = delete;
     SpikeReportReader& operator=(const SpikeReportReader& other) = delete;
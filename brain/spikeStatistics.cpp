@@ -0,0 +1,279 @@
+/* Copyright (c) 2018, EPFL/Blue Brain Project
+ *
+ * This file is part of Brion <https://github.com/BlueBrain/Brion>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "spikeStatistics.h"
+#include "spikeReportReader.h"
+
+#include <lunchbox/log.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace brain
+{
+namespace spikeStatistics
+{
+namespace
+{
+// Number of bins read from the report at once
+constexpr size_t _binsPerWindow = 4096;
+// Duration in ms read from the report at once for the firing rates
+constexpr float _firingRateWindow = 1000.f;
+// Milliseconds to seconds, for rates in Hz
+constexpr float _msToS = 0.001f;
+constexpr uint32_t _none = std::numeric_limits<uint32_t>::max();
+
+/**
+ * The groups of each cell, in compressed sparse row layout. GIDs are looked up
+ * in a table over the GID range if it is small enough, by binary search
+ * otherwise.
+ */
+class CellGroups
+{
+public:
+    explicit CellGroups(const std::vector<GIDSet>& groups)
+    {
+        uint32_ts gids;
+        for (const auto& group : groups)
+            gids.insert(gids.end(), group.begin(), group.end());
+        std::sort(gids.begin(), gids.end());
+        gids.erase(std::unique(gids.begin(), gids.end()), gids.end());
+        if (gids.empty())
+            return;
+
+        _first = gids.front();
+        const size_t range = size_t(gids.back() - _first) + 1;
+        if (range <= 8 * gids.size() + (1 << 20))
+        {
+            _slots.assign(range, _none);
+            for (size_t i = 0; i < gids.size(); ++i)
+                _slots[gids[i] - _first] = uint32_t(i);
+        }
+        else
+            _gids = std::move(gids);
+
+        // Count the groups of each cell, then fill them in
+        const size_t numCells = _slots.empty() ? _gids.size() : gids.size();
+        _offsets.assign(numCells + 1, 0);
+        for (const auto& group : groups)
+            for (const uint32_t gid : group)
+                ++_offsets[_slot(gid) + 1];
+        for (size_t i = 0; i < numCells; ++i)
+            _offsets[i + 1] += _offsets[i];
+        _groups.resize(_offsets.back());
+        std::vector<uint32_t> next(_offsets.begin(), _offsets.end() - 1);
+        for (size_t g = 0; g < groups.size(); ++g)
+            for (const uint32_t gid : groups[g])
+                _groups[next[_slot(gid)]++] = uint32_t(g);
+    }
+
+    /**
+     * @return the index of a cell in the sorted GIDs of all groups, _none if
+     *         it is in no group.
+     */
+    uint32_t getCell(const uint32_t gid) const { return _slot(gid); }
+
+    /** Call func with the index of each group of the cell. */
+    template <typename F>
+    void forEachGroup(const uint32_t gid, const F& func) const
+    {
+        const uint32_t slot = _slot(gid);
+        if (slot == _none)
+            return;
+        for (uint32_t i = _offsets[slot]; i != _offsets[slot + 1]; ++i)
+            func(_groups[i]);
+    }
+
+private:
+    uint32_t _first = 0;
+    std::vector<uint32_t> _slots; // dense GID range to cell slot
+    uint32_ts _gids;              // sorted GIDs, if _slots is not used
+    std::vector<uint32_t> _offsets;
+    std::vector<uint32_t> _groups;
+
+    uint32_t _slot(const uint32_t gid) const
+    {
+        if (!_slots.empty())
+        {
+            const uint32_t offset = gid - _first;
+            return offset < _slots.size() ? _slots[offset] : _none;
+        }
+        const auto i = std::lower_bound(_gids.begin(), _gids.end(), gid);
+        return i != _gids.end() && *i == gid ? uint32_t(i - _gids.begin())
+                                             : _none;
+    }
+};
+
+size_t _getNumBins(const float start, const float end, const float binSize)
+{
+    if (end <= start)
+        LBTHROW(std::logic_error(
+            "Start time should be strictly inferior to end time"));
+    if (!(binSize > 0))
+        LBTHROW(std::logic_error("Bin size must be positive"));
+    return size_t(std::ceil((end - start) / binSize));
+}
+
+// Calls func with the spikes of [start, end) read in consecutive windows
+template <typename F>
+void _forEachWindow(SpikeReportReader& reader, const float start,
+                    const float end, const float windowSize, const F& func)
+{
+    for (size_t i = 0;; ++i)
+    {
+        const float windowStart = start + i * windowSize;
+        if (windowStart >= end)
+            break;
+        const float windowEnd = std::min(end, windowStart + windowSize);
+        func(reader.getSpikes(windowStart, windowEnd));
+    }
+}
+
+// @return the bin of a spike time in [start, end), clamped against
+// rounding errors
+size_t _getBin(const float time, const float start, const float scale,
+               const size_t numBins)
+{
+    return std::min(size_t((time - start) * scale), numBins - 1);
+}
+}
+
+std::vector<uint32_ts> computeSpikeCounts(SpikeReportReader& reader,
+                                          const std::vector<GIDSet>& groups,
+                                          const float start, const float end,
+                                          const float binSize)
+{
+    const size_t numBins = _getNumBins(start, end, binSize);
+    std::vector<uint32_ts> counts(groups.size(), uint32_ts(numBins, 0));
+    const CellGroups cellGroups(groups);
+    const float scale = 1.f / binSize;
+
+    // Groups counting all cells are binned first without any lookup
+    std::vector<size_t> allCells;
+    for (size_t g = 0; g < groups.size(); ++g)
+        if (groups[g].empty())
+            allCells.push_back(g);
+
+    const auto binSpikes = [&](const Spikes& spikes) {
+        if (!allCells.empty())
+        {
+            auto& count = counts[allCells[0]];
+            for (const auto& spike : spikes)
+                ++count[_getBin(spike.first, start, scale, numBins)];
+        }
+        for (const auto& spike : spikes)
+        {
+            const size_t bin = _getBin(spike.first, start, scale, numBins);
+            cellGroups.forEachGroup(spike.second, [&](const uint32_t group) {
+                ++counts[group][bin];
+            });
+        }
+    };
+    _forEachWindow(reader, start, end, binSize * _binsPerWindow, binSpikes);
+
+    for (size_t i = 1; i < allCells.size(); ++i)
+        counts[allCells[i]] = counts[allCells[0]];
+    return counts;
+}
+
+std::vector<floats> computePopulationRates(SpikeReportReader& reader,
+                                           const std::vector<GIDSet>& groups,
+                                           const float start, const float end,
+                                           const float binSize)
+{
+    for (const auto& group : groups)
+        if (group.empty())
+            LBTHROW(std::logic_error("Can't compute the rate of no cells"));
+
+    const auto counts =
+        computeSpikeCounts(reader, groups, start, end, binSize);
+    std::vector<floats> rates(groups.size());
+    for (size_t g = 0; g < groups.size(); ++g)
+    {
+        const float scale = 1.f / (groups[g].size() * binSize * _msToS);
+        rates[g].reserve(counts[g].size());
+        for (const uint32_t count : counts[g])
+            rates[g].push_back(count * scale);
+    }
+    return rates;
+}
+
+floats computeFiringRates(SpikeReportReader& reader, const GIDSet& gids,
+                          const float start, const float end)
+{
+    if (end <= start)
+        LBTHROW(std::logic_error(
+            "Start time should be strictly inferior to end time"));
+
+    // The cells are indexed in GID order, which is the order of the GIDSet
+    const CellGroups cellGroups({gids});
+    uint32_ts counts(gids.size(), 0);
+    const auto countSpikes = [&](const Spikes& spikes) {
+        for (const auto& spike : spikes)
+        {
+            const uint32_t cell = cellGroups.getCell(spike.second);
+            if (cell != _none)
+                ++counts[cell];
+        }
+    };
+    _forEachWindow(reader, start, end, _firingRateWindow, countSpikes);
+
+    floats rates;
+    rates.reserve(counts.size());
+    const float scale = 1.f / ((end - start) * _msToS);
+    for (const uint32_t count : counts)
+        rates.push_back(count * scale);
+    return rates;
+}
+
+floats computePSTH(SpikeReportReader& reader, const GIDSet& gids,
+                   const floats& stimuli, const float before,
+                   const float after, const float binSize)
+{
+    if (gids.empty() || stimuli.empty())
+        LBTHROW(std::logic_error("Can't compute a PSTH without cells or "
+                                 "stimuli"));
+    const size_t numBins = _getNumBins(-before, after, binSize);
+    const CellGroups cellGroups({gids});
+    const float scale = 1.f / binSize;
+
+    uint32_ts counts(numBins, 0);
+    floats sorted(stimuli);
+    std::sort(sorted.begin(), sorted.end());
+    for (const float stimulus : sorted)
+    {
+        const float start = stimulus - before;
+        for (const auto& spike : reader.getSpikes(start, stimulus + after))
+        {
+            const size_t bin = _getBin(spike.first, start, scale, numBins);
+            cellGroups.forEachGroup(spike.second,
+                                    [&](uint32_t) { ++counts[bin]; });
+        }
+    }
+
+    floats rates;
+    rates.reserve(numBins);
+    const float rateScale =
+        1.f / (sorted.size() * gids.size() * binSize * _msToS);
+    for (const uint32_t count : counts)
+        rates.push_back(count * rateScale);
+    return rates;
+}
+}
+}
@@ -0,0 +1,116 @@
+/* Copyright (c) 2018, EPFL/Blue Brain Project
+ *
+ * This file is part of Brion <https://github.com/BlueBrain/Brion>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef BRAIN_SPIKESTATISTICS_H
+#define BRAIN_SPIKESTATISTICS_H
+
+#include <brain/api.h>
+#include <brain/types.h>
+
+namespace brain
+{
+class SpikeReportReader;
+
+/**
+ * Binned spike statistics computed in a single pass over a spike report.
+ *
+ * The report is read in consecutive time windows, so the memory used does not
+ * depend on the size of the report. Spike times are in milliseconds and rates
+ * in Hz. Time bins are [start + i * binSize, start + (i + 1) * binSize), the
+ * last bin ends at or after the end of the time range.
+ *
+ * Cells are grouped by GIDSets, for example the GIDs of targets or of
+ * morphological types. A cell may belong to several groups.
+ */
+namespace spikeStatistics
+{
+/**
+ * Count the spikes of groups of cells per time bin.
+ *
+ * @param reader the spike report
+ * @param groups the cell groups. An empty group counts the spikes of all
+ *        cells.
+ * @param start the start of the time range
+ * @param end the end of the time range
+ * @param binSize the duration of a time bin
+ * @return the spike counts of each group, one per time bin.
+ * @throw std::logic_error if start >= end or binSize <= 0
+ * @version 3.0
+ */
+BRAIN_API std::vector<uint32_ts> computeSpikeCounts(
+    SpikeReportReader& reader, const std::vector<GIDSet>& groups, float start,
+    float end, float binSize);
+
+/**
+ * Compute the population firing rate of groups of cells per time bin.
+ *
+ * The rate of a bin is the number of spikes of the group divided by the
+ * number of cells in the group and by the bin duration.
+ *
+ * @param reader the spike report
+ * @param groups the cell groups
+ * @param start the start of the time range
+ * @param end the end of the time range
+ * @param binSize the duration of a time bin
+ * @return the firing rate of each group, one per time bin.
+ * @throw std::logic_error if start >= end, binSize <= 0 or a group is empty
+ * @version 3.0
+ */
+BRAIN_API std::vector<floats> computePopulationRates(
+    SpikeReportReader& reader, const std::vector<GIDSet>& groups, float start,
+    float end, float binSize);
+
+/**
+ * Compute the mean firing rate of each cell in a time range.
+ *
+ * @param reader the spike report
+ * @param gids the cells
+ * @param start the start of the time range
+ * @param end the end of the time range
+ * @return the firing rate of each cell, in the order of the GIDSet.
+ * @throw std::logic_error if start >= end
+ * @version 3.0
+ */
+BRAIN_API floats computeFiringRates(SpikeReportReader& reader,
+                                    const GIDSet& gids, float start,
+                                    float end);
+
+/**
+ * Compute the peri-stimulus time histogram of a group of cells.
+ *
+ * The spikes in [stimulus - before, stimulus + after) of every stimulus are
+ * binned relative to the stimulus time.
+ *
+ * @param reader the spike report
+ * @param gids the cells
+ * @param stimuli the stimulus times
+ * @param before the duration of the window before each stimulus
+ * @param after the duration of the window after each stimulus
+ * @param binSize the duration of a time bin
+ * @return the firing rate per cell and per bin, averaged over all stimuli.
+ * @throw std::logic_error if gids or stimuli are empty, binSize <= 0 or
+ *        before + after <= 0
+ * @version 3.0
+ */
+BRAIN_API floats computePSTH(SpikeReportReader& reader, const GIDSet& gids,
+                             const floats& stimuli, float before, float after,
+                             float binSize);
+}
+}
+
+#endif
@@ -0,0 +1,159 @@
+/* Copyright (c) 2018, EPFL/Blue Brain Project
+ *
+ * This file is part of Brion <https://github.com/BlueBrain/Brion>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "spikeTriggeredFrames.h"
+#include "compartmentReport.h"
+#include "compartmentReportMapping.h"
+#include "compartmentReportView.h"
+#include "spikeReportReader.h"
+
+#include <brion/detail/frameWindow.h>
+
+#include <lunchbox/log.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace brain
+{
+namespace
+{
+using brion::detail::checkFrameWindow;
+using brion::detail::getWindowSize;
+using brion::detail::loadFrameWindow;
+using brion::detail::snapFrames;
+
+// A range of frames [first, end) of the compartment report
+struct FrameRange
+{
+    int64_t first;
+    int64_t end;
+};
+}
+
+SpikeTriggeredFrames loadSpikeTriggeredFrames(SpikeReportReader& reader,
+                                              const GIDSet& gids,
+                                              const float start,
+                                              const float end,
+                                              CompartmentReportView& view,
+                                              const double before,
+                                              const double after)
+{
+    if (end <= start)
+        LBTHROW(std::logic_error(
+            "Start time should be strictly inferior to end time"));
+    if (!(before + after > 0))
+        LBTHROW(std::logic_error("Window duration must be positive"));
+
+    const CompartmentReportMetaData metaData = view.getReader().getMetaData();
+    const double timestep = metaData.timeStep;
+    const int64_t frameCount = metaData.frameCount;
+
+    SpikeTriggeredFrames result;
+    result.spikes = reader.getSpikes(start, end);
+    if (!gids.empty())
+        result.spikes.erase(std::remove_if(result.spikes.begin(),
+                                           result.spikes.end(),
+                                           [&gids](const Spike& spike) {
+                                               return !gids.count(
+                                                   spike.second);
+                                           }),
+                            result.spikes.end());
+
+    const auto& spikes = result.spikes;
+    const size_t windowSize =
+        std::ceil(snapFrames((before + after) / timestep));
+    const size_t frameSize = view.getMapping().getFrameSize();
+    result.numFrames = windowSize;
+    result.frameSize = frameSize;
+    result.data.assign(spikes.size() * windowSize * frameSize,
+                       std::numeric_limits<float>::quiet_NaN());
+
+    // The first frame of each window, and the ranges of frames read at once.
+    // The spikes are sorted, so the windows are sorted too.
+    std::vector<int64_t> firstFrames;
+    std::vector<FrameRange> reads;
+    for (const auto& spike : spikes)
+    {
+        const int64_t first = std::floor(
+            snapFrames((spike.first - before - metaData.startTime) / timestep));
+        firstFrames.push_back(first);
+        result.startTimes.push_back(metaData.startTime + first * timestep);
+
+        const int64_t begin = std::max(first, int64_t(0));
+        const int64_t last = std::min(first + int64_t(windowSize), frameCount);
+        if (begin >= last)
+            continue;
+        if (!reads.empty() && begin <= reads.back().end)
+            reads.back().end = std::max(reads.back().end, last);
+        else
+            reads.push_back({begin, last});
+    }
+
+    // Bound the memory used by the ranges of frames of dense spikes
+    const int64_t maxFrames = getWindowSize(frameSize);
+    std::vector<FrameRange> chunks;
+    for (const auto& range : reads)
+        for (int64_t first = range.first; first < range.end; first += maxFrames)
+            chunks.push_back({first, std::min(first + maxFrames, range.end)});
+
+    const auto load = [&](const FrameRange& range) {
+        return loadFrameWindow(
+            [&](const double start_, const double end_) {
+                return view.load(start_, end_);
+            },
+            metaData.startTime, timestep, range.first, range.end);
+    };
+
+    std::future<brion::Frames> next;
+    if (!chunks.empty())
+        next = load(chunks.front());
+    size_t firstSpike = 0;
+    for (size_t c = 0; c < chunks.size(); ++c)
+    {
+        const brion::Frames frames = next.get();
+        if (c + 1 < chunks.size())
+            next = load(chunks[c + 1]);
+
+        const FrameRange& range = chunks[c];
+        checkFrameWindow(frames, range.end - range.first, frameSize,
+                         metaData.startTime + range.first * timestep);
+
+        // Copy the frames of the range into the windows overlapping it
+        while (firstSpike < spikes.size() &&
+               firstFrames[firstSpike] + int64_t(windowSize) <= range.first)
+        {
+            ++firstSpike;
+        }
+        for (size_t i = firstSpike;
+             i < spikes.size() && firstFrames[i] < range.end; ++i)
+        {
+            const int64_t begin = std::max(firstFrames[i], range.first);
+            const int64_t last =
+                std::min(firstFrames[i] + int64_t(windowSize), range.end);
+            std::copy(frames.data->begin() + (begin - range.first) * frameSize,
+                      frames.data->begin() + (last - range.first) * frameSize,
+                      result.data.begin() +
+                          (i * windowSize + (begin - firstFrames[i])) *
+                              frameSize);
+        }
+    }
+    return result;
+}
+}
@@ -0,0 +1,81 @@
+/* Copyright (c) 2018, EPFL/Blue Brain Project
+ *
+ * This file is part of Brion <https://github.com/BlueBrain/Brion>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef BRAIN_SPIKETRIGGEREDFRAMES_H
+#define BRAIN_SPIKETRIGGEREDFRAMES_H
+
+#include <brain/api.h>
+#include <brain/types.h>
+
+namespace brain
+{
+class CompartmentReportView;
+class SpikeReportReader;
+
+/**
+ * The compartment frames in a time window around each spike of a group of
+ * cells, aligned on the spikes.
+ *
+ * The values are in a flat array of spikes.size() x numFrames x frameSize
+ * values. Frame k of the window of spike i has the timestamp
+ * startTimes[i] + k * timestep of the compartment report. The values of the
+ * frames outside of the compartment report are NaN.
+ */
+struct SpikeTriggeredFrames
+{
+    /** The spikes, sorted by time. */
+    Spikes spikes;
+    /** The timestamp of the first frame of the window of each spike. */
+    doubles startTimes;
+    /** The number of frames of each window. */
+    size_t numFrames = 0;
+    /** The number of values of each frame, see CompartmentReportMapping. */
+    size_t frameSize = 0;
+    /** The values of all the windows. */
+    floats data;
+};
+
+/**
+ * Load the compartment frames around the spikes of a group of cells.
+ *
+ * The window of a spike starts with the frame which contains the time
+ * spike - before and has ceil((before + after) / timestep) frames. Only the
+ * frames in the windows are loaded: overlapping windows are merged into
+ * ranges of frames which are read at once, and the next range is read while
+ * the previous one is copied into the windows.
+ *
+ * @param reader the spike report
+ * @param gids the cells whose spikes trigger the windows, all cells if empty
+ * @param start the start of the time range of the spikes
+ * @param end the end of the time range of the spikes
+ * @param view the compartment report view to load the frames from
+ * @param before the duration of the window before each spike
+ * @param after the duration of the window after each spike
+ * @return the frames around the spikes in [start, end).
+ * @throw std::logic_error if start >= end or before + after <= 0
+ * @throw std::runtime_error if frames can't be loaded
+ * @version 3.0
+ */
+BRAIN_API SpikeTriggeredFrames
+    loadSpikeTriggeredFrames(SpikeReportReader& reader, const GIDSet& gids,
+                             float start, float end,
+                             CompartmentReportView& view, double before,
+                             double after);
+}
+
+#endif
@@ -61,7 +61,8 @@ public:
      *
      * @param count the next fraction in the [0,getRemaining()] interval to read
      * @return a future to the Synapses containing the requested fraction of
-     *         synapses
+     *         synapses. The stream waits for the pending reads on destruction,
+     *         the returned futures do not need to be consumed.
      */
     BRAIN_API std::future<Synapses> read(size_t count = 1);
 
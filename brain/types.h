@@ -42,6 +42,8 @@ enum class SynapsePrefetch
 class Circuit;
 class CompartmentReport;
 class CompartmentReportFrame;
+class CompartmentReportGroup;
+class CompartmentReportGroupView;
 class CompartmentReportMapping;
 class CompartmentReportView;
 class Simulation;
@@ -60,12 +62,14 @@ using vmml::Vector3f;
 using vmml::Vector4f;
 
 using brion::GIDSet;
+using brion::IOStatistics;
 using brion::Strings;
 using brion::URI;
 using brion::URIs;
 using brion::Vector2is;
 using brion::Vector3fs;
 using brion::Vector4fs;
+using brion::doubles;
 using brion::floats;
 using brion::uint32_ts;
 using brion::size_ts;
@@ -73,6 +77,7 @@ using brion::size_ts;
 using brion::SectionOffsets;
 using brion::Spike;
 using brion::Spikes;
+using brion::SpikesView;
 using brion::CompartmentCounts;
 
 using AABB = vmml::AABB<float>;
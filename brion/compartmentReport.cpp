@@ -19,10 +19,15 @@
 
 #include "compartmentReport.h"
 #include "compartmentReportPlugin.h"
+#include "executor.h"
+
+#include "detail/trace.h"
 
 #include <lunchbox/log.h>
 #include <lunchbox/pluginFactory.h>
-#include <lunchbox/threadPool.h>
+
+#include <chrono>
+#include <thread>
 
 namespace brion
 {
@@ -31,6 +36,9 @@ namespace
 using CompartmentPluginFactory =
     lunchbox::PluginFactory<CompartmentReportPlugin>;
 
+// Time between two checks for new frames while waiting for the writer
+constexpr std::chrono::milliseconds _pollInterval(10);
+
 namespace
 {
 inline double _snapTimestamp(double t, double start, double timestep)
@@ -38,6 +46,14 @@ inline double _snapTimestamp(double t, double start, double timestep)
     return start + timestep * (size_t)std::floor((t - start) / timestep);
 }
 }
+
+CompartmentReportPlugin* _createPlugin(
+    const CompartmentReportInitData& initData)
+{
+    BRION_TRACE("CompartmentReport::open", "report",
+                std::to_string(initData.getURI()));
+    return CompartmentPluginFactory::getInstance().create(initData);
+}
 }
 
 namespace detail
@@ -46,7 +62,7 @@ class CompartmentReport
 {
 public:
     explicit CompartmentReport(const CompartmentReportInitData& initData)
-        : plugin(CompartmentPluginFactory::getInstance().create(initData))
+        : plugin(_createPlugin(initData))
     {
     }
 
@@ -149,23 +165,25 @@ size_t CompartmentReport::getBufferSize() const
 std::future<Frame> CompartmentReport::loadFrame(const double timestamp) const
 {
     auto task = [timestamp, this] {
+        BRION_TRACE("CompartmentReport::loadFrame", "report");
         if (timestamp < getStartTime() || timestamp >= getEndTime())
             return Frame();
         auto t = _snapTimestamp(timestamp, getStartTime(), getTimestep());
         return Frame{t, _impl->plugin->loadFrame(t)};
     };
-    return lunchbox::ThreadPool::getInstance().post(task);
+    return Executor::getDefault()->post(task);
 }
 
 std::future<Frames> CompartmentReport::loadFrames(const double start,
                                                   const double end) const
 {
     auto task = [start, end, this] {
+        BRION_TRACE("CompartmentReport::loadFrames", "report");
         if (end < getStartTime() || start >= getEndTime())
             return Frames();
         return _impl->plugin->loadFrames(start, end);
     };
-    return lunchbox::ThreadPool::getInstance().post(task);
+    return Executor::getDefault()->post(task);
 }
 
 size_t CompartmentReport::getNeuronSize(const uint32_t gid) const
@@ -180,8 +198,11 @@ size_t CompartmentReport::getNeuronSize(const uint32_t gid) const
 
 std::future<floatsPtr> CompartmentReport::loadNeuron(const uint32_t gid) const
 {
-    auto task = [gid, this] { return _impl->plugin->loadNeuron(gid); };
-    return lunchbox::ThreadPool::getInstance().post(task);
+    auto task = [gid, this] {
+        BRION_TRACE("CompartmentReport::loadNeuron", "report");
+        return _impl->plugin->loadNeuron(gid);
+    };
+    return Executor::getDefault()->post(task, Executor::Priority::bulk);
 }
 
 void CompartmentReport::setBufferSize(const size_t size)
@@ -194,8 +215,46 @@ void CompartmentReport::clearBuffer()
     _impl->plugin->clearBuffer();
 }
 
+IOStatistics CompartmentReport::getIOStatistics() const
+{
+    return _impl->plugin->getIOStatistics();
+}
+
+void CompartmentReport::resetIOStatistics()
+{
+    _impl->plugin->resetIOStatistics();
+}
+
+bool CompartmentReport::refresh()
+{
+    BRION_TRACE("CompartmentReport::refresh", "report");
+    return _impl->plugin->refresh();
+}
+
+bool CompartmentReport::waitForFrames(const size_t count,
+                                      const uint32_t timeout)
+{
+    const auto deadline =
+        std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+    for (;;)
+    {
+        const bool growing = refresh();
+        if (getFrameCount() >= count)
+            return true;
+        if (!growing)
+            return false;
+        if (timeout != std::numeric_limits<uint32_t>::max() &&
+            std::chrono::steady_clock::now() >= deadline)
+        {
+            return false;
+        }
+        std::this_thread::sleep_for(_pollInterval);
+    }
+}
+
 void CompartmentReport::updateMapping(const GIDSet& gids)
 {
+    BRION_TRACE("CompartmentReport::updateMapping", "report");
     _impl->plugin->updateMapping(gids);
 }
 
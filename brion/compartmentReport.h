@@ -26,6 +26,7 @@
 #include <boost/noncopyable.hpp>
 
 #include <future>
+#include <limits>
 
 namespace brion
 {
@@ -221,6 +222,48 @@ public:
 
     /** Clears all buffered frames to free memory. @version 1.0 */
     BRION_API void clearBuffer();
+
+    /**
+     * @return the cumulative I/O counters of this report since it was opened
+     *         or resetIOStatistics() was called.
+     * @version 3.0
+     */
+    BRION_API IOStatistics getIOStatistics() const;
+
+    /** Reset all I/O counters to 0. @version 3.0 */
+    BRION_API void resetIOStatistics();
+
+    /** Update the frames available in a report which is still being written.
+     *
+     * The end time and frame count of a report being written are the ones of
+     * the last complete frame found in storage. Binary reports check the size
+     * of the file, SONATA reports refresh the extent of the dataset, which
+     * needs the report to be opened with the tail option when the writer uses
+     * SWMR. Other backends always have all their frames.
+     *
+     * @return true if the report is not complete yet, i.e. more frames are
+     *         expected according to its header.
+     * @note This function must not be called while loading operations are
+     * pending
+     * @version 3.0
+     */
+    BRION_API bool refresh();
+
+    /** Wait until a report being written has the given number of frames.
+     *
+     * The report is refreshed periodically until enough frames are available,
+     * the report is complete or the timeout expires.
+     *
+     * @param count the number of frames to wait for
+     * @param timeout the maximum time to wait in milliseconds, unlimited by
+     *        default
+     * @return true if at least count frames are available.
+     * @note This function must not be called while loading operations are
+     * pending
+     * @version 3.0
+     */
+    BRION_API bool waitForFrames(
+        size_t count, uint32_t timeout = std::numeric_limits<uint32_t>::max());
     //@}
 
     /** @name Write API
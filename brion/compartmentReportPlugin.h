@@ -193,6 +193,12 @@ public:
 
     /** @copydoc brion::CompartmentReport::erase */
     virtual bool erase() { return false; }
+    /** @copydoc brion::CompartmentReport::getIOStatistics */
+    virtual IOStatistics getIOStatistics() const { return IOStatistics(); }
+    /** @copydoc brion::CompartmentReport::resetIOStatistics */
+    virtual void resetIOStatistics() {}
+    /** @copydoc brion::CompartmentReport::refresh */
+    virtual bool refresh() { return false; }
     //@}
 
     /** @copydoc brion::CompartmentReport::getIndex */
@@ -0,0 +1,438 @@
+/* Copyright (c) 2018, EPFL/Blue Brain Project
+ *
+ * This file is part of Brion <https://github.com/BlueBrain/Brion>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "compartmentReportStatistics.h"
+#include "compartmentReport.h"
+#include "executor.h"
+
+#include "detail/atomicFile.h"
+#include "detail/frameWindow.h"
+
+#include <lunchbox/log.h>
+#include <lunchbox/memoryMap.h>
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace fs = boost::filesystem;
+
+namespace brion
+{
+namespace
+{
+const char* const STATISTICS_FILE_EXT = ".stats";
+
+struct Header
+{
+    uint32_t magic = 0xf0c;
+    uint32_t version = 1;
+    uint64_t frameCount = 0;
+    uint64_t cellCount = 0;
+    uint64_t frameSize = 0;
+    double startTime = 0;
+    double timestep = 0;
+};
+
+// @return the header of the statistics of a report
+Header _getHeader(const CompartmentReport& report)
+{
+    Header header;
+    header.frameCount = report.getFrameCount();
+    header.cellCount = report.getCellCount();
+    header.frameSize = report.getFrameSize();
+    header.startTime = report.getStartTime();
+    header.timestep = report.getTimestep();
+    return header;
+}
+
+const float _nan = std::numeric_limits<float>::quiet_NaN();
+
+// Computes the statistics of values, which are reordered
+ValueStatistics _computeStatistics(float* begin, float* end)
+{
+    const size_t size = end - begin;
+    if (size == 0)
+        return {_nan, _nan, _nan, _nan, _nan, _nan};
+
+    ValueStatistics statistics;
+    statistics.min = *begin;
+    statistics.max = *begin;
+    double sum = 0;
+    for (const float* value = begin; value != end; ++value)
+    {
+        statistics.min = std::min(statistics.min, *value);
+        statistics.max = std::max(statistics.max, *value);
+        sum += *value;
+    }
+    statistics.mean = sum / size;
+
+    // Each percentile partitions the values below the previous one
+    const auto rank = [begin, size](const double percentile) {
+        return begin + size_t(std::round(percentile * (size - 1)));
+    };
+    float* p5 = rank(0.05);
+    float* median = rank(0.5);
+    float* p95 = rank(0.95);
+    std::nth_element(begin, p95, end);
+    std::nth_element(begin, median, p95);
+    std::nth_element(begin, p5, median);
+    statistics.p5 = *p5;
+    statistics.median = *median;
+    statistics.p95 = *p95;
+    return statistics;
+}
+}
+
+namespace detail
+{
+class CompartmentReportStatistics
+{
+public:
+    CompartmentReportStatistics(const URI& uri, const std::string& path_,
+                                const bool compute)
+        : path(path_)
+    {
+        const std::string& reportPath = uri.getPath();
+        boost::system::error_code error;
+        if (path.empty() && fs::is_regular_file(reportPath, error))
+            path = reportPath + STATISTICS_FILE_EXT;
+
+        brion::CompartmentReport report(uri, MODE_READ);
+        report.updateMapping(GIDSet());
+        const Header expected = _getHeader(report);
+        if (!path.empty() && _isUpToDate(reportPath) && _map(path, expected))
+            return;
+        if (!compute)
+            LBTHROW(std::runtime_error("No up to date statistics for " +
+                                       std::to_string(uri)));
+
+        if (!path.empty() && _compute(report, path) && _map(path, expected))
+            return;
+
+        // The sidecar file can't be written, e.g. in a read-only directory
+        path.clear();
+        _scratchPath = (fs::temp_directory_path() /
+                        fs::unique_path("brion-statistics-%%%%-%%%%-%%%%" +
+                                        std::string(STATISTICS_FILE_EXT)))
+                           .string();
+        if (!_compute(report, _scratchPath) ||
+            !_map(_scratchPath, expected))
+        {
+            _memoryMap.reset();
+            fs::remove(_scratchPath, error);
+            LBTHROW(std::runtime_error("Cannot write the statistics of " +
+                                       std::to_string(uri)));
+        }
+    }
+
+    ~CompartmentReportStatistics()
+    {
+        if (_scratchPath.empty())
+            return;
+        _memoryMap.reset();
+        boost::system::error_code error;
+        fs::remove(_scratchPath, error);
+    }
+
+    void checkFrame(const size_t frame) const
+    {
+        if (frame >= header.frameCount)
+            LBTHROW(std::logic_error("Frame " + std::to_string(frame) +
+                                     " is out of range"));
+    }
+
+    std::string path;
+    Header header;
+    uint32_ts gids;
+    const ValueStatistics* frames = nullptr;
+    const ValueStatistics* cells = nullptr;
+    std::pair<float, float> range{_nan, _nan};
+
+private:
+    std::unique_ptr<lunchbox::MemoryMap> _memoryMap;
+    // The file of the statistics when the sidecar file can't be written
+    std::string _scratchPath;
+
+    size_t _getFileSize() const
+    {
+        return sizeof(Header) + header.cellCount * sizeof(uint32_t) +
+               header.frameCount * (header.cellCount + 1) *
+                   sizeof(ValueStatistics);
+    }
+
+    void _updateRange()
+    {
+        for (size_t i = 0; i < header.frameCount; ++i)
+        {
+            // Comparisons with NaN are false, so frames without values are
+            // skipped
+            if (!(range.first <= frames[i].min))
+                range.first = frames[i].min;
+            if (!(range.second >= frames[i].max))
+                range.second = frames[i].max;
+        }
+    }
+
+    bool _isUpToDate(const std::string& reportPath) const
+    {
+        // Statistics older than the report are stale
+        boost::system::error_code error;
+        const auto statisticsTime = fs::last_write_time(path, error);
+        if (error)
+            return false;
+        const auto reportTime = fs::last_write_time(reportPath, error);
+        return error || statisticsTime >= reportTime;
+    }
+
+    // Statistics of a report with other dimensions or times are stale too
+    bool _map(const std::string& filePath, const Header& expected)
+    {
+        _memoryMap.reset(new lunchbox::MemoryMap(filePath));
+        const uint8_t* data = _memoryMap->getAddress<uint8_t>();
+        if (data && _memoryMap->getSize() >= sizeof(Header))
+        {
+            header = *reinterpret_cast<const Header*>(data);
+            if (header.magic == expected.magic &&
+                header.version == expected.version &&
+                header.frameCount == expected.frameCount &&
+                header.cellCount == expected.cellCount &&
+                header.frameSize == expected.frameSize &&
+                header.startTime == expected.startTime &&
+                header.timestep == expected.timestep &&
+                _memoryMap->getSize() == _getFileSize())
+            {
+                data += sizeof(Header);
+                const uint32_t* gidData =
+                    reinterpret_cast<const uint32_t*>(data);
+                gids.assign(gidData, gidData + header.cellCount);
+                frames = reinterpret_cast<const ValueStatistics*>(
+                    gidData + header.cellCount);
+                cells = frames + header.frameCount;
+                _updateRange();
+                return true;
+            }
+        }
+        // Unmapped, so that the file can be replaced
+        _memoryMap.reset();
+        header = Header();
+        return false;
+    }
+
+    // Computes the statistics window by window and streams the statistics of
+    // the cells to the file. Only the statistics of the frames are kept in
+    // memory, they are written last, after the gids.
+    bool _compute(const brion::CompartmentReport& report,
+                  const std::string& filePath) const
+    {
+        AtomicFile file(filePath);
+        if (!file.stream)
+            return false;
+
+        const Header fileHeader = _getHeader(report);
+        const uint32_ts fileGIDs(report.getGIDs().begin(),
+                                 report.getGIDs().end());
+        std::vector<ValueStatistics> frameStatistics(fileHeader.frameCount);
+        file.stream.write(reinterpret_cast<const char*>(&fileHeader),
+                          sizeof(fileHeader));
+        file.stream.write(reinterpret_cast<const char*>(fileGIDs.data()),
+                          fileGIDs.size() * sizeof(uint32_t));
+        const auto framesPosition = file.stream.tellp();
+        file.stream.write(reinterpret_cast<const char*>(
+                              frameStatistics.data()),
+                          frameStatistics.size() * sizeof(ValueStatistics));
+
+        const int64_t frameCount = fileHeader.frameCount;
+        const size_t frameSize = fileHeader.frameSize;
+        const size_t cellCount = fileHeader.cellCount;
+        // A window holds its values and the statistics of its cells
+        const int64_t windowSize = getWindowSize(
+            frameSize + cellCount * sizeof(ValueStatistics) / sizeof(float));
+        const auto load = [&](const int64_t begin) {
+            return loadFrameWindow(
+                [&](const double start_, const double end_) {
+                    return report.loadFrames(start_, end_);
+                },
+                fileHeader.startTime, fileHeader.timestep, begin,
+                std::min(begin + windowSize, frameCount));
+        };
+
+        std::vector<ValueStatistics> cellStatistics;
+        std::future<Frames> next;
+        if (frameCount > 0)
+            next = load(0);
+        for (int64_t begin = 0; begin < frameCount; begin += windowSize)
+        {
+            const Frames frames_ = next.get();
+            if (!file.stream)
+                break;
+            const int64_t end = std::min(begin + windowSize, frameCount);
+            const size_t numFrames = end - begin;
+            checkFrameWindow(frames_, numFrames, frameSize,
+                             fileHeader.startTime +
+                                 begin * fileHeader.timestep);
+            if (end < frameCount)
+                next = load(end);
+
+            cellStatistics.resize(numFrames * cellCount);
+            _compute(report, *frames_.data, numFrames,
+                     frameStatistics.data() + begin, cellStatistics.data());
+            file.stream.write(reinterpret_cast<const char*>(
+                                  cellStatistics.data()),
+                              cellStatistics.size() * sizeof(ValueStatistics));
+        }
+
+        file.stream.seekp(framesPosition);
+        file.stream.write(reinterpret_cast<const char*>(
+                              frameStatistics.data()),
+                          frameStatistics.size() * sizeof(ValueStatistics));
+        if (file.commit())
+            return true;
+        LBDEBUG << "Cannot write compartment report statistics " << filePath
+                << std::endl;
+        return false;
+    }
+
+    // Computes the statistics of a window of frames in parallel over frames
+    void _compute(const brion::CompartmentReport& report, const floats& data,
+                  const size_t numFrames, ValueStatistics* frameStatistics,
+                  ValueStatistics* cellStatistics) const
+    {
+        const size_t frameSize = report.getFrameSize();
+        const size_t cellCount = report.getCellCount();
+        auto executor = brion::Executor::getDefault();
+        const size_t numTasks =
+            std::max(size_t(1), std::min(executor->getSize(), numFrames));
+        std::vector<std::future<void>> tasks;
+        for (size_t i = 0; i < numTasks; ++i)
+        {
+            const size_t begin = numFrames * i / numTasks;
+            const size_t end = numFrames * (i + 1) / numTasks;
+            tasks.push_back(executor->post(
+                [&, begin, end] {
+                    floats values;
+                    for (size_t frame = begin; frame < end; ++frame)
+                        _compute(report, data.data() + frame * frameSize,
+                                 values, frameStatistics[frame],
+                                 cellStatistics + frame * cellCount);
+                },
+                brion::Executor::Priority::bulk));
+        }
+        // The tasks refer to this stack frame, wait for all of them before
+        // rethrowing the first exception
+        for (auto& task : tasks)
+            task.wait();
+        for (auto& task : tasks)
+            task.get();
+    }
+
+    void _compute(const brion::CompartmentReport& report, const float* data,
+                  floats& values, ValueStatistics& frameStatistics,
+                  ValueStatistics* cellStatistics) const
+    {
+        values.assign(data, data + report.getFrameSize());
+        frameStatistics =
+            _computeStatistics(values.data(), values.data() + values.size());
+
+        const auto& offsets = report.getOffsets();
+        const auto& counts = report.getCompartmentCounts();
+        for (size_t i = 0; i < report.getCellCount(); ++i)
+        {
+            values.clear();
+            for (size_t j = 0; j < counts[i].size(); ++j)
+            {
+                // The offsets of sections without compartments are undefined
+                if (counts[i][j] == 0)
+                    continue;
+                const float* section = data + offsets[i][j];
+                values.insert(values.end(), section, section + counts[i][j]);
+            }
+            cellStatistics[i] = _computeStatistics(values.data(),
+                                                   values.data() +
+                                                       values.size());
+        }
+    }
+};
+}
+
+CompartmentReportStatistics::CompartmentReportStatistics(
+    const URI& uri, const std::string& path, const bool compute)
+    : _impl(new detail::CompartmentReportStatistics(uri, path, compute))
+{
+}
+
+CompartmentReportStatistics::~CompartmentReportStatistics()
+{
+}
+
+const uint32_ts& CompartmentReportStatistics::getGIDs() const
+{
+    return _impl->gids;
+}
+
+size_t CompartmentReportStatistics::getCellCount() const
+{
+    return _impl->header.cellCount;
+}
+
+size_t CompartmentReportStatistics::getFrameCount() const
+{
+    return _impl->header.frameCount;
+}
+
+size_t CompartmentReportStatistics::getFrameSize() const
+{
+    return _impl->header.frameSize;
+}
+
+double CompartmentReportStatistics::getStartTime() const
+{
+    return _impl->header.startTime;
+}
+
+double CompartmentReportStatistics::getTimestep() const
+{
+    return _impl->header.timestep;
+}
+
+const ValueStatistics& CompartmentReportStatistics::getFrameStatistics(
+    const size_t frame) const
+{
+    _impl->checkFrame(frame);
+    return _impl->frames[frame];
+}
+
+const ValueStatistics* CompartmentReportStatistics::getCellStatistics(
+    const size_t frame) const
+{
+    _impl->checkFrame(frame);
+    return _impl->cells + frame * _impl->header.cellCount;
+}
+
+std::pair<float, float> CompartmentReportStatistics::getRange() const
+{
+    return _impl->range;
+}
+
+const std::string& CompartmentReportStatistics::getPath() const
+{
+    return _impl->path;
+}
+}
@@ -0,0 +1,137 @@
+/* Copyright (c) 2018, EPFL/Blue Brain Project
+ *
+ * This file is part of Brion <https://github.com/BlueBrain/Brion>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef BRION_COMPARTMENTREPORTSTATISTICS_H
+#define BRION_COMPARTMENTREPORTSTATISTICS_H
+
+#include <brion/api.h>
+#include <brion/types.h>
+
+#include <boost/noncopyable.hpp>
+
+namespace brion
+{
+namespace detail
+{
+class CompartmentReportStatistics;
+}
+
+/** The statistics of a set of values. @version 3.0 */
+struct ValueStatistics
+{
+    float min;
+    float max;
+    float mean;
+    /** The 5th percentile, by nearest rank */
+    float p5;
+    /** The 50th percentile, by nearest rank */
+    float median;
+    /** The 95th percentile, by nearest rank */
+    float p95;
+};
+
+/**
+ * Per-frame statistics of the values of a compartment report.
+ *
+ * The statistics are computed for each frame over the whole frame and over
+ * the compartments of each cell of the report. They are stored in a sidecar
+ * file next to the report, which is memory mapped when the statistics are
+ * opened again, so that e.g. the color map range of a viewer is available
+ * without reading the report.
+ *
+ * A sidecar file older than the report, or with another number of frames,
+ * cells or values per frame, or another start time or timestep than the
+ * report, is ignored. If there is no up to date sidecar file, the statistics
+ * are computed in one pass over all the frames and cells of the report and
+ * streamed to it window by window, only the statistics of the frames are kept
+ * in memory. If it can't be written, e.g. in a read-only directory, the
+ * statistics are written to a temporary file instead, which is removed with
+ * this object.
+ */
+class CompartmentReportStatistics : public boost::noncopyable
+{
+public:
+    /**
+     * Open the statistics of a compartment report.
+     *
+     * @param uri the URI of the compartment report
+     * @param path the path of the sidecar file, by default the path of the
+     *        report with a ".stats" extension appended. Reports not stored
+     *        in a file need an explicit path to be persisted.
+     * @param compute if false, throw instead of computing the statistics when
+     *        there is no up to date sidecar file
+     * @throw std::runtime_error if the statistics can't be loaded nor
+     *        computed
+     * @version 3.0
+     */
+    BRION_API explicit CompartmentReportStatistics(
+        const URI& uri, const std::string& path = std::string(),
+        bool compute = true);
+
+    /** @version 3.0 */
+    BRION_API ~CompartmentReportStatistics();
+
+    /** @return the GIDs of the cells, in the order of getCellStatistics().
+     *  @version 3.0 */
+    BRION_API const uint32_ts& getGIDs() const;
+
+    /** @return the number of cells. @version 3.0 */
+    BRION_API size_t getCellCount() const;
+
+    /** @return the number of frames. @version 3.0 */
+    BRION_API size_t getFrameCount() const;
+
+    /** @return the number of values of a frame. @version 3.0 */
+    BRION_API size_t getFrameSize() const;
+
+    /** @return the timestamp of the first frame. @version 3.0 */
+    BRION_API double getStartTime() const;
+
+    /** @return the time between two frames. @version 3.0 */
+    BRION_API double getTimestep() const;
+
+    /**
+     * @return the statistics of all the values of a frame.
+     * @throw std::logic_error if frame >= getFrameCount()
+     * @version 3.0
+     */
+    BRION_API const ValueStatistics& getFrameStatistics(size_t frame) const;
+
+    /**
+     * @return the statistics of the values of each cell in a frame, an array
+     *         of getCellCount() elements in the order of getGIDs(). The
+     *         statistics of cells without compartments are NaN.
+     * @throw std::logic_error if frame >= getFrameCount()
+     * @version 3.0
+     */
+    BRION_API const ValueStatistics* getCellStatistics(size_t frame) const;
+
+    /** @return the minimum and maximum of all the values of the report.
+     *  @version 3.0 */
+    BRION_API std::pair<float, float> getRange() const;
+
+    /** @return the path of the sidecar file, empty if the statistics are not
+     *  persisted. @version 3.0 */
+    BRION_API const std::string& getPath() const;
+
+private:
+    std::unique_ptr<detail::CompartmentReportStatistics> _impl;
+};
+}
+
+#endif
@@ -0,0 +1,91 @@
+/* Copyright (c) 2018, EPFL/Blue Brain Project
+ *
+ * This file is part of Brion <https://github.com/BlueBrain/Brion>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef BRION_DETAIL_ATOMICFILE
+#define BRION_DETAIL_ATOMICFILE
+
+#include <boost/filesystem.hpp>
+#include <boost/noncopyable.hpp>
+
+#include <fstream>
+#include <string>
+
+namespace brion
+{
+namespace detail
+{
+/**
+ * A binary file written next to its path and renamed to it on commit, so that
+ * concurrent readers never see a partial file, e.g. a sidecar of a report.
+ *
+ * The temporary file is removed if the file is not committed.
+ */
+class AtomicFile : public boost::noncopyable
+{
+public:
+    explicit AtomicFile(const std::string& path)
+        : _path(path)
+    {
+        boost::system::error_code error;
+        _tmpPath = boost::filesystem::unique_path(path + ".%%%%-%%%%-%%%%",
+                                                  error);
+        if (error)
+            stream.setstate(std::ios::failbit);
+        else
+            stream.open(_tmpPath.string(), std::ios::binary);
+    }
+
+    ~AtomicFile()
+    {
+        if (_committed || _tmpPath.empty())
+            return;
+        stream.close();
+        boost::system::error_code error;
+        boost::filesystem::remove(_tmpPath, error);
+    }
+
+    /**
+     * Close the file and rename it to its path.
+     *
+     * @return false if the file could not be written or renamed, e.g. if its
+     *         directory is read-only.
+     */
+    bool commit()
+    {
+        if (stream)
+            stream.close();
+        if (!stream)
+            return false;
+        boost::system::error_code error;
+        boost::filesystem::rename(_tmpPath, _path, error);
+        _committed = !error;
+        return _committed;
+    }
+
+    /** The stream to write the content of the file to. */
+    std::ofstream stream;
+
+private:
+    const std::string _path;
+    boost::filesystem::path _tmpPath;
+    bool _committed = false;
+};
+}
+}
+
+#endif
@@ -0,0 +1,98 @@
+/* Copyright (c) 2018, EPFL/Blue Brain Project
+ *
+ * This file is part of Brion <https://github.com/BlueBrain/Brion>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef BRION_DETAIL_FRAMEWINDOW
+#define BRION_DETAIL_FRAMEWINDOW
+
+#include <brion/types.h>
+
+#include <lunchbox/debug.h>
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+namespace brion
+{
+namespace detail
+{
+/** Upper bound of the number of values of a window of frames. */
+constexpr size_t maxValuesPerWindow = 1 << 24;
+
+/**
+ * @return a number of frames rounded to the nearest integer if it is close
+ *         enough, against the rounding errors of the times.
+ */
+inline double snapFrames(const double frames)
+{
+    const double nearest = std::round(frames);
+    const double epsilon = 1e-6 * std::max(1., std::abs(nearest));
+    return std::abs(frames - nearest) < epsilon ? nearest : frames;
+}
+
+/**
+ * @return the number of frames of a window of at most maxValues values, but
+ *         at least minFrames.
+ */
+inline int64_t getWindowSize(const size_t valuesPerFrame,
+                             const size_t minFrames = 1,
+                             const size_t maxValues = maxValuesPerWindow)
+{
+    return std::max(minFrames,
+                    maxValues / std::max(size_t(1), valuesPerFrame));
+}
+
+/**
+ * Load the frames [begin, end) of a report.
+ *
+ * Requesting times in the middle of the frames avoids rounding issues.
+ *
+ * @param load the function loading the frames of a time window, e.g.
+ *        CompartmentReport::loadFrames()
+ * @return the future result of load
+ */
+template <typename F>
+auto loadFrameWindow(const F& load, const double startTime,
+                     const double timestep, const int64_t begin,
+                     const int64_t end) -> decltype(load(0., 0.))
+{
+    return load(startTime + (begin + 0.25) * timestep,
+                startTime + (end - 0.25) * timestep);
+}
+
+/**
+ * Check that a window of frames was loaded completely.
+ *
+ * @param time the start time of the window, for the error message
+ * @throw std::runtime_error if frames doesn't have numFrames frames
+ */
+inline void checkFrameWindow(const Frames& frames, const size_t numFrames,
+                             const size_t frameSize, const double time)
+{
+    if (!frames.data || !frames.timeStamps ||
+        frames.timeStamps->size() != numFrames ||
+        frames.data->size() != numFrames * frameSize)
+    {
+        LBTHROW(std::runtime_error("Could not load the frames at " +
+                                   std::to_string(time)));
+    }
+}
+}
+}
+
+#endif
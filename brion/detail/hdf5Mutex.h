@@ -20,6 +20,8 @@
 #ifndef BRION_DETAIL_HDF5MUTEX
 #define BRION_DETAIL_HDF5MUTEX
 
+#include "trace.h"
+
 #include <mutex>
 
 namespace brion
@@ -34,6 +36,23 @@ inline std::mutex& hdf5Mutex()
     static std::mutex _hdf5Mutex;
     return _hdf5Mutex;
 }
+
+/** Scoped lock of hdf5Mutex() which traces the time spent waiting for it. */
+class HDF5Lock
+{
+public:
+    HDF5Lock()
+        : _lock(hdf5Mutex(), std::try_to_lock)
+    {
+        if (_lock.owns_lock())
+            return;
+        BRION_TRACE("HDF5 lock wait", "lock");
+        _lock.lock();
+    }
+
+private:
+    std::unique_lock<std::mutex> _lock;
+};
 }
 }
 
@@ -0,0 +1,122 @@
+/* Copyright (c) 2018, EPFL/Blue Brain Project
+ *
+ * This file is part of Brion <https://github.com/BlueBrain/Brion>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef BRION_DETAIL_IOCOUNTERS
+#define BRION_DETAIL_IOCOUNTERS
+
+#include "trace.h"
+
+#include <brion/types.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
+namespace brion
+{
+namespace detail
+{
+/** Thread-safe accumulators backing brion::IOStatistics. Times are kept in
+ *  nanoseconds. */
+class IOCounters
+{
+public:
+    std::atomic<uint64_t> bytesRequested{0};
+    std::atomic<uint64_t> bytesRead{0};
+    std::atomic<uint64_t> readOperations{0};
+    std::atomic<uint64_t> cacheHits{0};
+    std::atomic<uint64_t> cacheMisses{0};
+    std::atomic<uint64_t> lockWaitTime{0};
+    std::atomic<uint64_t> decodeTime{0};
+
+    /** Account one read operation of the given size from storage. */
+    void addRead(const uint64_t bytes)
+    {
+        bytesRead += bytes;
+        ++readOperations;
+    }
+
+    IOStatistics get() const
+    {
+        IOStatistics stats;
+        stats.bytesRequested = bytesRequested;
+        stats.bytesRead = bytesRead;
+        stats.readOperations = readOperations;
+        stats.cacheHits = cacheHits;
+        stats.cacheMisses = cacheMisses;
+        stats.lockWaitTime = lockWaitTime / 1e6;
+        stats.decodeTime = decodeTime / 1e6;
+        return stats;
+    }
+
+    void reset()
+    {
+        bytesRequested = 0;
+        bytesRead = 0;
+        readOperations = 0;
+        cacheHits = 0;
+        cacheMisses = 0;
+        lockWaitTime = 0;
+        decodeTime = 0;
+    }
+};
+
+/** Adds the lifetime of the object in nanoseconds to the given counter. */
+class ScopedTimer
+{
+public:
+    explicit ScopedTimer(std::atomic<uint64_t>& counter)
+        : _counter(counter)
+        , _start(std::chrono::steady_clock::now())
+    {
+    }
+
+    ~ScopedTimer()
+    {
+        _counter += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now() - _start)
+                        .count();
+    }
+
+private:
+    std::atomic<uint64_t>& _counter;
+    const std::chrono::steady_clock::time_point _start;
+};
+
+/** Scoped lock which accounts and traces the time spent waiting for the
+ *  mutex. The uncontended case does not query the clock. */
+class CountedLock
+{
+public:
+    CountedLock(std::mutex& mutex, IOCounters& counters)
+        : _lock(mutex, std::try_to_lock)
+    {
+        if (_lock.owns_lock())
+            return;
+        BRION_TRACE("HDF5 lock wait", "lock");
+        ScopedTimer timer(counters.lockWaitTime);
+        _lock.lock();
+    }
+
+private:
+    std::unique_lock<std::mutex> _lock;
+};
+}
+}
+
+#endif
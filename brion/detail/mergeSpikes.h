@@ -0,0 +1,68 @@
+/* Copyright (c) 2018, EPFL/Blue Brain Project
+ *
+ * This file is part of Brion <https://github.com/BlueBrain/Brion>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef BRION_DETAIL_MERGESPIKES
+#define BRION_DETAIL_MERGESPIKES
+
+#include <brion/types.h>
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+namespace brion
+{
+namespace detail
+{
+/** A [begin, end) range of spikes sorted by time. */
+using SpikeRange = std::pair<const Spike*, const Spike*>;
+
+/** Merge sorted ranges of spikes into out with a k-way merge. */
+inline void mergeSpikes(const std::vector<SpikeRange>& ranges, Spike* out)
+{
+    using Head = std::pair<Spike, size_t>; // next spike and its range
+    std::vector<Head> heap;
+    std::vector<const Spike*> positions;
+    for (size_t i = 0; i < ranges.size(); ++i)
+    {
+        positions.push_back(ranges[i].first);
+        if (ranges[i].first != ranges[i].second)
+            heap.emplace_back(*ranges[i].first, i);
+    }
+
+    const std::greater<Head> compare;
+    std::make_heap(heap.begin(), heap.end(), compare);
+    while (!heap.empty())
+    {
+        std::pop_heap(heap.begin(), heap.end(), compare);
+        Head& head = heap.back();
+        *out++ = head.first;
+        const size_t i = head.second;
+        if (++positions[i] != ranges[i].second)
+        {
+            head.first = *positions[i];
+            std::push_heap(heap.begin(), heap.end(), compare);
+        }
+        else
+            heap.pop_back();
+    }
+}
+}
+}
+
+#endif
@@ -0,0 +1,264 @@
+/* Copyright (c) 2018, EPFL/Blue Brain Project
+ *
+ * This file is part of Brion <https://github.com/BlueBrain/Brion>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef BRION_DETAIL_TRACE
+#define BRION_DETAIL_TRACE
+
+#include <brion/api.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace brion
+{
+namespace detail
+{
+/**
+ * Collects scoped events and writes them in the Chrome trace event format,
+ * which can be loaded in chrome://tracing or https://ui.perfetto.dev.
+ *
+ * Tracing is enabled at startup if the BRION_TRACE environment variable
+ * names an output file, or later on with brion::startTracing(). The events
+ * are written when tracing is stopped or at exit.
+ *
+ * The class is header only because it is used by Brion, BrionPlugins and
+ * Brain alike, but its instance is defined once in BrionRuntime. Each of these
+ * libraries would have its own instance otherwise.
+ */
+class Tracer
+{
+public:
+    /** Maximum number of buffered events, later events are dropped. */
+    static constexpr size_t maxEvents = 1 << 22;
+
+    Tracer()
+        : _epoch(std::chrono::steady_clock::now())
+    {
+        const char* filename = ::getenv("BRION_TRACE");
+        if (filename && *filename)
+            start(filename);
+    }
+
+    ~Tracer() { stop(); }
+
+    bool isEnabled() const { return _enabled.load(std::memory_order_relaxed); }
+
+    void start(const std::string& filename)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _filename = filename;
+        _events.clear();
+        _dropped = 0;
+        _enabled = true;
+    }
+
+    /** Stop recording and write the recorded events to the output file. */
+    void stop()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_enabled)
+            return;
+        _enabled = false;
+        _write();
+        _events.clear();
+    }
+
+    /** @return microseconds since the creation of the tracer. */
+    uint64_t now() const
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+                   std::chrono::steady_clock::now() - _epoch)
+            .count();
+    }
+
+    void record(const char* name, const char* category, std::string&& detail,
+                const uint64_t start, const uint64_t duration)
+    {
+        const uint32_t thread = _threadID();
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_enabled)
+            return;
+        if (_events.size() == maxEvents)
+        {
+            ++_dropped;
+            return;
+        }
+        _events.push_back(
+            {name, category, std::move(detail), start, duration, thread});
+    }
+
+private:
+    struct Event
+    {
+        const char* name;
+        const char* category;
+        std::string detail;
+        uint64_t start;
+        uint64_t duration;
+        uint32_t thread;
+    };
+
+    const std::chrono::steady_clock::time_point _epoch;
+    std::atomic<bool> _enabled{false};
+    std::mutex _mutex;
+    std::string _filename;
+    std::vector<Event> _events;
+    size_t _dropped = 0;
+
+    static uint32_t _threadID()
+    {
+        // Small sequential IDs give a more readable timeline than the native
+        // thread handles.
+        static std::atomic<uint32_t> counter{0};
+        static thread_local const uint32_t id = ++counter;
+        return id;
+    }
+
+    static std::string _escape(const std::string& in)
+    {
+        std::string out;
+        out.reserve(in.size());
+        for (const char c : in)
+        {
+            switch (c)
+            {
+            case '"':
+                out += "\\\"";
+                break;
+            case '\\':
+                out += "\\\\";
+                break;
+            case '\n':
+                out += "\\n";
+                break;
+            case '\t':
+                out += "\\t";
+                break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20)
+                    break;
+                out += c;
+            }
+        }
+        return out;
+    }
+
+    void _write() const
+    {
+        std::ofstream out(_filename);
+        if (!out)
+        {
+            std::fprintf(stderr, "Failed to write Brion trace to %s\n",
+                         _filename.c_str());
+            return;
+        }
+#ifdef _WIN32
+        const int pid = _getpid();
+#else
+        const int pid = ::getpid();
+#endif
+        out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        bool first = true;
+        for (const auto& event : _events)
+        {
+            out << (first ? "" : ",") << "\n{\"name\":\"" << event.name
+                << "\",\"cat\":\"" << event.category
+                << "\",\"ph\":\"X\",\"ts\":" << event.start
+                << ",\"dur\":" << event.duration << ",\"pid\":" << pid
+                << ",\"tid\":" << event.thread;
+            if (!event.detail.empty())
+                out << ",\"args\":{\"detail\":\"" << _escape(event.detail)
+                    << "\"}";
+            out << "}";
+            first = false;
+        }
+        out << "\n],\"otherData\":{\"droppedEvents\":" << _dropped << "}}\n";
+    }
+};
+
+/** @return the tracer shared by Brion, BrionPlugins and Brain. */
+BRION_API Tracer& tracer();
+
+/**
+ * Records a complete event spanning the lifetime of the object. Does nothing
+ * but checking a flag if tracing is disabled. The name and category must be
+ * string literals.
+ */
+class ScopedTraceEvent
+{
+public:
+    ScopedTraceEvent(const char* name, const char* category)
+        : _name(name)
+        , _category(category)
+        , _start(tracer().isEnabled() ? tracer().now() : _disabled)
+    {
+    }
+
+    /** @param detail free text added as argument to the event */
+    ScopedTraceEvent(const char* name, const char* category,
+                     std::string detail)
+        : ScopedTraceEvent(name, category)
+    {
+        if (_start != _disabled)
+            _detail = std::move(detail);
+    }
+
+    ~ScopedTraceEvent()
+    {
+        if (_start == _disabled)
+            return;
+        auto& t = tracer();
+        t.record(_name, _category, std::move(_detail), _start,
+                 t.now() - _start);
+    }
+
+private:
+    enum : uint64_t
+    {
+        _disabled = ~uint64_t(0)
+    };
+
+    const char* const _name;
+    const char* const _category;
+    const uint64_t _start;
+    std::string _detail;
+};
+}
+}
+
+#define BRION_TRACE_CONCAT_(a, b) a##b
+#define BRION_TRACE_CONCAT(a, b) BRION_TRACE_CONCAT_(a, b)
+
+/** Trace the enclosing scope, e.g. BRION_TRACE("loadFrame", "report") */
+#define BRION_TRACE(...)                  \
+    ::brion::detail::ScopedTraceEvent     \
+        BRION_TRACE_CONCAT(_brionTrace, __LINE__)(__VA_ARGS__)
+
+#endif
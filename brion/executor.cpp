@@ -0,0 +1,246 @@
+/* Copyright (c) 2018, EPFL/Blue Brain Project
+ *
+ * This file is part of Brion <https://github.com/BlueBrain/Brion>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "executor.h"
+
+#include "detail/trace.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace brion
+{
+namespace
+{
+thread_local const brion::Executor* _currentExecutor = nullptr;
+
+std::mutex _defaultMutex;
+std::shared_ptr<Executor> _defaultExecutor;
+}
+
+namespace detail
+{
+class Executor
+{
+public:
+    using Task = std::function<void()>;
+    using Priority = brion::Executor::Priority;
+
+    Executor(const brion::Executor& owner, const size_t numThreads,
+             const size_t maxQueueSize_)
+        : maxQueueSize(maxQueueSize_)
+    {
+        const size_t size =
+            numThreads ? numThreads
+                       : std::max(1u, std::thread::hardware_concurrency());
+        // Keep one thread available for interactive tasks
+        bulkLimit = size > 1 ? size - 1 : 1;
+
+        threads.reserve(size);
+        for (size_t i = 0; i < size; ++i)
+            threads.emplace_back([this, &owner] { _run(owner); });
+    }
+
+    ~Executor()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            running = false;
+        }
+        workAvailable.notify_all();
+        for (auto& thread : threads)
+            thread.join();
+    }
+
+    void post(Task&& task, const Priority priority)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        auto& queue = queues[size_t(priority)];
+        if (maxQueueSize > 0 && queue.size() >= maxQueueSize)
+        {
+            BRION_TRACE("Executor queue full", "executor");
+            spaceAvailable.wait(lock, [&] {
+                return queue.size() < maxQueueSize;
+            });
+        }
+        queue.push_back(std::move(task));
+        lock.unlock();
+        workAvailable.notify_one();
+    }
+
+    const size_t maxQueueSize;
+    size_t bulkLimit;
+    std::vector<std::thread> threads;
+
+    mutable std::mutex mutex;
+    std::condition_variable workAvailable;
+    std::condition_variable spaceAvailable;
+    std::deque<Task> queues[2];
+    size_t active = 0;
+    size_t activeBulk = 0;
+    bool running = true;
+
+private:
+    std::deque<Task>& _interactive()
+    {
+        return queues[size_t(Priority::interactive)];
+    }
+    std::deque<Task>& _bulk() { return queues[size_t(Priority::bulk)]; }
+    bool _canRunBulk() { return !_bulk().empty() && activeBulk < bulkLimit; }
+
+    void _run(const brion::Executor& owner)
+    {
+        _currentExecutor = &owner;
+        for (;;)
+        {
+            Task task;
+            bool bulk = false;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                workAvailable.wait(lock, [&] {
+                    return !running || !_interactive().empty() ||
+                           _canRunBulk();
+                });
+
+                if (!_interactive().empty())
+                {
+                    task = std::move(_interactive().front());
+                    _interactive().pop_front();
+                }
+                else if (_canRunBulk())
+                {
+                    task = std::move(_bulk().front());
+                    _bulk().pop_front();
+                    bulk = true;
+                    ++activeBulk;
+                }
+                else
+                    return; // stopped and no work left for this thread
+                ++active;
+            }
+            spaceAvailable.notify_all();
+
+            {
+                BRION_TRACE("Executor::run", "executor",
+                            bulk ? "bulk" : "interactive");
+                task();
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            --active;
+            if (bulk)
+            {
+                --activeBulk;
+                workAvailable.notify_one();
+            }
+        }
+    }
+};
+}
+
+Executor::Executor(const size_t numThreads, const size_t maxQueueSize)
+    : _impl(new detail::Executor(*this, numThreads, maxQueueSize))
+{
+}
+
+Executor::~Executor()
+{
+    delete _impl;
+}
+
+std::shared_ptr<Executor> Executor::getDefault()
+{
+    std::lock_guard<std::mutex> lock(_defaultMutex);
+    if (!_defaultExecutor)
+        _defaultExecutor = std::make_shared<Executor>();
+    return _defaultExecutor;
+}
+
+void Executor::setDefault(std::shared_ptr<Executor> executor)
+{
+    std::shared_ptr<Executor> previous;
+    {
+        std::lock_guard<std::mutex> lock(_defaultMutex);
+        previous = std::move(_defaultExecutor);
+        _defaultExecutor = std::move(executor);
+    }
+    // previous is released outside of the lock, as it may join its threads
+}
+
+size_t Executor::getSize() const
+{
+    return _impl->threads.size();
+}
+
+bool Executor::hasPendingJobs() const
+{
+    std::lock_guard<std::mutex> lock(_impl->mutex);
+    return _impl->active > 0 || !_impl->queues[0].empty() ||
+           !_impl->queues[1].empty();
+}
+
+bool Executor::isWorkerThread() const
+{
+    return _currentExecutor == this;
+}
+
+bool Executor::setAffinity(const size_ts& cpus)
+{
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (const auto cpu : cpus)
+    {
+        if (cpu < CPU_SETSIZE)
+            CPU_SET(cpu, &set);
+    }
+
+    bool success = true;
+    for (auto& thread : _impl->threads)
+    {
+        if (::pthread_setaffinity_np(thread.native_handle(), sizeof(set),
+                                     &set) != 0)
+        {
+            success = false;
+        }
+    }
+    return success;
+#else
+    (void)cpus;
+    return false;
+#endif
+}
+
+void Executor::_post(std::function<void()>&& task, const Priority priority)
+{
+    if (isWorkerThread())
+    {
+        task();
+        return;
+    }
+    _impl->post(std::move(task), priority);
+}
+}
@@ -0,0 +1,139 @@
+/* Copyright (c) 2018, EPFL/Blue Brain Project
+ *
+ * This file is part of Brion <https://github.com/BlueBrain/Brion>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef BRION_EXECUTOR
+#define BRION_EXECUTOR
+
+#include <brion/api.h>
+#include <brion/types.h>
+
+#include <boost/noncopyable.hpp>
+
+#include <functional>
+#include <future>
+#include <memory>
+
+namespace brion
+{
+namespace detail
+{
+class Executor;
+}
+
+/**
+ * Thread pool executing the asynchronous operations of Brion and Brain.
+ *
+ * Tasks are queued in one of two lanes. Interactive tasks, such as frame
+ * loading, are always dequeued before bulk tasks, such as morphology or
+ * synapse loading. With more than one thread, one thread is kept free of
+ * bulk tasks so that a large bulk load can not delay interactive requests
+ * queued behind it.
+ *
+ * Posting a task from one of the threads of the executor runs it directly in
+ * the calling thread, which avoids deadlocks when tasks wait for the result
+ * of other tasks.
+ *
+ * All asynchronous loaders use getDefault(), which can be replaced with an
+ * executor configured for the application using setDefault().
+ */
+class Executor : public boost::noncopyable
+{
+public:
+    /** The lane of a task. @version 3.0 */
+    enum class Priority
+    {
+        interactive,
+        bulk
+    };
+
+    /**
+     * Create a new executor.
+     *
+     * @param numThreads the number of worker threads, 0 for one thread per
+     *        hardware thread.
+     * @param maxQueueSize the maximum number of queued tasks per lane, 0 for
+     *        unbounded queues. Posting to a full lane blocks until a task has
+     *        been dequeued.
+     * @version 3.0
+     */
+    BRION_API explicit Executor(size_t numThreads = 0,
+                                size_t maxQueueSize = 0);
+
+    /** Finish all queued tasks and join the threads. @version 3.0 */
+    BRION_API ~Executor();
+
+    /** @return the executor used by all asynchronous loaders. @version 3.0 */
+    BRION_API static std::shared_ptr<Executor> getDefault();
+
+    /**
+     * Replace the executor used by all asynchronous loaders.
+     *
+     * Tasks already posted to the previous executor are completed by it.
+     * @param executor the new default executor, nullptr to restore a default
+     *        executor with one thread per hardware thread.
+     * @version 3.0
+     */
+    BRION_API static void setDefault(std::shared_ptr<Executor> executor);
+
+    /**
+     * Queue a task for execution.
+     *
+     * @param task the callable to execute
+     * @param priority the lane of the task
+     * @return the future result of the task
+     * @version 3.0
+     */
+    template <typename F>
+    std::future<typename std::result_of<F()>::type> post(
+        F&& task, const Priority priority = Priority::interactive)
+    {
+        using Result = typename std::result_of<F()>::type;
+        auto packaged = std::make_shared<std::packaged_task<Result()>>(
+            std::forward<F>(task));
+        auto future = packaged->get_future();
+        _post([packaged] { (*packaged)(); }, priority);
+        return future;
+    }
+
+    /** @return the number of worker threads. @version 3.0 */
+    BRION_API size_t getSize() const;
+
+    /** @return true if tasks are queued or running. @version 3.0 */
+    BRION_API bool hasPendingJobs() const;
+
+    /** @return true if called from a thread of this executor. @version 3.0 */
+    BRION_API bool isWorkerThread() const;
+
+    /**
+     * Restrict the worker threads to the given CPUs.
+     *
+     * @param cpus the indices of the allowed CPUs
+     * @return false if not supported on this platform or if the affinity
+     *         could not be set.
+     * @version 3.0
+     */
+    BRION_API bool setAffinity(const size_ts& cpus);
+
+private:
+    detail::Executor* _impl;
+
+    BRION_API void _post(std::function<void()>&& task, Priority priority);
+};
+}
+
+#endif
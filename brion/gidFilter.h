@@ -0,0 +1,178 @@
+/* Copyright (c) 2018, EPFL/Blue Brain Project
+ *
+ * This file is part of Brion <https://github.com/BlueBrain/Brion>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef BRION_GIDFILTER
+#define BRION_GIDFILTER
+
+#include <brion/types.h>
+
+#include <algorithm>
+
+namespace brion
+{
+/**
+ * Set of GIDs compiled into a bitmap for fast membership tests.
+ *
+ * The bitmap covers the range between the smallest and the largest GID in
+ * pages of 64K bits. Only the pages containing at least one GID are
+ * allocated, all other pages share a single empty page, so sparse sets of high
+ * GIDs stay small. Lookups do not branch, which lets the compiler vectorize
+ * the batch filter functions.
+ *
+ * An empty filter accepts all GIDs.
+ */
+class GIDFilter
+{
+public:
+    /** Create a filter accepting all GIDs. @version 3.0 */
+    GIDFilter() {}
+
+    /** Create a filter accepting the given GIDs only. @version 3.0 */
+    explicit GIDFilter(const GIDSet& gids)
+    {
+        if (gids.empty())
+            return;
+
+        _first = *gids.begin();
+        const size_t numPages = ((*gids.rbegin() - _first) >> _pageBits) + 1;
+        // The extra entry maps all GIDs past the last page to the empty page
+        _pages.resize(numPages + 1, 0);
+        _words.resize(size_t(_pageWords), 0);
+
+        for (const uint32_t gid : gids)
+        {
+            const uint32_t offset = gid - _first;
+            uint32_t& page = _pages[offset >> _pageBits];
+            if (page == 0)
+            {
+                page = uint32_t(_words.size() / _pageWords);
+                _words.resize(_words.size() + _pageWords, 0);
+            }
+            _words[_wordIndex(page, offset)] |= uint64_t(1) << (offset & 63);
+        }
+    }
+
+    /** @return true if all GIDs are accepted. @version 3.0 */
+    bool empty() const { return _pages.empty(); }
+
+    /** @return true if the given GID is accepted. @version 3.0 */
+    bool contains(const uint32_t gid) const
+    {
+        return empty() || _test(gid);
+    }
+
+    /**
+     * Append the accepted spikes to a container.
+     *
+     * @param spikes the spikes to filter
+     * @param size the number of spikes
+     * @param out the container to append the accepted spikes to
+     * @version 3.0
+     */
+    void filter(const Spike* spikes, const size_t size, Spikes& out) const
+    {
+        if (empty())
+        {
+            out.insert(out.end(), spikes, spikes + size);
+            return;
+        }
+
+        _filter(size, out, [spikes](const size_t i) { return spikes[i]; });
+    }
+
+    /**
+     * Append the accepted spikes given as separate arrays to a container.
+     *
+     * @param timestamps the spike times
+     * @param gids the spike GIDs
+     * @param size the number of spikes
+     * @param out the container to append the accepted spikes to
+     * @version 3.0
+     */
+    void filter(const float* timestamps, const uint32_t* gids,
+                const size_t size, Spikes& out) const
+    {
+        if (empty())
+        {
+            const size_t first = out.size();
+            out.resize(first + size);
+            Spike* next = out.data() + first;
+            for (size_t i = 0; i < size; ++i)
+                next[i] = Spike(timestamps[i], gids[i]);
+            return;
+        }
+
+        _filter(size, out, [timestamps, gids](const size_t i) {
+            return Spike(timestamps[i], gids[i]);
+        });
+    }
+
+private:
+    static constexpr uint32_t _pageBits = 16;
+    // The output grows by at most this many spikes before being compacted
+    static constexpr size_t _chunkSize = 65536;
+    static constexpr uint32_t _pageWords = (1 << _pageBits) / 64;
+
+    uint32_t _first = 0;
+    // Page of each 64K GID range in _words, page 0 is always empty
+    std::vector<uint32_t> _pages;
+    std::vector<uint64_t> _words;
+
+    static size_t _wordIndex(const uint32_t page, const uint32_t offset)
+    {
+        return size_t(page) * _pageWords +
+               ((offset >> 6) & (_pageWords - 1));
+    }
+
+    template <typename F>
+    void _filter(const size_t size, Spikes& out, const F& getSpike) const
+    {
+        // Write every spike and only advance past the accepted ones, which
+        // avoids a data dependent branch per spike. The input is processed
+        // in chunks, as a few accepted spikes of a large input would
+        // otherwise need room for the whole input.
+        for (size_t start = 0; start < size; start += _chunkSize)
+        {
+            const size_t end = std::min(start + _chunkSize, size);
+            const size_t first = out.size();
+            out.resize(first + end - start);
+            Spike* next = out.data() + first;
+            for (size_t i = start; i < end; ++i)
+            {
+                const Spike spike = getSpike(i);
+                *next = spike;
+                next += _test(spike.second);
+            }
+            out.resize(next - out.data());
+        }
+    }
+
+    bool _test(const uint32_t gid) const
+    {
+        // GIDs below _first wrap around to offsets past the last GID, whose
+        // bits are never set.
+        const uint32_t offset = gid - _first;
+        const size_t page =
+            std::min(size_t(offset >> _pageBits), _pages.size() - 1);
+        return (_words[_wordIndex(_pages[page], offset)] >> (offset & 63)) &
+               1;
+    }
+};
+}
+
+#endif
@@ -19,11 +19,13 @@
 
 #include "morphology.h"
 
+#include "executor.h"
 #include "morphologyPlugin.h"
 
+#include "detail/trace.h"
+
 #include <lunchbox/plugin.h>
 #include <lunchbox/pluginFactory.h>
-#include <lunchbox/threadPool.h>
 
 #include <mutex>
 
@@ -69,13 +71,17 @@ public:
     explicit Impl(const MorphologyInitData& initData)
         : plugin(MorphologyPluginFactory::getInstance().create(initData))
     {
-        loadFuture = lunchbox::ThreadPool::getInstance().post([&] {
+        auto task = [&] {
+            BRION_TRACE("Morphology::load", "morphology",
+                        std::to_string(plugin->getInitData().getURI()));
             plugin->load();
             if (plugin->getPoints().empty())
                 LBTHROW(std::runtime_error(
                     "Failed to load morphology " +
                     std::to_string(plugin->getInitData().getURI())));
-        });
+        };
+        loadFuture =
+            Executor::getDefault()->post(task, Executor::Priority::bulk);
     }
 
     Impl(const Morphology& from)
@@ -19,16 +19,20 @@
 
 #include "compartmentReportBinary.h"
 
+#include "../detail/trace.h"
+
 #include <lunchbox/debug.h>
 #include <lunchbox/intervalSet.h>
 #include <lunchbox/log.h>
 #include <lunchbox/memoryMap.h>
 #include <lunchbox/pluginRegisterer.h>
 
+#include <boost/filesystem/operations.hpp>
 #include <boost/filesystem/path.hpp>
 
 #include <map>
 
+#include <cmath>
 #include <cstdio>
 
 #if defined __linux__ || defined __APPLE__
@@ -237,6 +241,7 @@ CompartmentReportBinary::CompartmentReportBinary(
     : _path(initData.getURI().getPath())
     , _startTime(0)
     , _endTime(0)
+    , _headerEndTime(0)
     , _timestep(0)
     , _header()
     , _subtarget(false)
@@ -274,6 +279,8 @@ CompartmentReportBinary::CompartmentReportBinary(
 
     if (!_parseHeader())
         LBTHROW(std::runtime_error("Parsing header failed"));
+    // The report may still be written
+    _updateEndTime();
 
     // Remapping the file until the end of the cell mapping if necessary.
     if (_ioAPI == IOapi::posix_aio)
@@ -329,6 +336,51 @@ bool CompartmentReportBinary::_remapFile(const size_t size)
     return _file.is_open();
 }
 
+bool CompartmentReportBinary::_updateEndTime()
+{
+    boost::system::error_code error;
+    const uint64_t fileSize = boost::filesystem::file_size(_path, error);
+    if (error)
+        return false;
+
+    _endTime = _headerEndTime;
+    const size_t headerFrames = getFrameCount();
+    const uint64_t frameSize = _header.numCompartments * sizeof(float);
+    const uint64_t frames =
+        frameSize == 0 || fileSize < _dataOffset
+            ? 0
+            : (fileSize - _dataOffset) / frameSize;
+    if (frames >= headerFrames)
+        return false;
+
+    _endTime = _startTime + frames * _timestep;
+    // Against rounding errors the end time must not cover the next frame
+    while (getFrameCount() > frames)
+        _endTime = std::nextafter(_endTime, -INFINITY);
+    return true;
+}
+
+bool CompartmentReportBinary::refresh()
+{
+    const bool growing = _updateEndTime();
+
+    // The whole file is mapped for reading with mmap, the new frames are
+    // after the end of the previous mapping
+    if (_ioAPI == IOapi::mmap)
+    {
+        boost::system::error_code error;
+        const uint64_t fileSize = boost::filesystem::file_size(_path, error);
+        if (!error && fileSize > _file.size())
+        {
+            _file.close();
+            _file.open(_path);
+            if (!_file.is_open())
+                LBTHROW(std::runtime_error("Failed to memory map file"));
+        }
+    }
+    return growing;
+}
+
 size_t CompartmentReportBinary::getCellCount() const
 {
     if (_gids.empty())
@@ -402,9 +454,11 @@ bool CompartmentReportBinary::_loadFrameMemMap(const size_t frameNumber,
     {
         memcpy(buffer, ptr + frameOffset,
                _sourceMapping.frameSize * sizeof(float));
+        _ioCounters.addRead(_sourceMapping.frameSize * sizeof(float));
 
         if (_header.byteswap)
         {
+            detail::ScopedTimer timer(_ioCounters.decodeTime);
 #pragma omp parallel for
             for (auto i = 0u; i < _sourceMapping.frameSize; ++i)
                 lunchbox::byteswap(buffer[i]);
@@ -426,9 +480,11 @@ bool CompartmentReportBinary::_loadFrameMemMap(const size_t frameNumber,
         for (auto k = 0u; k < numCompartments; ++k)
             buffer[targetOffset + k] = source[sourceOffset + k];
     }
+    _ioCounters.addRead(_targetMapping.frameSize * sizeof(float));
 
     if (_header.byteswap)
     {
+        detail::ScopedTimer timer(_ioCounters.decodeTime);
 #pragma omp parallel for
         for (ssize_t i = 0; i < ssize_t(_targetMapping.frameSize); ++i)
             lunchbox::byteswap(buffer[i]);
@@ -483,9 +539,12 @@ void CompartmentReportBinary::_loadFramesAIO(const size_t frameNumber,
         (_subtarget ? _targetMapping : _sourceMapping).frameSize * count;
 
     _readAsync(readData);
+    _ioCounters.bytesRead += readCount * sizeof(float);
+    _ioCounters.readOperations += readData.size();
 
     if (_header.byteswap)
     {
+        detail::ScopedTimer timer(_ioCounters.decodeTime);
 #pragma omp parallel for
         for (size_t i = 0; i < readCount; ++i)
             lunchbox::byteswap(buffer[i]);
@@ -515,6 +574,7 @@ floatsPtr CompartmentReportBinary::loadNeuron(const uint32_t gid) const
     const size_t nCompartments = getNumCompartments(index);
     const size_t nValues = nFrames * nCompartments;
     floatsPtr buffer(new floats(nValues));
+    _ioCounters.bytesRequested += nValues * sizeof(float);
 
     const SectionOffsets& offsets = _sourceMapping.offsets;
     const CompartmentCounts& compCounts = getCompartmentCounts();
@@ -546,6 +606,7 @@ floatsPtr CompartmentReportBinary::loadNeuron(const uint32_t gid) const
                         throw std::runtime_error("Failed to read data");
                     }
                 }
+                _ioCounters.addRead(nBytes);
             }
 
             dstOffset += numCompartments;
@@ -554,6 +615,7 @@ floatsPtr CompartmentReportBinary::loadNeuron(const uint32_t gid) const
 
     if (_header.byteswap)
     {
+        detail::ScopedTimer timer(_ioCounters.decodeTime);
 #pragma omp parallel for
         for (ssize_t i = 0; i < ssize_t(nValues); ++i)
             lunchbox::byteswap((*buffer)[i]);
@@ -645,7 +707,7 @@ bool CompartmentReportBinary::_parseHeader()
     _header.simVersion = getPtr<char>(ptr, SIMULATOR_VERSION);
     _header.numFrames = get<int32_t>(ptr, NUMBER_OF_STEPS);
     _startTime = get<double>(ptr, TIME_START);
-    _endTime = get<double>(ptr, TIME_END);
+    _headerEndTime = get<double>(ptr, TIME_END);
     _timestep = get<double>(ptr, DT_TIME);
     _dunit = getPtr<char>(ptr, D_UNIT);
     _tunit = getPtr<char>(ptr, T_UNIT);
@@ -661,7 +723,7 @@ bool CompartmentReportBinary::_parseHeader()
     {
         lunchbox::byteswap(_header);
         lunchbox::byteswap(_startTime);
-        lunchbox::byteswap(_endTime);
+        lunchbox::byteswap(_headerEndTime);
         lunchbox::byteswap(_timestep);
 
         if (_header.identifier != ARCHITECTURE_IDENTIFIER)
@@ -702,6 +764,7 @@ void CompartmentReportBinary::_parseGIDs()
 
 bool CompartmentReportBinary::_parseMapping()
 {
+    BRION_TRACE("CompartmentReportBinary::parseMapping", "mapping");
     _sourceMapping.frameSize = _header.numCompartments;
     const uint8_t* ptr = reinterpret_cast<const uint8_t*>(_file.data());
     size_t offset = _header.headerSize;
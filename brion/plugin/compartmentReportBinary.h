@@ -77,6 +77,8 @@ public:
 
     void updateMapping(const GIDSet& gids) final;
 
+    bool refresh() final;
+
     void writeHeader(double startTime, double endTime, double timestep,
                      const std::string& dunit, const std::string& tunit) final;
     bool writeCompartments(uint32_t gid, const uint16_ts& counts) final;
@@ -98,11 +100,15 @@ private:
     void _loadFramesAIO(size_t frameNumber, size_t count, float* buffer) const;
 
     bool _remapFile(size_t size);
+    /** Clamps the end time to the frames fully written in the file.
+        @return true if the file doesn't have all the frames of the header. */
+    bool _updateEndTime();
 
 private:
     const std::string _path;
     double _startTime;
     double _endTime;
+    double _headerEndTime;
     double _timestep;
     std::string _dunit;
     std::string _tunit;
@@ -68,6 +68,7 @@ floatsPtr CompartmentReportCommon::loadFrame(const double timestamp) const
 {
     const size_t size = getFrameSize();
     floatsPtr buffer(new floats(size));
+    _ioCounters.bytesRequested += size * sizeof(float);
     if (size != 0)
         _loadFrame(_getFrameNumber(timestamp), buffer->data());
     return buffer;
@@ -92,6 +93,7 @@ Frames CompartmentReportCommon::loadFrames(double start, double end) const
 
     const auto frameSize = getFrameSize();
     frames.data.reset(new floats(frameSize * count));
+    _ioCounters.bytesRequested += frameSize * count * sizeof(float);
     if (frameSize == 0)
         return frames;
 
@@ -21,6 +21,7 @@
 #define BRION_PLUGIN_COMPARTMENTREPORTCOMMON
 
 #include "../compartmentReportPlugin.h"
+#include "../detail/ioCounters.h"
 #include "../pluginInitData.h"
 #include "../types.h"
 
@@ -44,7 +45,12 @@ public:
     bool writeFrame(const GIDSet& gids, const float* values,
                     const size_ts& sizes, double timestamp) override;
 
+    IOStatistics getIOStatistics() const final { return _ioCounters.get(); }
+    void resetIOStatistics() final { _ioCounters.reset(); }
+
 protected:
+    mutable detail::IOCounters _ioCounters;
+
     void _cacheNeuronCompartmentCounts();
     /** @return The frame number of a given timestamp clamped to the simulation
         window. */
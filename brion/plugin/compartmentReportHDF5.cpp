@@ -21,6 +21,7 @@
 #include "utilsHDF5.h"
 
 #include "../detail/hdf5Mutex.h"
+#include "../detail/ioCounters.h"
 #include "../detail/utilsHDF5.h"
 
 #include <brion/types.h>
@@ -132,22 +133,45 @@ size_t _parseCacheSizeOption(const URI& uri)
     return _parseSizeOption(value, "cache_size");
 }
 
+// HighFive doesn't support SWMR access, the report is opened with it first
+// when tailing is requested. The SWMR read flag is shared by the handles
+// opened afterwards.
+hid_t _openSWMR(const CompartmentReportInitData& initData)
+{
+    const auto& uri = initData.getURI();
+    if (initData.getAccessMode() != MODE_READ ||
+        uri.findQuery("tail") == uri.queryEnd())
+    {
+        return -1;
+    }
+
+    HighFive::SilenceHDF5 silence;
+    detail::HDF5Lock lock;
+    const hid_t file = H5Fopen(uri.getPath().c_str(),
+                               H5F_ACC_RDONLY | H5F_ACC_SWMR_READ, H5P_DEFAULT);
+    if (file < 0)
+        LBTHROW(std::runtime_error("Cannot open compartment report " +
+                                   uri.getPath() + " for SWMR reading"));
+    return file;
+}
+
 lunchbox::PluginRegisterer<CompartmentReportHDF5> registerer;
 }
 
 CompartmentReportHDF5::CompartmentReportHDF5(
     const CompartmentReportInitData& initData)
-    : _startTime(0)
+    : _accessMode(initData.getAccessMode())
+    , _startTime(0)
     , _endTime(0)
     , _timestep(0)
+    , _swmrFile(_openSWMR(initData))
     , _file(new HighFive::File(
           openFile(initData.getURI().getPath(), initData.getAccessMode())))
 {
     HighFive::SilenceHDF5 silence;
-    std::lock_guard<std::mutex> mutex(detail::hdf5Mutex());
+    detail::HDF5Lock lock;
 
-    const int accessMode = initData.getAccessMode();
-    if (accessMode == MODE_READ)
+    if (_accessMode == MODE_READ)
     {
         _readMetaData();
         _reopenDataSet(_parseCacheSizeOption(initData.getURI()));
@@ -167,10 +191,19 @@ CompartmentReportHDF5::CompartmentReportHDF5(
 
 CompartmentReportHDF5::~CompartmentReportHDF5()
 {
-    std::lock_guard<std::mutex> mutex(detail::hdf5Mutex());
+    detail::HDF5Lock lock;
+    _data.reset();
     _file.reset();
 }
 
+CompartmentReportHDF5::SWMRFile::~SWMRFile()
+{
+    if (id < 0)
+        return;
+    detail::HDF5Lock lock;
+    H5Fclose(id);
+}
+
 bool CompartmentReportHDF5::handles(const CompartmentReportInitData& initData)
 {
     const auto& uri = initData.getURI();
@@ -181,7 +214,7 @@ bool CompartmentReportHDF5::handles(const CompartmentReportInitData& initData)
     if ((initData.getAccessMode() & MODE_READ) == 0)
         return true;
 
-    std::lock_guard<std::mutex> mutex(detail::hdf5Mutex());
+    detail::HDF5Lock lock;
     HighFive::SilenceHDF5 silence;
     return _verifyFile(openFile(initData.getURI().getPath(), MODE_READ, false));
 }
@@ -191,8 +224,9 @@ std::string CompartmentReportHDF5::getDescription()
     return "SONATA HDF5 compartment reports:  "
            "[file://]/path/to/report.(h5|hdf5)"
            "[?[cache_size=(auto|num_bytes)&][cells_to_frames=(inf|ratio)&]"
-           "[chunk_size=bytes]]\n"
+           "[chunk_size=bytes&][tail]]\n"
            "    Byte counts can by suffixed by K or M.\n"
+           "    tail opens a report being written with SWMR read access.\n"
            "    The cache is disabled by default, auto will reserve space for"
            "a whole frame or trace, whatever is bigger. The actual size depends"
            " on the chunk dimensions. For files with row or column layouts the"
@@ -231,12 +265,27 @@ size_t CompartmentReportHDF5::getFrameSize() const
 
 void CompartmentReportHDF5::updateMapping(const GIDSet& gids)
 {
-    std::lock_guard<std::mutex> mutex(detail::hdf5Mutex());
+    detail::HDF5Lock lock;
     HighFive::SilenceHDF5 silence;
 
     _updateMapping(gids);
 }
 
+bool CompartmentReportHDF5::refresh()
+{
+    detail::HDF5Lock lock;
+    HighFive::SilenceHDF5 silence;
+
+    // A writer has all the frames it wrote
+    if (_accessMode != MODE_READ || !_data)
+        return false;
+    // Reloads the metadata of the dataset, including its extent. This also
+    // drops the chunks which may have been cached before being complete.
+    if (H5Drefresh(_data->getId()) < 0)
+        LBTHROW(std::runtime_error("Cannot refresh compartment report"));
+    return _updateEndTime();
+}
+
 void CompartmentReportHDF5::writeHeader(const double startTime,
                                         const double endTime,
                                         const double timestep,
@@ -254,6 +303,7 @@ void CompartmentReportHDF5::writeHeader(const double startTime,
     }
     _startTime = startTime;
     _endTime = endTime;
+    _headerEndTime = endTime;
     _timestep = timestep;
     _dunit = dunit;
     _tunit = tunit;
@@ -283,7 +333,7 @@ bool CompartmentReportHDF5::writeFrame(const uint32_t gid, const float* values,
                                        const size_t /*size*/,
                                        const double timestamp)
 {
-    std::lock_guard<std::mutex> mutex(detail::hdf5Mutex());
+    detail::HDF5Lock lock;
 
     if (!_data)
     {
@@ -331,7 +381,7 @@ bool CompartmentReportHDF5::writeFrame(const GIDSet& gids, const float* values,
         ++index;
     }
 
-    std::lock_guard<std::mutex> mutex(detail::hdf5Mutex());
+    detail::HDF5Lock lock;
 
     if (!_data)
     {
@@ -357,7 +407,7 @@ bool CompartmentReportHDF5::writeFrame(const GIDSet& gids, const float* values,
 
 bool CompartmentReportHDF5::flush()
 {
-    std::lock_guard<std::mutex> mutex(detail::hdf5Mutex());
+    detail::HDF5Lock lock;
     _file->flush();
     return true;
 }
@@ -365,14 +415,19 @@ bool CompartmentReportHDF5::flush()
 bool CompartmentReportHDF5::_loadFrame(const size_t frameNumber,
                                        float* buffer) const
 {
-    std::lock_guard<std::mutex> mutex(detail::hdf5Mutex());
+    detail::CountedLock lock(detail::hdf5Mutex(), _ioCounters);
+    _readFrame(frameNumber, buffer);
+    return true;
+}
 
+void CompartmentReportHDF5::_readFrame(const size_t frameNumber,
+                                       float* buffer) const
+{
     // Considering the case of full frames first
     if (!_subset)
     {
-        _data->select({frameNumber, 0}, {1, _sourceMapping.frameSize})
-            .read(buffer);
-        return true;
+        _read(frameNumber, 0, 1, _sourceMapping.frameSize, buffer);
+        return;
     }
 
     // Computing the slices of data to be read
@@ -392,18 +447,15 @@ bool CompartmentReportHDF5::_loadFrame(const size_t frameNumber,
     {
         const auto sourceOffset = boost::icl::lower(interval);
         const auto count = boost::icl::upper(interval) - sourceOffset;
-        const auto& slice =
-            _data->select({frameNumber, sourceOffset}, {1, count});
-        slice.read(buffer + targetOffset);
+        _read(frameNumber, sourceOffset, 1, count, buffer + targetOffset);
         targetOffset += count;
     }
-    return true;
 }
 
 bool CompartmentReportHDF5::_loadFrames(size_t frameNumber, size_t frameCount,
                                         float* buffer) const
 {
-    std::lock_guard<std::mutex> mutex(detail::hdf5Mutex());
+    detail::CountedLock lock(detail::hdf5Mutex(), _ioCounters);
 
     // Considering first the cases where the read operation is on a single
     // slice of the input file full frames or single cell traces first
@@ -412,9 +464,7 @@ bool CompartmentReportHDF5::_loadFrames(size_t frameNumber, size_t frameCount,
         const size_t offset =
             _gids.size() == 1 ? _sourceMapping.cellOffsets[_subsetIndices[0]]
                               : 0;
-        const auto& slice =
-            _data->select({frameNumber, offset}, {frameCount, getFrameSize()});
-        slice.read(buffer);
+        _read(frameNumber, offset, frameCount, getFrameSize(), buffer);
         return true;
     }
 
@@ -432,15 +482,64 @@ bool CompartmentReportHDF5::_loadFrames(size_t frameNumber, size_t frameCount,
     }
     if (_targetMapping.frameSize == end - start)
     {
-        const auto& slice =
-            _data->select({frameNumber, start},
-                          {frameCount, _targetMapping.frameSize});
-        slice.read(buffer);
+        _read(frameNumber, start, frameCount, _targetMapping.frameSize,
+              buffer);
         return true;
     }
 
-    return CompartmentReportCommon::_loadFrames(frameNumber, frameCount,
-                                                buffer);
+    // Not using CompartmentReportCommon::_loadFrames because _loadFrame
+    // takes the lock again.
+    for (size_t i = 0; i != frameCount; ++i, buffer += getFrameSize())
+        _readFrame(frameNumber + i, buffer);
+    return true;
+}
+
+void CompartmentReportHDF5::_read(const size_t frameNumber, const size_t offset,
+                                  const size_t frameCount, const size_t count,
+                                  float* buffer) const
+{
+    _data->select({frameNumber, offset}, {frameCount, count}).read(buffer);
+    ++_ioCounters.readOperations;
+
+    if (_chunkDims[0] == 0)
+    {
+        // Contiguous layout, no read amplification.
+        _ioCounters.bytesRead += frameCount * count * sizeof(float);
+        return;
+    }
+
+    const size_t chunkBytes = _chunkDims[0] * _chunkDims[1] * sizeof(float);
+    const size_t chunksPerRow =
+        (_sourceMapping.frameSize + _chunkDims[1] - 1) / _chunkDims[1];
+    const size_t lastRow = (frameNumber + frameCount - 1) / _chunkDims[0];
+    const size_t lastColumn = (offset + count - 1) / _chunkDims[1];
+    for (size_t row = frameNumber / _chunkDims[0]; row <= lastRow; ++row)
+    {
+        for (size_t column = offset / _chunkDims[1]; column <= lastColumn;
+             ++column)
+        {
+            const size_t chunk = row * chunksPerRow + column;
+            const auto i = _cachedChunksIndex.find(chunk);
+            if (i != _cachedChunksIndex.end())
+            {
+                ++_ioCounters.cacheHits;
+                _cachedChunks.splice(_cachedChunks.begin(), _cachedChunks,
+                                     i->second);
+                continue;
+            }
+            ++_ioCounters.cacheMisses;
+            _ioCounters.bytesRead += chunkBytes;
+            if (_cacheCapacity == 0)
+                continue;
+            if (_cachedChunks.size() == _cacheCapacity)
+            {
+                _cachedChunksIndex.erase(_cachedChunks.back());
+                _cachedChunks.pop_back();
+            }
+            _cachedChunks.push_front(chunk);
+            _cachedChunksIndex[chunk] = _cachedChunks.begin();
+        }
+    }
 }
 
 void CompartmentReportHDF5::_readMetaData()
@@ -484,7 +583,7 @@ void CompartmentReportHDF5::_readMetaData()
                 "Error opening compartment report: Bad time metadata"));
         }
         _startTime = timeData[0];
-        _endTime = timeData[1];
+        _headerEndTime = timeData[1];
         _timestep = timeData[2];
 
         // Finding the total compartment count
@@ -493,6 +592,8 @@ void CompartmentReportHDF5::_readMetaData()
             LBTHROW(
                 std::runtime_error("Bad report: data is not 2-dimensional"));
         _sourceMapping.frameSize = dims[1];
+        // The report may still be written
+        _updateEndTime();
     }
     catch (std::exception& e)
     {
@@ -501,8 +602,24 @@ void CompartmentReportHDF5::_readMetaData()
     }
 }
 
+bool CompartmentReportHDF5::_updateEndTime()
+{
+    _endTime = _headerEndTime;
+    const size_t headerFrames = getFrameCount();
+    const size_t frames = _data->getSpace().getDimensions()[0];
+    if (frames >= headerFrames)
+        return false;
+
+    _endTime = _startTime + frames * _timestep;
+    // Against rounding errors the end time must not cover the next frame
+    while (getFrameCount() > frames)
+        _endTime = std::nextafter(_endTime, -INFINITY);
+    return true;
+}
+
 void CompartmentReportHDF5::_parseBasicCellInfo()
 {
+    BRION_TRACE("CompartmentReportHDF5::parseCellInfo", "mapping");
     // This not only parses the GIDs, but also computes the cell offsets
     // and compartment counts per cell, with the proper reordering if needed.
     const auto& mapping = _file->getGroup("mapping");
@@ -573,6 +690,7 @@ void CompartmentReportHDF5::_parseBasicCellInfo()
 
 void CompartmentReportHDF5::_processMapping()
 {
+    BRION_TRACE("CompartmentReportHDF5::processMapping", "mapping");
     const auto& mapping = _file->getGroup("mapping");
     std::vector<uint32_t> sectionIDs;
     mapping.getDataSet("element_id").read(sectionIDs);
@@ -900,6 +1018,7 @@ void CompartmentReportHDF5::_reopenDataSet(size_t cacheSizeHint)
     HighFive::DataSetAccessProps accessProps;
     accessProps.add(HighFive::Caching(numSlots, cacheSizeHint));
     _data.reset(new HighFive::DataSet(_file->getDataSet("data", accessProps)));
+    _cacheCapacity = cacheSizeHint / (_chunkDims[0] * _chunkDims[1] * 4);
 }
 }
 }
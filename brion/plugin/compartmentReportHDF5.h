@@ -27,6 +27,7 @@
 
 #include <boost/filesystem/path.hpp>
 
+#include <list>
 #include <unordered_map>
 
 namespace brion
@@ -57,6 +58,8 @@ public:
 
     void updateMapping(const GIDSet& gids) final;
 
+    bool refresh() final;
+
     void writeHeader(double startTime, double endTime, double timestep,
                      const std::string& dunit, const std::string& tunit) final;
     bool writeCompartments(uint32_t gid, const uint16_ts& counts) final;
@@ -67,12 +70,29 @@ public:
     bool flush() final;
 
 private:
+    const int _accessMode;
     double _startTime;
     double _endTime;
+    double _headerEndTime = 0;
     double _timestep;
     std::string _dunit;
     std::string _tunit;
 
+    // Handle with SWMR read access to a report being written, opened before
+    // _file so that the library shares this access mode with it
+    struct SWMRFile
+    {
+        explicit SWMRFile(hid_t id_)
+            : id(id_)
+        {
+        }
+        ~SWMRFile();
+        SWMRFile(const SWMRFile&) = delete;
+        SWMRFile& operator=(const SWMRFile&) = delete;
+
+        const hid_t id;
+    };
+    const SWMRFile _swmrFile;
     std::unique_ptr<HighFive::File> _file;
     std::unique_ptr<HighFive::DataSet> _data;
 
@@ -83,6 +103,13 @@ private:
     std::vector<uint32_t> _subsetIndices;
     hsize_t _chunkDims[2] = {0, 0};
 
+    // LRU model of the chunk cache of the dataset. HDF5 doesn't provide hit
+    // and miss counters, so these are estimated from the selections read.
+    size_t _cacheCapacity = 0; // in chunks
+    mutable std::list<size_t> _cachedChunks;
+    mutable std::unordered_map<size_t, std::list<size_t>::iterator>
+        _cachedChunksIndex;
+
     MappingInfo _sourceMapping;
 
     // Write API temporary attributes
@@ -98,10 +125,21 @@ private:
     // Overriden for better efficiency in single cell traces.
     bool _loadFrames(size_t frameNumber, size_t frameCount,
                      float* buffer) const final;
+    /** Same as _loadFrame, the caller must hold the HDF5 lock. */
+    void _readFrame(size_t frameNumber, float* buffer) const;
+    /** Read a 2D selection of the dataset and account it in the I/O
+        statistics. The caller must hold the HDF5 lock. */
+    void _read(size_t frameNumber, size_t offset, size_t frameCount,
+               size_t count, float* buffer) const;
 
     void _updateMapping(const GIDSet& gids);
 
     void _readMetaData();
+    /** Clamps the end time to the frames of the dataset. The caller must hold
+        the HDF5 lock.
+        @return true if the dataset doesn't have all the frames of the
+        header. */
+    bool _updateEndTime();
     void _reopenDataSet(size_t cacheSizeHint);
     /** Parses the GIDs and offsets and derives per cell compartment counts.
         The data from the H5 file is resorted if needed. */
@@ -21,6 +21,7 @@
 #include "utilsHDF5.h"
 
 #include "../detail/hdf5Mutex.h"
+#include "../detail/ioCounters.h"
 #include "../detail/utilsHDF5.h"
 
 #include <brion/version.h>
@@ -118,7 +119,7 @@ CompartmentReportLegacyHDF5::CompartmentReportLegacyHDF5(
 {
     const int accessMode = initData.getAccessMode();
 
-    std::lock_guard<std::mutex> lock(detail::hdf5Mutex());
+    detail::HDF5Lock lock;
     HighFive::SilenceHDF5 silence;
 
     if (accessMode == MODE_READ)
@@ -130,7 +131,7 @@ CompartmentReportLegacyHDF5::CompartmentReportLegacyHDF5(
 
 CompartmentReportLegacyHDF5::~CompartmentReportLegacyHDF5()
 {
-    std::lock_guard<std::mutex> lock(detail::hdf5Mutex());
+    detail::HDF5Lock lock;
     _file.reset();
     _datas.clear();
 }
@@ -199,7 +200,7 @@ size_t CompartmentReportLegacyHDF5::getFrameSize() const
 bool CompartmentReportLegacyHDF5::_loadFrame(const size_t frameNumber,
                                              float* buffer) const
 {
-    std::lock_guard<std::mutex> lock(detail::hdf5Mutex());
+    detail::CountedLock lock(detail::hdf5Mutex(), _ioCounters);
 
     size_t cellIndex = 0;
     size_t destOffset = 0;
@@ -213,6 +214,7 @@ bool CompartmentReportLegacyHDF5::_loadFrame(const size_t frameNumber,
         // Deceiving HighFive into believing this is a two dimensional buffer
         float* ptr = buffer + destOffset;
         selection.read(ptr);
+        _ioCounters.addRead(compartments * sizeof(float));
 
         ++cellIndex;
         destOffset += compartments;
@@ -222,7 +224,7 @@ bool CompartmentReportLegacyHDF5::_loadFrame(const size_t frameNumber,
 
 void CompartmentReportLegacyHDF5::updateMapping(const GIDSet& gids)
 {
-    std::lock_guard<std::mutex> lock(detail::hdf5Mutex());
+    detail::HDF5Lock lock;
     _updateMapping(gids);
 }
 
@@ -254,7 +256,7 @@ void CompartmentReportLegacyHDF5::writeHeader(const double startTime,
 bool CompartmentReportLegacyHDF5::writeCompartments(const uint32_t gid,
                                                     const uint16_ts& counts)
 {
-    std::lock_guard<std::mutex> lock(detail::hdf5Mutex());
+    detail::HDF5Lock lock;
 
     try
     {
@@ -290,7 +292,7 @@ bool CompartmentReportLegacyHDF5::writeFrame(const uint32_t gid,
                                              const size_t /*size*/,
                                              const double timestamp)
 {
-    std::lock_guard<std::mutex> lock(detail::hdf5Mutex());
+    detail::HDF5Lock lock;
 
     try
     {
@@ -312,7 +314,7 @@ bool CompartmentReportLegacyHDF5::writeFrame(const uint32_t gid,
 
 bool CompartmentReportLegacyHDF5::flush()
 {
-    std::lock_guard<std::mutex> lock(detail::hdf5Mutex());
+    detail::HDF5Lock lock;
     _file->flush();
     return true;
 }
@@ -19,16 +19,19 @@
 
 #include "compartmentReportMap.h"
 
-#include <lunchbox/atomic.h>
 #include <lunchbox/bitOperation.h>
 #include <lunchbox/debug.h>
 #include <lunchbox/pluginRegisterer.h>
 #include <lunchbox/string.h>
 
+#include "../detail/trace.h"
+
+#include <brion/executor.h>
+
+#include <atomic>
 #include <cstring>
-#ifdef BRION_USE_OPENMP
-#include <omp.h>
-#endif
+#include <exception>
+#include <thread>
 
 namespace lunchbox
 {
@@ -51,11 +54,13 @@ namespace
 const uint32_t _version = 3; // Increase with each change in a k/v pair
 const uint32_t _magic = 0xdb;
 const size_t _queueDepth = 32768; // async queue depth, heuristic from benchmark
-#ifdef BRION_USE_OPENMP
-const size_t _nThreads = omp_get_num_procs();
-#else
-const size_t _nThreads = 1;
-#endif
+const size_t _nStores = std::max(1u, std::thread::hardware_concurrency());
+
+// Keys are fetched in batches pulled from a shared cursor, so that stores
+// with faster responses take over more of the work. Enough batches per store
+// to balance uneven value sizes, but large enough to keep the queue filled.
+const size_t _batchesPerStore = 8;
+const size_t _minBatchSize = 256;
 }
 
 namespace plugin
@@ -76,12 +81,16 @@ CompartmentReportMap::CompartmentReportMap(
     // have at least one store
     _stores.emplace_back(keyv::Map(uri));
     _stores.back().setQueueDepth(_queueDepth);
-    if (uri.getScheme() == "memcached") // parallelize loading with memcached
-        while (_stores.size() < _nThreads)
+    // parallelize loading with memcached, and the decompression and copies
+    // of local stores
+    if (uri.getScheme() == "memcached" || uri.getScheme() == "local")
+        while (_stores.size() < _nStores)
         {
             _stores.emplace_back(keyv::Map(uri));
             _stores.back().setQueueDepth(_queueDepth);
         }
+    if (_stores.size() > 1)
+        _storeThreads.reset(new Executor(_stores.size() - 1));
 
     const int accessMode = initData.getAccessMode();
 
@@ -400,8 +409,6 @@ bool CompartmentReportMap::_loadFrame(const size_t frameNumber,
 
     for (const uint32_t gid : _gids)
     {
-        keys.push_back(_getValueKey(gid, frameNumber));
-        offsetMap.emplace(keys.back(), offset);
         const CellCompartments::const_iterator i = _cellCounts.find(gid);
         if (i == _cellCounts.end())
         {
@@ -410,6 +417,8 @@ bool CompartmentReportMap::_loadFrame(const size_t frameNumber,
         }
         const size_t size =
             std::accumulate(i->second.begin(), i->second.end(), 0);
+        keys.push_back(_getValueKey(gid, frameNumber));
+        offsetMap.emplace(keys.back(), std::make_pair(offset, size));
         offset += size;
     }
 
@@ -436,7 +445,8 @@ floatsPtr CompartmentReportMap::loadNeuron(const uint32_t gid) const
     for (size_t i = 0; i < nFrames; ++i)
     {
         keys.push_back(_getValueKey(gid, i));
-        offsetMap.emplace(keys.back(), i * nCompartments);
+        offsetMap.emplace(keys.back(),
+                          std::make_pair(i * nCompartments, nCompartments));
     }
 
     if (_load(buffer->data(), keys, offsetMap))
@@ -447,40 +457,91 @@ floatsPtr CompartmentReportMap::loadNeuron(const uint32_t gid) const
 bool CompartmentReportMap::_load(float* buffer, const Strings& keys,
                                  const OffsetMap& offsets) const
 {
-#ifdef BRION_USE_OPENMP
-    lunchbox::a_ssize_t taken;
-    omp_set_num_threads(_stores.size());
-#else
-    size_t taken = 0;
-#endif
-#pragma omp parallel
-    {
-#ifdef BRION_USE_OPENMP
-        auto& store = _stores[omp_get_thread_num()];
-        const size_t start = float(omp_get_thread_num()) * float(keys.size()) /
-                             float(omp_get_num_threads());
-        const size_t end = float(omp_get_thread_num() + 1) *
-                           float(keys.size()) / float(omp_get_num_threads());
-        const Strings subKeys(keys.begin() + start, keys.begin() + end);
-#else
-        auto& store = _stores.front();
-        const Strings& subKeys = keys;
-#endif
-
-        const auto takeValue = [buffer, &offsets,
-                                &taken](const std::string& key, char* data,
-                                        const size_t size) {
-            const auto i = offsets.find(key);
-            if (i != offsets.end())
+    std::atomic<size_t> taken{0};
+    std::atomic<bool> badSize{false};
+    const size_t batchSize =
+        std::max(_minBatchSize,
+                 keys.size() / (_stores.size() * _batchesPerStore) + 1);
+
+    // The values are copied into the buffer as they arrive, overlapping with
+    // the outstanding requests of the batch and of the other stores. Values
+    // which do not fit the mapping are rejected after takeValues() returns,
+    // not to throw through the store.
+    const auto takeValue = [this, buffer, &offsets, &taken, &badSize](
+        const std::string& key, char* data, const size_t size) {
+        const auto i = offsets.find(key);
+        if (i != offsets.end())
+        {
+            if (size == i->second.second * sizeof(float))
             {
-                ::memcpy(buffer + i->second, data, size);
+                ::memcpy(buffer + i->second.first, data, size);
                 ++taken;
             }
-            std::free(data);
-        };
+            else
+                badSize = true;
+        }
+        _ioCounters.bytesRead += size;
+        std::free(data);
+    };
+
+    // Each store takes its first batch up front, so that all of them are
+    // busy even if the first ones to start could take all the batches.
+    const size_t nBatches = (keys.size() + batchSize - 1) / batchSize;
+    const size_t nStores = std::min(_stores.size(), nBatches);
+    std::atomic<size_t> next{nStores * batchSize};
+
+    const auto load = [&](const keyv::Map& store, size_t start) {
+        BRION_TRACE("CompartmentReportMap::loadStore", "report");
+        while (start < keys.size())
+        {
+            const size_t end = std::min(start + batchSize, keys.size());
+            store.takeValues(Strings(keys.begin() + start, keys.begin() + end),
+                             takeValue);
+            ++_ioCounters.readOperations;
+            if (badSize)
+            {
+                next = keys.size(); // stop the other stores
+                LBTHROW(std::runtime_error(
+                    "Report value does not match the compartment mapping"));
+            }
+            start = next.fetch_add(batchSize);
+        }
+    };
+
+    // All tasks must have finished before an exception leaves, as they refer
+    // to this stack frame.
+    std::vector<std::future<void>> tasks;
+    for (size_t i = 1; i < nStores; ++i)
+    {
+        const keyv::Map* store = &_stores[i];
+        const size_t start = i * batchSize;
+        tasks.push_back(
+            _storeThreads->post([&load, store, start] { load(*store, start); }));
+    }
 
-        store.takeValues(subKeys, takeValue);
+    std::exception_ptr error;
+    try
+    {
+        load(_stores.front(), 0);
+    }
+    catch (...)
+    {
+        error = std::current_exception();
+    }
+    for (auto& task : tasks)
+    {
+        try
+        {
+            task.get();
+        }
+        catch (...)
+        {
+            if (!error)
+                error = std::current_exception();
+        }
     }
+    if (error)
+        std::rethrow_exception(error);
 
     if (size_t(taken) == keys.size())
         return true;
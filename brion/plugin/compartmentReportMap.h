@@ -22,6 +22,7 @@
 
 #include "compartmentReportCommon.h"
 #include <keyv/Map.h>
+#include <memory>
 #include <unordered_map>
 
 namespace brion
@@ -91,6 +92,11 @@ public:
 private:
     std::vector<keyv::Map> _stores;
 
+    // Serves all stores but the first one, which is served by the loading
+    // thread. Loads run in tasks of the default executor, where nested posts
+    // would run inline.
+    std::unique_ptr<Executor> _storeThreads;
+
     Header _header;
 
     std::string _dunit;
@@ -119,7 +125,9 @@ private:
 
     bool _readable;
 
-    using OffsetMap = std::unordered_map<std::string, size_t>;
+    // <value key, <offset, size> in the buffer in floats>
+    using OffsetMap =
+        std::unordered_map<std::string, std::pair<size_t, size_t>>;
 
     void _clear();
     bool _loadHeader();
@@ -0,0 +1,448 @@
+/* Copyright (c) 2018, EPFL/Blue Brain Project
+ *
+ * This file is part of Brion <https://github.com/BlueBrain/Brion>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "keyvLocal.h"
+
+#include <lunchbox/debug.h>
+#include <lunchbox/log.h>
+#include <lunchbox/pluginRegisterer.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef BRION_USE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace brion
+{
+namespace plugin
+{
+namespace
+{
+lunchbox::PluginRegisterer<KeyvLocal> registerer;
+
+const char _fileMagic[8] = {'B', 'R', 'I', 'O', 'N', 'K', 'V', '1'};
+const uint64_t _fileHeaderSize = 16;
+const uint32_t _recordMagic = 0x6b76726c; // "lrvk"
+
+enum RecordFlags : uint32_t
+{
+    RECORD_COMPRESSED = 1u << 0,
+    RECORD_ERASED = 1u << 1
+};
+
+struct RecordHeader
+{
+    uint32_t magic;
+    uint32_t flags;
+    uint64_t keySize;
+    uint64_t size;    // of the stored value
+    uint64_t rawSize; // of the uncompressed value
+};
+static_assert(sizeof(RecordHeader) == 32, "Unexpected record header size");
+
+/** @return false if the header can not have been written by _append(). */
+bool _isValid(const RecordHeader& header)
+{
+    if (header.magic != _recordMagic ||
+        (header.flags & ~uint32_t(RECORD_COMPRESSED | RECORD_ERASED)) != 0)
+    {
+        return false;
+    }
+    if (header.flags & RECORD_ERASED)
+        return header.size == 0 && header.rawSize == 0;
+    if (header.flags & RECORD_COMPRESSED)
+        return header.size < header.rawSize;
+    return header.size == header.rawSize;
+}
+
+inline uint64_t _align(const uint64_t size)
+{
+    return (size + 7) & ~uint64_t(7);
+}
+
+uint64_t _getFileSize(const int fd)
+{
+    struct stat info;
+    if (::fstat(fd, &info) != 0)
+        LBTHROW(std::runtime_error(std::string("Cannot stat local store: ") +
+                                   ::strerror(errno)));
+    return info.st_size;
+}
+
+bool _writeAll(const int fd, const void* data, size_t size)
+{
+    const char* ptr = static_cast<const char*>(data);
+    while (size > 0)
+    {
+        const ssize_t written = ::write(fd, ptr, size);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        ptr += written;
+        size -= written;
+    }
+    return true;
+}
+
+/** Exclusive advisory lock on the store file, held while appending. */
+class FileLock
+{
+public:
+    explicit FileLock(const int fd)
+        : _fd(fd)
+    {
+        while (::flock(_fd, LOCK_EX) != 0 && errno == EINTR)
+            ;
+    }
+    ~FileLock() { ::flock(_fd, LOCK_UN); }
+
+private:
+    const int _fd;
+};
+
+#ifdef BRION_USE_ZLIB
+bool _deflate(const void* data, const size_t size, std::string& out)
+{
+    uLongf outSize = ::compressBound(size);
+    out.resize(outSize);
+    if (::compress2(reinterpret_cast<Bytef*>(&out[0]), &outSize,
+                    static_cast<const Bytef*>(data), size,
+                    Z_BEST_SPEED) != Z_OK)
+    {
+        return false;
+    }
+    out.resize(outSize);
+    return outSize < size;
+}
+#endif
+
+bool _inflate(const uint8_t* data, const size_t size, char* out,
+              const size_t rawSize)
+{
+#ifdef BRION_USE_ZLIB
+    uLongf outSize = rawSize;
+    return ::uncompress(reinterpret_cast<Bytef*>(out), &outSize, data,
+                        size) == Z_OK &&
+           outSize == rawSize;
+#else
+    (void)data;
+    (void)size;
+    (void)out;
+    (void)rawSize;
+    LBWARN << "Cannot read compressed value from local store, "
+           << "Brion was built without zlib" << std::endl;
+    return false;
+#endif
+}
+}
+
+/** Read-only memory mapping of the store, kept alive by its readers. */
+class KeyvLocal::Mapping
+{
+public:
+    Mapping(const int fd, const size_t size)
+        : _size(size)
+    {
+        _data = ::mmap(nullptr, _size, PROT_READ, MAP_SHARED, fd, 0);
+        if (_data == MAP_FAILED)
+            LBTHROW(std::runtime_error(std::string("Cannot map local store: ") +
+                                       ::strerror(errno)));
+    }
+
+    ~Mapping() { ::munmap(_data, _size); }
+
+    const uint8_t* getData() const { return static_cast<uint8_t*>(_data); }
+    size_t getSize() const { return _size; }
+
+private:
+    void* _data;
+    const size_t _size;
+};
+
+KeyvLocal::KeyvLocal(const servus::URI& uri)
+    : _filename(uri.getPath())
+    , _compress(uri.findQuery("compression") != uri.queryEnd() &&
+                uri.findQuery("compression")->second == "zlib")
+    , _fd(-1)
+    , _indexedSize(_fileHeaderSize)
+    , _corruptOffset(0)
+{
+    if (_filename.empty())
+        LBTHROW(std::runtime_error("Empty path for local store " +
+                                   std::to_string(uri)));
+#ifndef BRION_USE_ZLIB
+    if (_compress)
+        LBWARN << "Brion was built without zlib, ignoring compression of "
+               << "local store " << _filename << std::endl;
+#endif
+
+    _fd = ::open(_filename.c_str(), O_RDWR | O_CREAT, 0644);
+    if (_fd < 0) // allow read-only access to shared stores
+        _fd = ::open(_filename.c_str(), O_RDONLY);
+    if (_fd < 0)
+        LBTHROW(std::runtime_error("Cannot open local store " + _filename +
+                                   ": " + ::strerror(errno)));
+
+    char magic[sizeof(_fileMagic)] = {0};
+    {
+        FileLock lock(_fd);
+        if (_getFileSize(_fd) == 0)
+        {
+            char header[_fileHeaderSize] = {0};
+            ::memcpy(header, _fileMagic, sizeof(_fileMagic));
+            if (!_writeAll(_fd, header, sizeof(header)))
+            {
+                ::close(_fd);
+                LBTHROW(std::runtime_error("Cannot initialize local store " +
+                                           _filename));
+            }
+        }
+        if (::pread(_fd, magic, sizeof(magic), 0) != sizeof(magic) ||
+            ::memcmp(magic, _fileMagic, sizeof(magic)) != 0)
+        {
+            ::close(_fd);
+            LBTHROW(std::runtime_error(_filename + " is not a local store"));
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _scan();
+}
+
+KeyvLocal::~KeyvLocal()
+{
+    _mapping.reset();
+    ::close(_fd);
+}
+
+bool KeyvLocal::handles(const servus::URI& uri)
+{
+    return uri.getScheme() == "local";
+}
+
+std::string KeyvLocal::getDescription()
+{
+    return "Local file store: local:///path/to/file[?compression=zlib]";
+}
+
+bool KeyvLocal::insert(const std::string& key, const void* data,
+                       const size_t size)
+{
+#ifdef BRION_USE_ZLIB
+    if (_compress)
+    {
+        std::string compressed;
+        if (_deflate(data, size, compressed))
+            return _append(key, compressed.data(), compressed.size(), size,
+                           RECORD_COMPRESSED);
+    }
+#endif
+    return _append(key, data, size, size, 0);
+}
+
+std::string KeyvLocal::operator[](const std::string& key) const
+{
+    std::string value;
+    _forEachValue(keyv::Strings{key},
+                  [&value](const std::string&, const char* data,
+                           const size_t size) { value.assign(data, size); });
+    return value;
+}
+
+void KeyvLocal::getValues(const keyv::Strings& keys,
+                          const keyv::ConstValueFunc& func) const
+{
+    _forEachValue(keys, func);
+}
+
+void KeyvLocal::takeValues(const keyv::Strings& keys,
+                           const keyv::ValueFunc& func) const
+{
+    _forEachValue(keys, [&func](const std::string& key, const char* data,
+                                const size_t size) {
+        char* copy = static_cast<char*>(std::malloc(size));
+        ::memcpy(copy, data, size);
+        func(key, copy, size);
+    });
+}
+
+bool KeyvLocal::erase(const std::string& key)
+{
+    return _append(key, nullptr, 0, 0, RECORD_ERASED);
+}
+
+bool KeyvLocal::flush()
+{
+    return ::fsync(_fd) == 0;
+}
+
+template <typename F>
+void KeyvLocal::_forEachValue(const keyv::Strings& keys, const F& func) const
+{
+    std::vector<char> buffer;
+    for (const auto& key : keys)
+    {
+        Entry entry;
+        MappingPtr mapping;
+        if (!_find(key, entry, mapping))
+            continue;
+
+        const uint8_t* data = mapping->getData() + entry.offset;
+        if (!(entry.flags & RECORD_COMPRESSED))
+        {
+            // served directly from the page cache
+            func(key, reinterpret_cast<const char*>(data), entry.size);
+            continue;
+        }
+
+        buffer.resize(entry.rawSize);
+        if (_inflate(data, entry.size, buffer.data(), entry.rawSize))
+            func(key, buffer.data(), entry.rawSize);
+        else
+            LBWARN << "Corrupt value for " << key << " in local store "
+                   << _filename << std::endl;
+    }
+}
+
+bool KeyvLocal::_find(const std::string& key, Entry& entry,
+                      MappingPtr& mapping) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto i = _index.find(key);
+    if (i == _index.end())
+    {
+        _scan(); // pick up records appended by other processes
+        i = _index.find(key);
+        if (i == _index.end())
+            return false;
+    }
+
+    entry = i->second;
+    if (!_mapping || _mapping->getSize() < entry.offset + entry.size)
+        _mapping = std::make_shared<const Mapping>(_fd, _indexedSize);
+    mapping = _mapping;
+    return true;
+}
+
+void KeyvLocal::_scan() const
+{
+    if (_corruptOffset != 0) // nothing is appended after a corrupt record
+        return;
+    const uint64_t fileSize = _getFileSize(_fd);
+    if (fileSize <= _indexedSize)
+        return;
+
+    if (!_mapping || _mapping->getSize() < fileSize)
+        _mapping = std::make_shared<const Mapping>(_fd, fileSize);
+    const uint8_t* data = _mapping->getData();
+
+    uint64_t offset = _indexedSize;
+    while (offset + sizeof(RecordHeader) <= fileSize)
+    {
+        RecordHeader header;
+        ::memcpy(&header, data + offset, sizeof(header));
+        if (!_isValid(header))
+        {
+            LBWARN << "Corrupt record at " << offset << " in local store "
+                   << _filename << ", ignoring all further records"
+                   << std::endl;
+            _corruptOffset = offset;
+            break;
+        }
+
+        const uint64_t keyOffset = offset + sizeof(RecordHeader);
+        const uint64_t valueOffset = keyOffset + _align(header.keySize);
+        const uint64_t end = valueOffset + _align(header.size);
+        if (end > fileSize) // incomplete, still being written
+            break;
+
+        std::string key(reinterpret_cast<const char*>(data + keyOffset),
+                        header.keySize);
+        if (header.flags & RECORD_ERASED)
+            _index.erase(key);
+        else
+            _index[std::move(key)] = {valueOffset, header.size, header.rawSize,
+                                      header.flags};
+        offset = end;
+    }
+    _indexedSize = offset;
+}
+
+bool KeyvLocal::_append(const std::string& key, const void* data,
+                        const size_t size, const size_t rawSize,
+                        const uint32_t flags)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    FileLock fileLock(_fd);
+
+    _scan();
+    // Truncating at a corrupt record would lose all the valid records after
+    // it, the store has to be repaired or removed instead.
+    if (_corruptOffset != 0)
+        LBTHROW(std::runtime_error("Cannot append to local store " +
+                                   _filename + ", corrupt record at " +
+                                   std::to_string(_corruptOffset)));
+
+    // Anything after the last complete record is left over from an
+    // interrupted write, as all writers hold the file lock.
+    if (_getFileSize(_fd) > _indexedSize &&
+        ::ftruncate(_fd, _indexedSize) != 0)
+    {
+        return false;
+    }
+
+    const RecordHeader header{_recordMagic, flags, key.size(), size, rawSize};
+    std::vector<char> prefix(sizeof(header) + _align(key.size()), 0);
+    ::memcpy(prefix.data(), &header, sizeof(header));
+    ::memcpy(prefix.data() + sizeof(header), key.data(), key.size());
+    const char padding[8] = {0};
+
+    const uint64_t offset = _indexedSize;
+    if (::lseek(_fd, offset, SEEK_SET) < 0 ||
+        !_writeAll(_fd, prefix.data(), prefix.size()) ||
+        !_writeAll(_fd, data, size) ||
+        !_writeAll(_fd, padding, _align(size) - size))
+    {
+        LBWARN << "Cannot write to local store " << _filename << ": "
+               << ::strerror(errno) << std::endl;
+        if (::ftruncate(_fd, offset) != 0)
+            LBWARN << "Cannot truncate local store " << _filename << std::endl;
+        return false;
+    }
+
+    if (flags & RECORD_ERASED)
+        _index.erase(key);
+    else
+        _index[key] = {offset + prefix.size(), size, rawSize, flags};
+    _indexedSize = offset + prefix.size() + _align(size);
+    return true;
+}
+}
+}
@@ -0,0 +1,107 @@
+/* Copyright (c) 2018, EPFL/Blue Brain Project
+ *
+ * This file is part of Brion <https://github.com/BlueBrain/Brion>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef BRION_PLUGIN_KEYVLOCAL
+#define BRION_PLUGIN_KEYVLOCAL
+
+#include <keyv/Plugin.h>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace brion
+{
+namespace plugin
+{
+/**
+ * A keyv::Map backend storing all key-value pairs in one local file.
+ *
+ * Selected with local:///path/to/file URIs, which makes every keyv::Map based
+ * feature (map compartment reports, morphology and synapse caches) available
+ * on a single workstation without any external service.
+ *
+ * The file is an append-only log of records. Each record holds a key and its
+ * value, aligned to 8 bytes. Inserting an existing key appends a new record,
+ * erasing a key appends a tombstone. A hash index from keys to the latest
+ * record is built when the file is opened, and is updated with the records
+ * appended by other processes when a key is not found. Appends are serialized
+ * between processes with an advisory file lock, so any number of processes can
+ * read and write the same store concurrently. An incomplete record at the end
+ * of the file, left by an interrupted write, is overwritten by the next
+ * append. Records after a corrupt record are ignored, and appending to such a
+ * store throws, as it would hide these records.
+ *
+ * The file is memory mapped for reading. getValues() hands out pointers into
+ * the mapping, so uncompressed values are served directly from the page
+ * cache. Values are compressed with zlib if the URI has the query
+ * ?compression=zlib; reading is always possible regardless of this setting.
+ */
+class KeyvLocal : public keyv::Plugin
+{
+public:
+    explicit KeyvLocal(const servus::URI& uri);
+    ~KeyvLocal();
+
+    static bool handles(const servus::URI& uri);
+    static std::string getDescription();
+
+    size_t setQueueDepth(size_t) final { return 0; }
+    bool insert(const std::string& key, const void* data, size_t size) final;
+    std::string operator[](const std::string& key) const final;
+    void getValues(const keyv::Strings& keys,
+                   const keyv::ConstValueFunc& func) const final;
+    void takeValues(const keyv::Strings& keys,
+                    const keyv::ValueFunc& func) const final;
+    bool erase(const std::string& key) final;
+    bool flush() final;
+
+private:
+    struct Entry
+    {
+        uint64_t offset; // of the value in the file
+        uint64_t size;   // of the stored value
+        uint64_t rawSize;
+        uint32_t flags;
+    };
+
+    class Mapping;
+    using MappingPtr = std::shared_ptr<const Mapping>;
+
+    const std::string _filename;
+    const bool _compress;
+    int _fd;
+
+    mutable std::mutex _mutex;
+    mutable std::unordered_map<std::string, Entry> _index;
+    mutable uint64_t _indexedSize; // file size covered by _index
+    mutable uint64_t _corruptOffset; // of the first corrupt record, 0 if none
+    mutable MappingPtr _mapping;
+
+    bool _find(const std::string& key, Entry& entry, MappingPtr& mapping) const;
+    void _scan() const;
+    bool _append(const std::string& key, const void* data, size_t size,
+                 size_t rawSize, uint32_t flags);
+    template <typename F>
+    void _forEachValue(const keyv::Strings& keys, const F& func) const;
+};
+}
+}
+
+#endif
@@ -48,7 +48,7 @@ struct Loader
         , _initData(m.getInitData())
         , _stage("repaired")
     {
-        std::lock_guard<std::mutex> lock(detail::hdf5Mutex());
+        detail::HDF5Lock lock;
         const std::string path = _initData.getURI().getPath();
 
         try
@@ -71,7 +71,7 @@ struct Loader
 
     ~Loader()
     {
-        std::lock_guard<std::mutex> lock(detail::hdf5Mutex());
+        detail::HDF5Lock lock;
         _points.reset();
         _sections.reset();
         _file.reset();
@@ -0,0 +1,405 @@
+/* Copyright (c) 2018, EPFL/Blue Brain Project
+ *
+ * This file is part of Brion <https://github.com/BlueBrain/Brion>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "spikeBlockFile.h"
+
+#include <lunchbox/log.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace brion
+{
+namespace plugin
+{
+namespace
+{
+// Maps the bits of a float to an unsigned integer with the same order
+uint32_t _toOrdered(const float time)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &time, sizeof(bits));
+    return bits & 0x80000000u ? ~bits : bits | 0x80000000u;
+}
+
+float _fromOrdered(const uint32_t ordered)
+{
+    const uint32_t bits =
+        ordered & 0x80000000u ? ordered & 0x7fffffffu : ~ordered;
+    float time;
+    std::memcpy(&time, &bits, sizeof(time));
+    return time;
+}
+
+void _writeVarint(uint32_t value, std::vector<uint8_t>& out)
+{
+    while (value >= 0x80)
+    {
+        out.push_back(uint8_t(value) | 0x80);
+        value >>= 7;
+    }
+    out.push_back(uint8_t(value));
+}
+
+uint32_t _readVarint(const uint8_t*& in)
+{
+    uint32_t value = 0;
+    for (uint32_t shift = 0;; shift += 7)
+    {
+        const uint8_t byte = *in++;
+        value |= uint32_t(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return value;
+    }
+}
+
+// Blocks with up to this number of distinct GIDs list them, the others have
+// a Bloom filter
+const uint32_t MAX_LISTED_GIDS = 64;
+const size_t BLOOM_BITS_PER_GID = 16;
+const uint32_t BLOOM_HASHES = 3;
+
+uint64_t _getHash(const uint32_t gid)
+{
+    uint64_t hash = gid * 0x9e3779b97f4a7c15ull;
+    hash ^= hash >> 32;
+    hash *= 0xd6e8feb86659fd93ull;
+    return hash ^ (hash >> 32);
+}
+
+// The bits of a GID in a Bloom filter, by double hashing of its hash
+template <typename F>
+bool _forEachBloomBit(const uint64_t hash, const uint64_t numBits, const F& f)
+{
+    const uint32_t h1 = uint32_t(hash);
+    const uint32_t h2 = uint32_t(hash >> 32) | 1;
+    for (uint32_t i = 0; i < BLOOM_HASHES; ++i)
+        if (!f((h1 + uint64_t(i) * h2) % numBits))
+            return false;
+    return true;
+}
+
+size_t _getFilterBytes(const SpikeBlockFile::BlockInfo& block)
+{
+    return block.filterSize ? block.filterSize * sizeof(uint64_t)
+                            : block.numGIDs * sizeof(uint32_t);
+}
+
+bool _byTime(const Spike& spike, const float time)
+{
+    return spike.first < time;
+}
+
+size_t _align(const size_t size)
+{
+    return (size + 7) & ~size_t(7);
+}
+}
+
+SpikeBlockFile::GIDHash::GIDHash(const GIDSet& gidSet)
+    : gids(gidSet.begin(), gidSet.end())
+{
+    hashes.reserve(gids.size());
+    for (const uint32_t gid : gids)
+        hashes.push_back(_getHash(gid));
+}
+
+SpikeBlockFile::SpikeBlockFile(const std::string& path)
+    : _map(path)
+{
+    const size_t size = _map.getSize();
+    const Header* header = _map.getAddress<Header>();
+    if (size < sizeof(Header) || header->magic != Header().magic ||
+        header->version != Header().version ||
+        header->directoryOffset % 8 != 0 ||
+        header->directoryOffset +
+                header->numBlocks * uint64_t(sizeof(BlockInfo)) >
+            size)
+    {
+        LBTHROW(std::runtime_error("Invalid binary spike report: " + path));
+    }
+
+    _blockDuration = header->blockDuration;
+    const BlockInfo* blocks = reinterpret_cast<const BlockInfo*>(
+        _map.getAddress<uint8_t>() + header->directoryOffset);
+    _blocks.assign(blocks, blocks + header->numBlocks);
+
+    uint64_t numSpikes = 0;
+    for (const auto& block : _blocks)
+    {
+        if (block.offset + block.size > block.filterOffset ||
+            block.filterOffset % 8 != 0 ||
+            block.filterOffset + _getFilterBytes(block) >
+                header->directoryOffset ||
+            block.firstSpike != numSpikes)
+        {
+            LBTHROW(std::runtime_error("Invalid binary spike report: " + path));
+        }
+        numSpikes += block.numSpikes;
+    }
+    if (numSpikes != header->numSpikes)
+        LBTHROW(std::runtime_error("Invalid binary spike report: " + path));
+}
+
+SpikeBlockFile::SpikeBlockFile(const std::string& path,
+                               const float blockDuration)
+    : _map(path, sizeof(Header))
+    , _blockDuration(blockDuration)
+    , _size(sizeof(Header))
+    , _dirty(true)
+{
+    if (!(blockDuration > 0))
+        LBTHROW(std::runtime_error("Invalid spike block duration"));
+}
+
+size_t SpikeBlockFile::getNumSpikes() const
+{
+    const size_t numSpikes =
+        _blocks.empty() ? 0 : _blocks.back().firstSpike +
+                                  _blocks.back().numSpikes;
+    return numSpikes + _pending.size();
+}
+
+float SpikeBlockFile::getEndTime() const
+{
+    if (!_pending.empty())
+        return _pending.back().first;
+    return _blocks.empty() ? 0 : _blocks.back().endTime;
+}
+
+size_t SpikeBlockFile::findBlock(const size_t spike) const
+{
+    const auto i = std::upper_bound(_blocks.begin(), _blocks.end(), spike,
+                                    [](const size_t index,
+                                       const BlockInfo& block) {
+                                        return index < block.firstSpike;
+                                    });
+    if (i == _blocks.begin())
+        return _blocks.size();
+    const size_t block = (i - _blocks.begin()) - 1;
+    const auto& info = _blocks[block];
+    return spike < info.firstSpike + info.numSpikes ? block : _blocks.size();
+}
+
+bool SpikeBlockFile::mayContain(const size_t block,
+                                const GIDHash& hash) const
+{
+    const auto& info = _blocks[block];
+    const auto first =
+        std::lower_bound(hash.gids.begin(), hash.gids.end(), info.minGID);
+    const auto last = std::upper_bound(first, hash.gids.end(), info.maxGID);
+    const uint8_t* filter = _map.getAddress<uint8_t>() + info.filterOffset;
+
+    if (info.filterSize == 0)
+    {
+        const uint32_t* listed = reinterpret_cast<const uint32_t*>(filter);
+        const uint32_t* listedEnd = listed + info.numGIDs;
+        for (auto i = first; i != last && listed != listedEnd;)
+        {
+            if (*i == *listed)
+                return true;
+            if (*i < *listed)
+                ++i;
+            else
+                ++listed;
+        }
+        return false;
+    }
+
+    const uint64_t* words = reinterpret_cast<const uint64_t*>(filter);
+    const uint64_t numBits = info.filterSize * uint64_t(64);
+    for (auto i = first; i != last; ++i)
+    {
+        const uint64_t gidHash = hash.hashes[i - hash.gids.begin()];
+        const auto isSet = [words](const uint64_t bit) {
+            return ((words[bit >> 6] >> (bit & 63)) & 1) != 0;
+        };
+        if (_forEachBloomBit(gidHash, numBits, isSet))
+            return true;
+    }
+    return false;
+}
+
+void SpikeBlockFile::decode(const size_t block, Spikes& spikes) const
+{
+    const auto& info = _blocks[block];
+    const uint8_t* in = _map.getAddress<uint8_t>() + info.offset;
+    const size_t first = spikes.size();
+    spikes.resize(first + info.numSpikes);
+
+    uint32_t time = 0;
+    uint32_t gid = 0;
+    for (size_t i = first; i < spikes.size(); ++i)
+    {
+        time += _readVarint(in);
+        const uint32_t delta = _readVarint(in);
+        gid += (delta >> 1) ^ (~(delta & 1) + 1);
+        spikes[i] = Spike(_fromOrdered(time), gid);
+    }
+}
+
+void SpikeBlockFile::write(const Spike* spikes, const size_t size)
+{
+    for (size_t i = 0; i < size; ++i)
+    {
+        if (!_pending.empty() &&
+            _getBlockKey(spikes[i].first) != _getBlockKey(_pending[0].first))
+        {
+            _writeBlock();
+        }
+        _pending.push_back(spikes[i]);
+    }
+    _dirty = true;
+}
+
+void SpikeBlockFile::truncate(const float time)
+{
+    _dirty = true;
+    if (!_pending.empty() && _pending.front().first < time)
+    {
+        _pending.erase(std::lower_bound(_pending.begin(), _pending.end(),
+                                        time, _byTime),
+                       _pending.end());
+        return;
+    }
+
+    _pending.clear();
+    const auto i = std::lower_bound(_blocks.begin(), _blocks.end(), time,
+                                    [](const BlockInfo& block, const float t) {
+                                        return block.endTime < t;
+                                    });
+    if (i == _blocks.end())
+        return;
+
+    // The spikes before the time in the first truncated block are written
+    // again with the next block
+    decode(i - _blocks.begin(), _pending);
+    _pending.erase(std::lower_bound(_pending.begin(), _pending.end(), time,
+                                    _byTime),
+                   _pending.end());
+    _size = i->offset;
+    _blocks.erase(i, _blocks.end());
+}
+
+void SpikeBlockFile::flush()
+{
+    if (!_dirty)
+        return;
+    if (!_pending.empty())
+        _writeBlock();
+
+    // The directory is written after the last block and overwritten by the
+    // blocks written after this flush
+    const size_t directoryOffset = _align(_size);
+    const size_t directorySize = _blocks.size() * sizeof(BlockInfo);
+    _reserve(directoryOffset + directorySize);
+    std::memcpy(_map.getAddress<uint8_t>() + directoryOffset, _blocks.data(),
+                directorySize);
+
+    Header* header = _map.getAddress<Header>();
+    *header = Header();
+    header->blockDuration = _blockDuration;
+    header->numBlocks = uint32_t(_blocks.size());
+    header->directoryOffset = directoryOffset;
+    header->numSpikes = getNumSpikes();
+    _map.resize(directoryOffset + directorySize);
+    _dirty = false;
+}
+
+int64_t SpikeBlockFile::_getBlockKey(const float time) const
+{
+    return int64_t(std::floor(time / _blockDuration));
+}
+
+void SpikeBlockFile::_writeBlock()
+{
+    BlockInfo info;
+    std::memset(&info, 0, sizeof(info));
+    info.startTime = _pending.front().first;
+    info.endTime = _pending.back().first;
+    info.numSpikes = uint32_t(_pending.size());
+    info.offset = _size;
+    info.firstSpike = getNumSpikes() - _pending.size();
+
+    std::vector<uint8_t> data;
+    data.reserve(_pending.size() * 3);
+    uint32_t time = 0;
+    uint32_t gid = 0;
+    for (const auto& spike : _pending)
+    {
+        const uint32_t ordered = _toOrdered(spike.first);
+        _writeVarint(ordered - time, data);
+        // Zigzag encoding keeps small negative differences small
+        const int32_t delta = int32_t(spike.second - gid);
+        _writeVarint((uint32_t(delta) << 1) ^ uint32_t(delta >> 31), data);
+        time = ordered;
+        gid = spike.second;
+    }
+    info.size = uint32_t(data.size());
+
+    uint32_ts gids;
+    gids.reserve(_pending.size());
+    for (const auto& spike : _pending)
+        gids.push_back(spike.second);
+    std::sort(gids.begin(), gids.end());
+    gids.erase(std::unique(gids.begin(), gids.end()), gids.end());
+    info.minGID = gids.front();
+    info.maxGID = gids.back();
+    info.numGIDs = uint32_t(gids.size());
+
+    info.filterOffset = _align(_size + data.size());
+    data.resize(info.filterOffset - _size);
+    if (gids.size() <= MAX_LISTED_GIDS)
+    {
+        const uint8_t* listed = reinterpret_cast<const uint8_t*>(gids.data());
+        data.insert(data.end(), listed,
+                    listed + gids.size() * sizeof(uint32_t));
+    }
+    else
+    {
+        info.filterSize =
+            uint32_t((gids.size() * BLOOM_BITS_PER_GID + 63) / 64);
+        std::vector<uint64_t> words(info.filterSize, 0);
+        const uint64_t numBits = info.filterSize * uint64_t(64);
+        const auto setBit = [&words](const uint64_t bit) {
+            words[bit >> 6] |= uint64_t(1) << (bit & 63);
+            return true;
+        };
+        for (const uint32_t id : gids)
+            _forEachBloomBit(_getHash(id), numBits, setBit);
+        const uint8_t* filter = reinterpret_cast<const uint8_t*>(words.data());
+        data.insert(data.end(), filter,
+                    filter + words.size() * sizeof(uint64_t));
+    }
+
+    _reserve(_size + data.size());
+    std::memcpy(_map.getAddress<uint8_t>() + _size, data.data(), data.size());
+    _size += data.size();
+    _blocks.push_back(info);
+    _pending.clear();
+}
+
+void SpikeBlockFile::_reserve(const size_t size)
+{
+    if (_map.getSize() < size)
+        _map.resize(std::max(size, _map.getSize() * 2));
+}
+}
+}
@@ -0,0 +1,132 @@
+/* Copyright (c) 2018, EPFL/Blue Brain Project
+ *
+ * This file is part of Brion <https://github.com/BlueBrain/Brion>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef BRION_PLUGIN_SPIKEBLOCKFILE_H
+#define BRION_PLUGIN_SPIKEBLOCKFILE_H
+
+#include <brion/types.h>
+
+#include <lunchbox/memoryMap.h>
+
+namespace brion
+{
+namespace plugin
+{
+/**
+ * Memory mapped file in the version 2 binary spike report format.
+ *
+ * The spikes are stored in blocks covering fixed time intervals, followed by
+ * a directory of the blocks:
+ * - header: 4b magic '0xf0a', 4b version '2', 4b float block duration,
+ *   4b number of blocks, 8b directory offset, 8b number of spikes
+ * - blocks: for each spike sorted by time, the varint encoded difference with
+ *   the previous spike of the order preserving bit pattern of the time, then
+ *   the zigzag varint encoded difference with the previous GID. Then, 8 bytes
+ *   aligned, the GID filter of the block: its sorted distinct GIDs as 4b
+ *   integers if there are few of them, otherwise a Bloom filter of 16 bits
+ *   per distinct GID with 3 hashes.
+ * - directory: one BlockInfo per block, 8 bytes aligned
+ *
+ * The time and GID range and the GID filter of each block allow filtered
+ * reads to skip the blocks without any requested cell. The filter is sized
+ * by the number of cells in the block, so it does not saturate for blocks
+ * of many cells.
+ */
+class SpikeBlockFile
+{
+public:
+    struct BlockInfo
+    {
+        float startTime; // time of the first spike
+        float endTime;   // time of the last spike
+        uint32_t numSpikes;
+        uint32_t size; // in bytes
+        uint64_t offset;
+        uint64_t firstSpike; // index of the first spike in the report
+        uint32_t minGID;
+        uint32_t maxGID;
+        uint32_t numGIDs;      // distinct GIDs
+        uint32_t filterSize;   // in 64 bit words, 0 if the GIDs are listed
+        uint64_t filterOffset; // of the GID list or the Bloom filter
+    };
+
+    /** Hashes of a set of GIDs, to test if a block may contain them. */
+    struct GIDHash
+    {
+        explicit GIDHash(const GIDSet& gids);
+
+        uint32_ts gids; // sorted
+        std::vector<uint64_t> hashes;
+    };
+
+    /** Open a file for reading. @throw std::runtime_error if invalid */
+    explicit SpikeBlockFile(const std::string& path);
+
+    /** Create a file for writing with blocks of the given duration. */
+    SpikeBlockFile(const std::string& path, float blockDuration);
+
+    const std::vector<BlockInfo>& getBlocks() const { return _blocks; }
+    size_t getNumSpikes() const;
+    float getEndTime() const;
+
+    /** @return the index of the block containing the given spike. */
+    size_t findBlock(size_t spike) const;
+
+    /** @return false if the block has none of the given GIDs. */
+    bool mayContain(size_t block, const GIDHash& gids) const;
+
+    /** Append the spikes of a block to a container. */
+    void decode(size_t block, Spikes& spikes) const;
+
+    /** Append spikes sorted by time, after the last ones written. */
+    void write(const Spike* spikes, size_t size);
+
+    /** Remove the spikes at and after the given time. */
+    void truncate(float time);
+
+    /** Write the pending spikes and the directory. */
+    void flush();
+
+private:
+    struct Header
+    {
+        uint32_t magic = 0xf0a;
+        uint32_t version = 2;
+        float blockDuration = 0;
+        uint32_t numBlocks = 0;
+        uint64_t directoryOffset = 0;
+        uint64_t numSpikes = 0;
+    };
+
+    lunchbox::MemoryMap _map;
+    std::vector<BlockInfo> _blocks;
+    float _blockDuration = 0;
+
+    // Write state: the spikes of the last block are kept until it is full
+    Spikes _pending;
+    size_t _size = 0; // bytes used in the map
+    bool _dirty = false;
+
+    int64_t _getBlockKey(float time) const;
+    void _writeBlock();
+    void _reserve(size_t size);
+};
+}
+}
+
+#endif
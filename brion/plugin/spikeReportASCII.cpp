@@ -19,15 +19,21 @@
 
 #include "spikeReportASCII.h"
 
-#include "../detail/skipWhiteSpace.h"
+#include "../detail/mergeSpikes.h"
+#include "../executor.h"
 #include "../pluginInitData.h"
 
 #include <boost/filesystem.hpp>
 #include <boost/regex.hpp>
 
+#include <lunchbox/memoryMap.h>
 #include <lunchbox/pluginRegisterer.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cctype>
 #include <cmath>
+#include <cstring>
 #include <fstream>
 
 namespace brion
@@ -36,7 +42,8 @@ namespace plugin
 {
 SpikeReportASCII::SpikeReportASCII(const SpikeReportInitData& initData)
     : SpikeReportPlugin(initData)
-    , _lastReadPosition(_spikes.begin())
+    , _spikes(std::make_shared<const Spikes>())
+    , _lastReadPosition(_spikes->begin())
 {
     // clear the file if it exists
     if (initData.getAccessMode() == MODE_WRITE &&
@@ -49,18 +56,33 @@ SpikeReportASCII::SpikeReportASCII(const SpikeReportInitData& initData)
     }
 }
 
+SpikeReportASCII::SpikeReportASCII(const SpikeReportASCII& from)
+    : SpikeReportPlugin(SpikeReportInitData(from.getURI(), MODE_READ))
+    , _spikes(from._spikes)
+    , _lastReadPosition(_spikes->begin())
+{
+    initCursor(from);
+}
+
+std::unique_ptr<SpikeReportPlugin> SpikeReportASCII::createCursor() const
+{
+    return std::unique_ptr<SpikeReportPlugin>(new SpikeReportASCII(*this));
+}
+
 Spikes SpikeReportASCII::read(const float)
 {
     // In file based reports, this function reads all remaining data.
     Spikes spikes;
     auto start = _lastReadPosition;
-    _lastReadPosition = _spikes.end();
+    _lastReadPosition = _spikes->end();
     _currentTime = UNDEFINED_TIMESTAMP;
     _state = State::ended;
 
-    for (; start != _spikes.end(); ++start)
-        pushBack(*start, spikes);
+    const Spike* data = _spikes->data();
+    pushBack(data + (start - _spikes->begin()), data + _spikes->size(),
+             spikes);
 
+    _ioCounters.bytesRequested += spikes.size() * sizeof(Spike);
     return spikes;
 }
 
@@ -70,12 +92,12 @@ Spikes SpikeReportASCII::readUntil(const float toTimeStamp)
     auto start = _lastReadPosition;
 
     _lastReadPosition =
-        std::lower_bound(_lastReadPosition, _spikes.end(), toTimeStamp,
+        std::lower_bound(_lastReadPosition, _spikes->end(), toTimeStamp,
                          [](const Spike& spike, float val) {
                              return spike.first < val;
                          });
 
-    if (_lastReadPosition != _spikes.end())
+    if (_lastReadPosition != _spikes->end())
         _currentTime = _lastReadPosition->first;
     else
     {
@@ -83,41 +105,38 @@ Spikes SpikeReportASCII::readUntil(const float toTimeStamp)
         _state = State::ended;
     }
 
-    if (start != _spikes.end())
-    {
-        std::for_each(start, _lastReadPosition,
-                      [&spikes, this](const Spike& spike) {
-                          pushBack(spike, spikes);
-                      });
-    }
+    const Spike* data = _spikes->data();
+    pushBack(data + (start - _spikes->begin()),
+             data + (_lastReadPosition - _spikes->begin()), spikes);
+    _ioCounters.bytesRequested += spikes.size() * sizeof(Spike);
     return spikes;
 }
 
 void SpikeReportASCII::readSeek(const float toTimeStamp)
 {
-    if (_spikes.empty())
+    if (_spikes->empty())
     {
         _currentTime = UNDEFINED_TIMESTAMP;
         _state = State::ended;
         return;
     }
 
-    if (toTimeStamp < _spikes.begin()->first)
+    if (toTimeStamp < _spikes->begin()->first)
     {
-        _lastReadPosition = _spikes.begin();
+        _lastReadPosition = _spikes->begin();
         _state = State::ok;
         _currentTime = toTimeStamp;
     }
-    else if (toTimeStamp > _spikes.rbegin()->first)
+    else if (toTimeStamp > _spikes->rbegin()->first)
     {
-        _lastReadPosition = _spikes.end();
+        _lastReadPosition = _spikes->end();
         _state = State::ended;
         _currentTime = brion::UNDEFINED_TIMESTAMP;
     }
     else
     {
         _lastReadPosition =
-            std::lower_bound(_spikes.begin(), _spikes.end(), toTimeStamp,
+            std::lower_bound(_spikes->begin(), _spikes->end(), toTimeStamp,
                              [](const Spike& spike, float val) {
                                  return spike.first < val;
                              });
@@ -137,100 +156,374 @@ void SpikeReportASCII::writeSeek(const float toTimeStamp)
 
 namespace
 {
-void _parse(Spikes& spikes, const std::string& filename,
-            const std::function<bool(const std::string&, Spike&)>& parse)
+using ParseFunc = std::function<bool(const char*, const char*, Spike&)>;
+
+// Files are split in ranges of at least this size for parallel parsing
+constexpr size_t _minRangeSize = 1 << 20;
+// Below this number of spikes per thread, runs are merged sequentially
+constexpr size_t _minMergeSize = 1 << 16;
+// Largest exponent for which 10^n is exact as a double
+constexpr int _maxExactPow10 = 22;
+
+bool _isBlank(const char c)
 {
-    std::fstream file(filename.c_str(),
-                      std::ios_base::binary | std::ios_base::in);
+    return c == ' ' || c == '\t';
+}
 
-    size_t lineNumber = 0;
-    file >> detail::SkipWhiteSpace(lineNumber);
+bool _isDigit(const char c)
+{
+    return c >= '0' && c <= '9';
+}
 
-#ifdef BRION_USE_OPENMP
-    // The batch size is divisible by all reasonable core counts between 1
-    // and 50.
-    const size_t batchSize = 554400;
+double _pow10(const int exponent)
+{
+    static const double powers[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,
+                                    1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                    1e12, 1e13, 1e14, 1e15, 1e16, 1e17,
+                                    1e18, 1e19, 1e20, 1e21, 1e22};
+    return powers[exponent];
+}
 
-    while (!file.fail())
-    {
-        // Reading a batch of strings to parse in parallel
-        Strings lines(batchSize);
-        size_t linesRead = 0;
+struct ParsedRange
+{
+    Spikes spikes;
+    const char* error = nullptr; // start of the first invalid line
+};
 
-        while (linesRead != lines.size() &&
-               !std::getline(file, lines[linesRead]).fail())
+// Parses the lines in [begin, end) and sorts the result
+void _parseRange(const char* begin, const char* end,
+                 const ParseFunc& parse, ParsedRange& result)
+{
+    // Spike lines are rarely shorter than 16 characters
+    result.spikes.reserve((end - begin) / 16);
+    const char* pos = begin;
+    while (pos != end)
+    {
+        if (std::isspace(static_cast<unsigned char>(*pos)))
         {
-            // This check skips comments
-            const char c = lines[linesRead][0];
-            if (c != '/' && c != '#')
-                ++linesRead;
-            size_t skipCount = 0;
-            file >> detail::SkipWhiteSpace(skipCount);
+            ++pos;
+            continue;
         }
 
-        const size_t first = spikes.size();
-        spikes.resize(first + linesRead);
+        const char* lineEnd =
+            static_cast<const char*>(std::memchr(pos, '\n', end - pos));
+        if (!lineEnd)
+            lineEnd = end;
 
-// Parsing strings
-#pragma omp parallel for
-        for (int64_t i = 0; i < int64_t(linesRead); ++i)
+        // This check skips comments
+        if (*pos != '/' && *pos != '#')
         {
-            const std::string& line = lines[i];
-            if (!parse(line.c_str(), spikes[first + i]))
+            Spike spike;
+            if (!parse(pos, lineEnd, spike))
             {
-                // Getting the line number right is not possible unless the
-                // line numbers are stored along with the strings.
-                // Instead of telling the line number, the full line will be
-                // printed. The error should be easy to spot in the file as
-                // it will be found at the first occurence in the file.
-                LBERROR << "Error reading spike times file: " << filename
-                        << ", line: " << lines[i] << std::endl;
+                result.error = pos;
+                return;
             }
+            result.spikes.push_back(spike);
         }
+        pos = lineEnd;
     }
-#else
-    std::string line;
-    while (!std::getline(file, line).fail())
-    {
-        ++lineNumber;
-        if (line[0] == '/' || line[0] == '#')
-            continue;
+    if (!std::is_sorted(result.spikes.begin(), result.spikes.end()))
+        std::sort(result.spikes.begin(), result.spikes.end());
+}
+
+// Waits for all the tasks, which refer to the caller's stack, before
+// rethrowing the first exception.
+void _waitAll(std::vector<std::future<void>>& tasks)
+{
+    for (auto& task : tasks)
+        task.wait();
+    for (auto& task : tasks)
+        task.get();
+}
+
+// Appends the sorted runs of spikes parsed from a file split in up to
+// maxRanges ranges parsed in parallel.
+void _parse(std::vector<Spikes>& runs, const std::string& filename,
+            const ParseFunc& parse, detail::IOCounters& counters,
+            const size_t maxRanges)
+{
+    boost::system::error_code error;
+    const size_t size = boost::filesystem::file_size(filename, error);
+    if (error)
+        LBTHROW(std::runtime_error("IO error reading spike times file: " +
+                                   filename));
+    if (size == 0)
+        return;
+
+    const lunchbox::MemoryMap map(filename);
+    const char* data = map.getAddress<char>();
+    if (!data)
+        LBTHROW(std::runtime_error("IO error reading spike times file: " +
+                                   filename));
+    counters.addRead(size);
 
-        Spike spike;
-        if (!parse(line.c_str(), spike))
+    // Split the file at line boundaries, one range per thread
+    const size_t numRanges =
+        std::max(size_t(1), std::min(maxRanges, size / _minRangeSize));
+    std::vector<const char*> bounds{data};
+    for (size_t i = 1; i < numRanges; ++i)
+    {
+        const char* pos = std::max(bounds.back(), data + size * i / numRanges);
+        const char* lineEnd = static_cast<const char*>(
+            std::memchr(pos, '\n', data + size - pos));
+        bounds.push_back(lineEnd ? lineEnd + 1 : data + size);
+    }
+    bounds.push_back(data + size);
+
+    std::vector<ParsedRange> ranges(numRanges);
+    auto executor = Executor::getDefault();
+    std::vector<std::future<void>> tasks;
+    for (size_t i = 0; i < numRanges; ++i)
+        tasks.push_back(executor->post(
+            [&, i] {
+                _parseRange(bounds[i], bounds[i + 1], parse, ranges[i]);
+            },
+            Executor::Priority::bulk));
+    _waitAll(tasks);
+
+    for (auto& range : ranges)
+    {
+        if (range.error)
         {
+            const size_t line = std::count(data, range.error, '\n') + 1;
             LBTHROW(std::runtime_error("Parsing spike times file " + filename +
                                        " failed at line " +
-                                       std::to_string(lineNumber)));
+                                       std::to_string(line)));
         }
-        spikes.emplace_back(spike);
+        if (!range.spikes.empty())
+            runs.push_back(std::move(range.spikes));
+    }
+}
 
-        file >> detail::SkipWhiteSpace(lineNumber);
+// Appends the sorted runs of spikes parsed from the given files. Large files
+// are split over all the threads of the executor, the others are parsed
+// concurrently, one file per task.
+void _parse(std::vector<Spikes>& runs, const Strings& files,
+            const ParseFunc& parse, detail::IOCounters& counters)
+{
+    auto executor = Executor::getDefault();
+    const size_t numThreads = executor->getSize();
+    Strings smallFiles;
+    for (const auto& file : files)
+    {
+        boost::system::error_code error;
+        const size_t size = boost::filesystem::file_size(file, error);
+        if (!error && size >= numThreads * _minRangeSize)
+            _parse(runs, file, parse, counters, numThreads);
+        else
+            smallFiles.push_back(file);
     }
-#endif
 
-    if (file.fail() && !file.eof())
-        LBTHROW(std::runtime_error("IO error reading spike times file: " +
-                                   filename));
+    std::vector<std::vector<Spikes>> parsed(smallFiles.size());
+    std::atomic<bool> failed{false};
+    std::vector<std::future<void>> tasks;
+    for (size_t i = 0; i < smallFiles.size(); ++i)
+        tasks.push_back(executor->post(
+            [&, i] {
+                if (failed) // skip the remaining files after an error
+                    return;
+                try
+                {
+                    _parse(parsed[i], smallFiles[i], parse, counters, 1);
+                }
+                catch (...)
+                {
+                    failed = true;
+                    throw;
+                }
+            },
+            Executor::Priority::bulk));
+    _waitAll(tasks);
+
+    for (auto& fileRuns : parsed)
+        for (auto& run : fileRuns)
+            runs.push_back(std::move(run));
+}
+
+// Merges sorted runs of spikes with a k-way merge. The output is partitioned
+// by splitter spikes sampled from the runs, and the partitions are merged in
+// parallel.
+Spikes _merge(std::vector<Spikes>& runs)
+{
+    if (runs.size() == 1)
+        return std::move(runs[0]);
+
+    size_t total = 0;
+    for (const auto& run : runs)
+        total += run.size();
+
+    auto executor = Executor::getDefault();
+    const size_t numParts = std::max(
+        size_t(1), std::min(executor->getSize(), total / _minMergeSize));
+
+    // Spikes evenly spaced in each run give splitters which divide the output
+    // into parts of similar sizes.
+    Spikes samples;
+    for (const auto& run : runs)
+        for (size_t i = 1; i < numParts; ++i)
+            samples.push_back(run[run.size() * i / numParts]);
+    std::sort(samples.begin(), samples.end());
+    Spikes splitters;
+    for (size_t i = 1; i < numParts; ++i)
+        splitters.push_back(samples[samples.size() * i / numParts]);
+
+    // parts[p][r] is the range of run r merged into part p, starting at
+    // offsets[p] in the output
+    std::vector<std::vector<detail::SpikeRange>> parts(numParts);
+    std::vector<size_t> offsets(numParts + 1, 0);
+    for (const auto& run : runs)
+    {
+        const Spike* begin = run.data();
+        for (size_t p = 0; p < numParts; ++p)
+        {
+            const Spike* end =
+                p + 1 < numParts
+                    ? std::lower_bound(begin, run.data() + run.size(),
+                                       splitters[p])
+                    : run.data() + run.size();
+            parts[p].emplace_back(begin, end);
+            offsets[p + 1] += end - begin;
+            begin = end;
+        }
+    }
+    for (size_t p = 0; p < numParts; ++p)
+        offsets[p + 1] += offsets[p];
+
+    Spikes spikes(total);
+    std::vector<std::future<void>> tasks;
+    for (size_t p = 1; p < numParts; ++p)
+        tasks.push_back(executor->post(
+            [&, p] {
+                detail::mergeSpikes(parts[p], spikes.data() + offsets[p]);
+            },
+            Executor::Priority::bulk));
+    detail::mergeSpikes(parts[0], spikes.data());
+    _waitAll(tasks);
+    return spikes;
+}
+}
+
+bool SpikeReportASCII::parseNumber(const char*& pos, const char* end,
+                                   uint32_t& value)
+{
+    const char* i = pos;
+    while (i != end && _isBlank(*i))
+        ++i;
+    if (i != end && *i == '+')
+        ++i;
+    if (i == end || !_isDigit(*i))
+        return false;
+
+    uint64_t result = 0;
+    for (; i != end && _isDigit(*i); ++i)
+    {
+        result = result * 10 + (*i - '0');
+        if (result > std::numeric_limits<uint32_t>::max())
+            return false;
+    }
+    value = uint32_t(result);
+    pos = i;
+    return true;
 }
+
+bool SpikeReportASCII::parseNumber(const char*& pos, const char* end,
+                                   float& value)
+{
+    const char* i = pos;
+    while (i != end && _isBlank(*i))
+        ++i;
+    const char* const first = i;
+
+    bool negative = false;
+    if (i != end && (*i == '-' || *i == '+'))
+        negative = *i++ == '-';
+
+    // Decimal significand, the digits which do not fit are accounted in the
+    // exponent.
+    uint64_t significand = 0;
+    int digits = 0;
+    int exponent = 0;
+    bool valid = false;
+    for (; i != end && _isDigit(*i); ++i, valid = true)
+    {
+        if (digits < 19)
+        {
+            significand = significand * 10 + (*i - '0');
+            digits += significand != 0;
+        }
+        else
+            ++exponent;
+    }
+    if (i != end && *i == '.')
+    {
+        for (++i; i != end && _isDigit(*i); ++i, valid = true)
+        {
+            if (digits < 19)
+            {
+                significand = significand * 10 + (*i - '0');
+                digits += significand != 0;
+                --exponent;
+            }
+        }
+    }
+    if (!valid)
+        return false;
+
+    if (i != end && (*i == 'e' || *i == 'E'))
+    {
+        const char* j = i + 1;
+        bool negativeExponent = false;
+        if (j != end && (*j == '-' || *j == '+'))
+            negativeExponent = *j++ == '-';
+        if (j != end && _isDigit(*j))
+        {
+            int e = 0;
+            for (; j != end && _isDigit(*j); ++j)
+                e = std::min(e * 10 + (*j - '0'), 100000);
+            exponent += negativeExponent ? -e : e;
+            i = j;
+        }
+    }
+
+    double result;
+    if (significand < (uint64_t(1) << 53) && exponent >= -_maxExactPow10 &&
+        exponent <= _maxExactPow10)
+    {
+        // Both operands are exact, so the result is correctly rounded
+        result = exponent < 0 ? double(significand) / _pow10(-exponent)
+                              : double(significand) * _pow10(exponent);
+    }
+    else
+    {
+        // Rare case of a long significand or a large exponent
+        const std::string number(first, i);
+        value = std::strtof(number.c_str(), nullptr);
+        pos = i;
+        return true;
+    }
+
+    value = float(negative ? -result : result);
+    pos = i;
+    return true;
 }
 
 Spikes SpikeReportASCII::parse(const Strings& files, const ParseFunc& parse)
 {
-    Spikes spikes;
-    for (const auto& file : files)
-        _parse(spikes, file, parse);
-    std::sort(spikes.begin(), spikes.end());
-    return spikes;
+    // The text is read and parsed in the same pass, all is accounted as
+    // decoding.
+    detail::ScopedTimer timer(_ioCounters.decodeTime);
+    std::vector<Spikes> runs;
+    _parse(runs, files, parse, _ioCounters);
+    if (runs.empty())
+        return Spikes();
+    return _merge(runs);
 }
 
 Spikes SpikeReportASCII::parse(const std::string& filename,
                                const ParseFunc& parse)
 {
-    Spikes spikes;
-    _parse(spikes, filename, parse);
-    std::sort(spikes.begin(), spikes.end());
-    return spikes;
+    return SpikeReportASCII::parse(Strings{filename}, parse);
 }
 
 void SpikeReportASCII::append(const Spike* spikes, const size_t size,
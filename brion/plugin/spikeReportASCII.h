@@ -20,6 +20,7 @@
 #ifndef BRION_PLUGIN_SPIKEREPORTASCII_H
 #define BRION_PLUGIN_SPIKEREPORTASCII_H
 
+#include "../detail/ioCounters.h"
 #include "../pluginInitData.h"
 
 #include <brion/spikeReportPlugin.h>
@@ -34,23 +35,40 @@ class SpikeReportASCII : public SpikeReportPlugin
 public:
     explicit SpikeReportASCII(const SpikeReportInitData& initData);
 
+    /** Create a read cursor sharing the spikes parsed by another report. */
+    explicit SpikeReportASCII(const SpikeReportASCII& from);
+
+    void close() override {}
     Spikes read(float min) final;
     Spikes readUntil(float toTimeStamp) final;
     void readSeek(float toTimeStamp) final;
     void writeSeek(float toTimeStamp) final;
     bool supportsBackwardSeek() const final { return true; }
+    std::unique_ptr<SpikeReportPlugin> createCursor() const final;
+    IOStatistics getIOStatistics() const final { return _ioCounters.get(); }
+    void resetIOStatistics() final { _ioCounters.reset(); }
+
 protected:
-    Spikes _spikes;
-    Spikes::iterator _lastReadPosition;
+    // Shared by the cursors created from a report open in read mode
+    std::shared_ptr<const Spikes> _spikes;
+    Spikes::const_iterator _lastReadPosition;
+    detail::IOCounters _ioCounters;
 
-    // Returns true if parsing succeeded
-    using ParseFunc = std::function<bool(const std::string&, Spike&)>;
+    // Parses the line [begin, end), returns true if parsing succeeded
+    using ParseFunc =
+        std::function<bool(const char* begin, const char* end, Spike&)>;
 
     using WriteFunc = std::function<void(std::ostream&, const Spike&)>;
 
-    static Spikes parse(const Strings& files, const ParseFunc& parse);
-    static Spikes parse(const std::string& filename, const ParseFunc& parse);
+    Spikes parse(const Strings& files, const ParseFunc& parse);
+    Spikes parse(const std::string& filename, const ParseFunc& parse);
     void append(const Spike* spikes, size_t size, const WriteFunc& writeFunc);
+
+    // Parse a number after optional blanks at pos and move pos past it.
+    // Returns false if there is no number at pos.
+    static bool parseNumber(const char*& pos, const char* end,
+                            uint32_t& value);
+    static bool parseNumber(const char*& pos, const char* end, float& value);
 };
 }
 }
@@ -20,13 +20,18 @@
 
 #include "spikeReportBinary.h"
 
+#include "../detail/atomicFile.h"
+
+#include <lunchbox/log.h>
 #include <lunchbox/memoryMap.h>
 #include <lunchbox/pluginRegisterer.h>
 
 #include <boost/filesystem.hpp>
 #include <boost/filesystem/path.hpp>
 
+#include <algorithm>
 #include <fstream>
+#include <mutex>
 
 namespace brion
 {
@@ -36,6 +41,43 @@ namespace
 {
 lunchbox::PluginRegisterer<SpikeReportBinary> registerer;
 const char* const BINARY_REPORT_FILE_EXT = ".spikes";
+const char* const INDEX_FILE_EXT = ".idx";
+const float DEFAULT_BLOCK_DURATION = 10.f;
+
+// Spikes per entry of the time index, one page of 4 KiB
+const uint32_t INDEX_STRIDE = 4096 / sizeof(Spike);
+// Indices of smaller reports are cheap to rebuild and are not persisted
+const size_t MIN_PERSISTENT_INDEX_SPIKES = 1 << 20;
+
+uint32_t _getVersion(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    uint32_t header[2] = {0, 0};
+    file.read(reinterpret_cast<char*>(header), sizeof(header));
+    return header[0] == 0xf0a ? header[1] : 0;
+}
+
+uint32_t _getVersion(const URI& uri)
+{
+    const auto i = uri.findQuery("version");
+    if (i == uri.queryEnd() || i->second == "1")
+        return 1;
+    if (i->second == "2")
+        return 2;
+    LBTHROW(std::runtime_error("Unsupported binary spike report version " +
+                               i->second));
+}
+
+float _getBlockDuration(const URI& uri)
+{
+    const auto i = uri.findQuery("block_duration");
+    return i == uri.queryEnd() ? DEFAULT_BLOCK_DURATION : std::stof(i->second);
+}
+
+bool _byTime(const Spike& spike, const float time)
+{
+    return spike.first < time;
+}
 }
 
 namespace fs = boost::filesystem;
@@ -49,12 +91,27 @@ private:
     uint32_t _version = 1;
 };
 
+/**
+ * The header of the sidecar file of the time index of a version 1 report. It
+ * is followed by the times of the indexed spikes.
+ */
+struct IndexHeader
+{
+    uint32_t magic = 0xf0b;
+    uint32_t version = 1;
+    uint64_t numSpikes = 0; // of the report
+    float lastTime = 0;     // of the report
+    uint32_t stride = INDEX_STRIDE;
+};
+
 class BinaryReportMap
 {
 public:
     // Read-only mapping
     BinaryReportMap(const std::string& path)
         : _map(path)
+        , _path(path)
+        , _readOnly(true)
     {
         const size_t totalSize = _map.getSize();
         if (totalSize < sizeof(Header) || (totalSize % sizeof(uint32_t)) != 0)
@@ -72,8 +129,14 @@ public:
     // read-write mapping
     BinaryReportMap(const std::string& path, size_t nSpikes)
         : _map(path, sizeof(Header) + sizeof(Spike) * nSpikes)
+        , _path(path)
+        , _readOnly(false)
     {
         *(_map.getAddress<Header>()) = Header();
+
+        // The time index of the previous report is stale
+        boost::system::error_code error;
+        fs::remove(_path + INDEX_FILE_EXT, error);
     }
 
     void resize(const size_t nSpikes)
@@ -98,17 +161,132 @@ public:
                                         sizeof(Header));
     }
 
+    /**
+     * @return the first spike not before the given time. The time index
+     * bounds the binary search to one page of spikes, so that a seek on a
+     * cold cache does not fault in pages all over the file.
+     */
+    const Spike* lowerBound(const float time) const
+    {
+        const Spike* spikes = getReadableSpikes();
+        const size_t nElems = getNumSpikes();
+        // Reports being written grow, they are not indexed
+        if (!_readOnly)
+            return std::lower_bound(spikes, spikes + nElems, time, _byTime);
+
+        std::call_once(_indexLoaded, [this] { _loadIndex(); });
+        const size_t entry =
+            std::lower_bound(_index.begin(), _index.end(), time) -
+            _index.begin();
+        const size_t first = entry == 0 ? 0 : (entry - 1) * INDEX_STRIDE;
+        const size_t last = std::min(nElems, entry * INDEX_STRIDE);
+        return std::lower_bound(spikes + first, spikes + last, time, _byTime);
+    }
+
 private:
     lunchbox::MemoryMap _map;
+    const std::string _path;
+    const bool _readOnly;
+
+    // The time of every INDEX_STRIDE-th spike, loaded on first use
+    mutable floats _index;
+    mutable std::once_flag _indexLoaded;
+
+    void _loadIndex() const
+    {
+        const std::string indexPath = _path + INDEX_FILE_EXT;
+        const size_t nElems = getNumSpikes();
+        if (nElems >= MIN_PERSISTENT_INDEX_SPIKES && _readIndex(indexPath))
+            return;
+
+        const Spike* spikes = getReadableSpikes();
+        _index.clear();
+        _index.reserve((nElems + INDEX_STRIDE - 1) / INDEX_STRIDE);
+        for (size_t i = 0; i < nElems; i += INDEX_STRIDE)
+            _index.push_back(spikes[i].first);
+
+        if (nElems >= MIN_PERSISTENT_INDEX_SPIKES)
+            _writeIndex(indexPath);
+    }
+
+    IndexHeader _getIndexHeader() const
+    {
+        IndexHeader header;
+        header.numSpikes = getNumSpikes();
+        if (header.numSpikes > 0)
+            header.lastTime = getReadableSpikes()[header.numSpikes - 1].first;
+        return header;
+    }
+
+    bool _readIndex(const std::string& indexPath) const
+    {
+        // An index older than the report is stale
+        boost::system::error_code error;
+        const auto indexTime = fs::last_write_time(indexPath, error);
+        if (error)
+            return false;
+        const auto reportTime = fs::last_write_time(_path, error);
+        if (error || indexTime < reportTime)
+            return false;
+
+        std::ifstream file(indexPath, std::ios::binary);
+        IndexHeader header;
+        file.read(reinterpret_cast<char*>(&header), sizeof(header));
+        const IndexHeader expected = _getIndexHeader();
+        if (!file || header.magic != expected.magic ||
+            header.version != expected.version ||
+            header.numSpikes != expected.numSpikes ||
+            header.lastTime != expected.lastTime ||
+            header.stride != expected.stride)
+        {
+            return false;
+        }
+
+        _index.resize((header.numSpikes + INDEX_STRIDE - 1) / INDEX_STRIDE);
+        file.read(reinterpret_cast<char*>(_index.data()),
+                  _index.size() * sizeof(float));
+        return bool(file);
+    }
+
+    void _writeIndex(const std::string& indexPath) const
+    {
+        const IndexHeader header = _getIndexHeader();
+        detail::AtomicFile file(indexPath);
+        file.stream.write(reinterpret_cast<const char*>(&header),
+                          sizeof(header));
+        file.stream.write(reinterpret_cast<const char*>(_index.data()),
+                          _index.size() * sizeof(float));
+        if (!file.commit())
+        {
+            // The directory may be read-only, the index stays in memory
+            LBDEBUG << "Cannot write spike time index " << indexPath
+                    << std::endl;
+        }
+    }
 };
 
 SpikeReportBinary::SpikeReportBinary(const SpikeReportInitData& initData)
     : SpikeReportPlugin(initData)
 {
+    const URI& uri = getURI();
+    const bool blocks = _accessMode == MODE_READ
+                            ? _getVersion(uri.getPath()) == 2
+                            : _getVersion(uri) == 2;
+    if (blocks)
+    {
+        if (_accessMode == MODE_READ)
+            _blockFile.reset(new SpikeBlockFile(uri.getPath()));
+        else
+            _blockFile.reset(
+                new SpikeBlockFile(uri.getPath(), _getBlockDuration(uri)));
+        _endTime = _blockFile->getEndTime();
+        return;
+    }
+
     if (_accessMode == MODE_READ)
-        _memFile.reset(new BinaryReportMap(getURI().getPath()));
+        _memFile.reset(new BinaryReportMap(uri.getPath()));
     else
-        _memFile.reset(new BinaryReportMap(getURI().getPath(), 0));
+        _memFile.reset(new BinaryReportMap(uri.getPath(), 0));
 
     const Spike* spikeArray = _memFile->getReadableSpikes();
     const size_t nElems = _memFile->getNumSpikes();
@@ -116,6 +294,14 @@ SpikeReportBinary::SpikeReportBinary(const SpikeReportInitData& initData)
         _endTime = spikeArray[nElems - 1].first;
 }
 
+SpikeReportBinary::SpikeReportBinary(const SpikeReportBinary& from)
+    : SpikeReportPlugin(SpikeReportInitData(from.getURI(), MODE_READ))
+    , _memFile(from._memFile)
+    , _blockFile(from._blockFile)
+{
+    initCursor(from);
+}
+
 bool SpikeReportBinary::handles(const SpikeReportInitData& initData)
 {
     const URI& uri = initData.getURI();
@@ -133,37 +319,50 @@ std::string SpikeReportBinary::getDescription()
            std::string(BINARY_REPORT_FILE_EXT);
 }
 
+void SpikeReportBinary::close()
+{
+    if (_blockFile && _accessMode == MODE_WRITE)
+        _blockFile->flush();
+}
+
 Spikes SpikeReportBinary::read(const float)
 {
     // In file based reports, this function reads all remaining data.
+    if (_blockFile)
+        return _readBlocks(UNDEFINED_TIMESTAMP);
+
     Spikes spikes;
     const Spike* spikeArray = _memFile->getReadableSpikes();
     const size_t nElems = _memFile->getNumSpikes();
+    const size_t first = _startIndex;
 
-    for (; _startIndex < nElems; ++_startIndex)
-        pushBack(spikeArray[_startIndex], spikes);
+    pushBack(spikeArray + _startIndex, spikeArray + nElems, spikes);
+    _startIndex = nElems;
 
     _currentTime = UNDEFINED_TIMESTAMP;
     _state = State::ended;
+    _accountRead(first, spikes);
     return spikes;
 }
 
 Spikes SpikeReportBinary::readUntil(const float max)
 {
+    if (_blockFile)
+        return _readBlocks(max);
+
     Spikes spikes;
 
     const Spike* spikeArray = _memFile->getReadableSpikes();
     const size_t nElems = _memFile->getNumSpikes();
+    const size_t first = _startIndex;
 
-    for (; _startIndex < nElems; ++_startIndex)
-    {
-        if (spikeArray[_startIndex].first >= max)
-        {
-            _currentTime = spikeArray[_startIndex].first;
-            break;
-        }
-        pushBack(spikeArray[_startIndex], spikes);
-    }
+    const Spike* end =
+        std::find_if(spikeArray + _startIndex, spikeArray + nElems,
+                     [max](const Spike& spike) { return spike.first >= max; });
+    pushBack(spikeArray + _startIndex, end, spikes);
+    _startIndex = end - spikeArray;
+    if (_startIndex < nElems)
+        _currentTime = end->first;
 
     if (_startIndex == nElems)
     {
@@ -171,33 +370,22 @@ Spikes SpikeReportBinary::readUntil(const float max)
         _state = State::ended;
     }
 
+    _accountRead(first, spikes);
     return spikes;
 }
 
 void SpikeReportBinary::readSeek(const float toTimeStamp)
 {
-    const Spike* spikeArray = _memFile->getReadableSpikes();
-    const size_t nElems = _memFile->getNumSpikes();
-
-    const Spike* position = nullptr;
-
-    if (toTimeStamp < _currentTime)
+    if (_blockFile)
     {
-        position =
-            std::lower_bound(spikeArray, spikeArray + _startIndex, toTimeStamp,
-                             [](const Spike& spike, const float val) {
-                                 return spike.first < val;
-                             });
-    }
-    else
-    {
-        position = std::lower_bound(spikeArray + _startIndex,
-                                    spikeArray + nElems, toTimeStamp,
-                                    [](const Spike& spike, const float val) {
-                                        return spike.first < val;
-                                    });
+        _seekBlocks(toTimeStamp);
+        return;
     }
 
+    const Spike* spikeArray = _memFile->getReadableSpikes();
+    const size_t nElems = _memFile->getNumSpikes();
+    const Spike* position = _memFile->lowerBound(toTimeStamp);
+
     if (position == (spikeArray + nElems)) // end
     {
         _startIndex = nElems;
@@ -214,11 +402,31 @@ void SpikeReportBinary::readSeek(const float toTimeStamp)
 
 void SpikeReportBinary::writeSeek(float toTimeStamp)
 {
-    readSeek(toTimeStamp);
+    if (!_blockFile)
+    {
+        readSeek(toTimeStamp);
+        return;
+    }
+
+    _blockFile->truncate(toTimeStamp);
+    _currentTime = toTimeStamp;
+    _endTime = _blockFile->getEndTime();
 }
 
 void SpikeReportBinary::write(const Spike* spikes, const size_t size)
 {
+    if (_blockFile)
+    {
+        if (size == 0)
+            return;
+        _blockFile->write(spikes, size);
+        const float lastTimestamp = spikes[size - 1].first;
+        _currentTime =
+            std::nextafter(lastTimestamp, std::numeric_limits<float>::max());
+        _endTime = std::max(_endTime, lastTimestamp);
+        return;
+    }
+
     size_t totalSpikes = _startIndex + size;
 
     if (size == 0)
@@ -237,5 +445,132 @@ void SpikeReportBinary::write(const Spike* spikes, const size_t size)
         std::nextafter(lastTimestamp, std::numeric_limits<float>::max());
     _endTime = std::max(_endTime, lastTimestamp);
 }
+
+std::unique_ptr<SpikeReportPlugin> SpikeReportBinary::createCursor() const
+{
+    return std::unique_ptr<SpikeReportPlugin>(new SpikeReportBinary(*this));
+}
+
+bool SpikeReportBinary::supportsViews() const
+{
+    // Filtered and compressed spikes are not contiguous in the file
+    return _memFile && _accessMode == MODE_READ && _filter.empty();
+}
+
+SpikesView SpikeReportBinary::getView(const float start, const float end) const
+{
+    const Spike* last =
+        _memFile->getReadableSpikes() + _memFile->getNumSpikes();
+    SpikesView view;
+    view.data = _memFile->lowerBound(start);
+    view.size = std::lower_bound(view.data, last, end, _byTime) - view.data;
+    return view;
+}
+
+void SpikeReportBinary::_accountRead(const size_t first, const Spikes& spikes)
+{
+    // All scanned spikes are read from the memory map, including the ones
+    // rejected by the GID filter.
+    _ioCounters.bytesRequested += spikes.size() * sizeof(Spike);
+    _ioCounters.addRead((_startIndex - first) * sizeof(Spike));
+}
+
+Spikes SpikeReportBinary::_readBlocks(const float max)
+{
+    Spikes spikes;
+    const auto& blocks = _blockFile->getBlocks();
+    const size_t nElems = _blockFile->getNumSpikes();
+    float nextTime = UNDEFINED_TIMESTAMP;
+
+    for (size_t i = _blockFile->findBlock(_startIndex); i < blocks.size(); ++i)
+    {
+        const auto& block = blocks[i];
+        if (block.startTime >= max)
+        {
+            nextTime = block.startTime;
+            break;
+        }
+
+        // Blocks read to the end are only decoded if they may contain
+        // requested cells
+        if (block.endTime < max && !_mayContainFilteredGIDs(i))
+        {
+            _startIndex = block.firstSpike + block.numSpikes;
+            continue;
+        }
+
+        const Spikes& decoded = _decode(i);
+        const Spike* begin =
+            decoded.data() + (_startIndex - block.firstSpike);
+        const Spike* end = std::lower_bound(
+            begin, decoded.data() + decoded.size(), max, _byTime);
+        pushBack(begin, end, spikes);
+        _startIndex += end - begin;
+        if (end != decoded.data() + decoded.size())
+        {
+            nextTime = end->first;
+            break;
+        }
+    }
+
+    if (_startIndex < nElems)
+        _currentTime = nextTime;
+    else
+    {
+        _currentTime = UNDEFINED_TIMESTAMP;
+        _state = State::ended;
+    }
+    _ioCounters.bytesRequested += spikes.size() * sizeof(Spike);
+    return spikes;
+}
+
+void SpikeReportBinary::_seekBlocks(const float toTimeStamp)
+{
+    const auto& blocks = _blockFile->getBlocks();
+    const auto i =
+        std::lower_bound(blocks.begin(), blocks.end(), toTimeStamp,
+                         [](const SpikeBlockFile::BlockInfo& block,
+                            const float val) { return block.endTime < val; });
+    if (i == blocks.end())
+    {
+        _startIndex = _blockFile->getNumSpikes();
+        _state = State::ended;
+        _currentTime = UNDEFINED_TIMESTAMP;
+        return;
+    }
+
+    const Spikes& decoded = _decode(i - blocks.begin());
+    const auto position = std::lower_bound(decoded.begin(), decoded.end(),
+                                           toTimeStamp, _byTime);
+    _startIndex = i->firstSpike + (position - decoded.begin());
+    _state = State::ok;
+    _currentTime = toTimeStamp;
+}
+
+const Spikes& SpikeReportBinary::_decode(const size_t block)
+{
+    if (block == _blockIndex)
+    {
+        ++_ioCounters.cacheHits;
+        return _block;
+    }
+
+    ++_ioCounters.cacheMisses;
+    detail::ScopedTimer timer(_ioCounters.decodeTime);
+    _block.clear();
+    _blockFile->decode(block, _block);
+    _blockIndex = block;
+    _ioCounters.addRead(_blockFile->getBlocks()[block].size);
+    return _block;
+}
+
+bool SpikeReportBinary::_mayContainFilteredGIDs(const size_t block)
+{
+    if (_idsSubset.empty())
+        return true;
+    if (!_filterHash)
+        _filterHash.reset(new SpikeBlockFile::GIDHash(_idsSubset));
+    return _blockFile->mayContain(block, *_filterHash);
+}
 }
 } // namespaces
@@ -20,9 +20,14 @@
 #ifndef BRION_PLUGIN_SPIKEREPORTBINARY_H
 #define BRION_PLUGIN_SPIKEREPORTBINARY_H
 
+#include "../detail/ioCounters.h"
+#include "spikeBlockFile.h"
+
 #include <brion/spikeReportPlugin.h>
 #include <brion/types.h>
 
+#include <limits>
+
 namespace brion
 {
 namespace plugin
@@ -32,30 +37,63 @@ class BinaryReportMap;
 /**
  * A Binary spike report reader.
  *
- * The format read by this plugin is:
+ * The version 1 format read by this plugin is:
  * - 4b integer: magic '0xf0a'
  * - 4b integer: version, currently '1'
  * - (4b float, 4b integer) pairs until end of file: spike time, neuron GID,
  *   sorted by time
+ *
+ * Version 2 stores compressed blocks of spikes with a block directory, see
+ * SpikeBlockFile. Both versions are read, version 2 is written if the URI has
+ * the query ?version=2, with blocks of 10 ms unless ?block_duration=ms is
+ * given.
+ *
+ * Seeks in version 1 reports use a sparse index with the time of every 512th
+ * spike, which is kept in memory and, for reports of 2^20 spikes or more,
+ * saved next to the report as report.spikes.idx. It is rebuilt when missing
+ * or older than the report, and is not saved if the directory is read-only.
  */
 class SpikeReportBinary : public SpikeReportPlugin
 {
 public:
     explicit SpikeReportBinary(const SpikeReportInitData& initData);
 
+    /** Create a read cursor sharing the memory map of another report. */
+    explicit SpikeReportBinary(const SpikeReportBinary& from);
+
     static bool handles(const SpikeReportInitData& initData);
     static std::string getDescription();
 
-    void close() final {}
+    void close() final;
     Spikes read(float min) final;
     Spikes readUntil(float max) final;
     void readSeek(float toTimeStamp) final;
     void writeSeek(float toTimeStamp) final;
     void write(const Spike* spikes, size_t size) final;
     bool supportsBackwardSeek() const final { return true; }
+    bool supportsViews() const final;
+    SpikesView getView(float start, float end) const final;
+    std::unique_ptr<SpikeReportPlugin> createCursor() const final;
+    IOStatistics getIOStatistics() const final { return _ioCounters.get(); }
+    void resetIOStatistics() final { _ioCounters.reset(); }
+
 private:
-    std::unique_ptr<BinaryReportMap> _memFile;
+    // Shared by the cursors created from a report open in read mode
+    std::shared_ptr<BinaryReportMap> _memFile;
+    std::shared_ptr<SpikeBlockFile> _blockFile;
     size_t _startIndex = 0;
+    detail::IOCounters _ioCounters;
+
+    // Last decoded block of a version 2 report
+    Spikes _block;
+    size_t _blockIndex = std::numeric_limits<size_t>::max();
+    std::unique_ptr<SpikeBlockFile::GIDHash> _filterHash;
+
+    void _accountRead(size_t first, const Spikes& spikes);
+    Spikes _readBlocks(float max);
+    void _seekBlocks(float toTimeStamp);
+    const Spikes& _decode(size_t block);
+    bool _mayContainFilteredGIDs(size_t block);
 };
 }
 }
@@ -20,14 +20,12 @@
 
 #include "spikeReportBluron.h"
 
-#include "../detail/skipWhiteSpace.h"
 #include "../pluginInitData.h"
 
 #include <boost/filesystem.hpp>
 
 #include <lunchbox/pluginRegisterer.h>
 
-#include <cstdio>
 #include <fstream>
 
 namespace brion
@@ -45,17 +43,18 @@ SpikeReportBluron::SpikeReportBluron(const SpikeReportInitData& initData)
 {
     if (initData.getAccessMode() == MODE_READ)
     {
-        _spikes =
-            parse(_uri.getPath(), [](const std::string& buffer, Spike& spike) {
-                return sscanf(buffer.data(), "%20f%20ud", &spike.first,
-                              &spike.second) == 2;
-            });
+        _spikes = std::make_shared<const Spikes>(
+            parse(_uri.getPath(),
+                  [](const char* begin, const char* end, Spike& spike) {
+                      return parseNumber(begin, end, spike.first) &&
+                             parseNumber(begin, end, spike.second);
+                  }));
     }
 
-    _lastReadPosition = _spikes.begin();
+    _lastReadPosition = _spikes->begin();
 
-    if (!_spikes.empty())
-        _endTime = _spikes.rbegin()->first;
+    if (!_spikes->empty())
+        _endTime = _spikes->rbegin()->first;
 }
 
 bool SpikeReportBluron::handles(const SpikeReportInitData& initData)
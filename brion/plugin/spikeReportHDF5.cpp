@@ -19,6 +19,10 @@
 
 #include "spikeReportHDF5.h"
 
+#include "../detail/hdf5Mutex.h"
+#include "../detail/trace.h"
+
+#include <lunchbox/debug.h>
 #include <lunchbox/memoryMap.h>
 #include <lunchbox/pluginRegisterer.h>
 
@@ -28,7 +32,13 @@
 #include <highfive/H5DataSet.hpp>
 #include <highfive/H5Utility.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <limits>
 #include <memory>
+#include <thread>
 
 namespace brion
 {
@@ -38,43 +48,433 @@ namespace
 {
 lunchbox::PluginRegisterer<SpikeReportHDF5> registerer;
 constexpr char HDF_REPORT_FILE_EXT[] = ".h5";
+
+// Spikes read per dataset access when streaming
+constexpr size_t _blockSize = 1 << 20;
+// Below this number of spikes, the binary search reads the remaining range
+constexpr size_t _searchWindow = 4096;
+// Chunk size of the datasets in write mode
+constexpr hsize_t _chunkSize = 1 << 16;
+// Default spike stride of the time index in write mode
+constexpr size_t _defaultIndexStride = 1 << 16;
+
+enum class Sorting : int
+{
+    none = 0,
+    by_gid = 1,
+    by_time = 2
+};
+
+// @return the value of the SONATA sorting attribute, "none" if not present
+std::string _getSorting(const HighFive::Group& group)
+{
+    std::string sorting = "none";
+    try
+    {
+        HighFive::SilenceHDF5 silence;
+        const auto attribute = group.getAttribute("sorting");
+        const hid_t type = H5Aget_type(attribute.getId());
+        if (H5Tget_class(type) == H5T_ENUM)
+        {
+            std::vector<char> value(H5Tget_size(type));
+            char name[32];
+            if (H5Aread(attribute.getId(), type, value.data()) >= 0 &&
+                H5Tenum_nameof(type, value.data(), name, sizeof(name)) >= 0)
+            {
+                sorting = name;
+            }
+        }
+        else if (H5Tget_class(type) == H5T_STRING)
+            attribute.read(sorting);
+        H5Tclose(type);
+    }
+    catch (const HighFive::Exception&)
+    {
+    }
+    return sorting;
 }
 
-SpikeReportHDF5::SpikeReportHDF5(const SpikeReportInitData& initData)
-    : SpikeReportPlugin(initData)
-    , _file([initData]() {
-        // For consistency with the other spike plugins, we convert
-        // Highfive exceptions into std::runtime_error
+void _writeSorting(const HighFive::Group& group, const Sorting sorting)
+{
+    const hid_t type = H5Tenum_create(H5T_NATIVE_INT);
+    const char* names[] = {"none", "by_gid", "by_time"};
+    for (int i = int(Sorting::none); i <= int(Sorting::by_time); ++i)
+        H5Tenum_insert(type, names[i], &i);
+    const hid_t space = H5Screate(H5S_SCALAR);
+    const hid_t attribute = H5Acreate2(group.getId(), "sorting", type, space,
+                                       H5P_DEFAULT, H5P_DEFAULT);
+    const int value = int(sorting);
+    const bool success =
+        attribute >= 0 && H5Awrite(attribute, type, &value) >= 0;
+    if (attribute >= 0)
+        H5Aclose(attribute);
+    H5Sclose(space);
+    H5Tclose(type);
+    if (!success)
+        LBTHROW(std::runtime_error("Cannot write spike report sorting"));
+}
+
+// @return a new chunked 1D dataset of unlimited size, initially empty
+HighFive::DataSet _createExtensible(HighFive::Group& group,
+                                    const std::string& name, const hid_t type)
+{
+    const hsize_t size = 0;
+    const hsize_t maxSize = H5S_UNLIMITED;
+    const hid_t space = H5Screate_simple(1, &size, &maxSize);
+    const hid_t properties = H5Pcreate(H5P_DATASET_CREATE);
+    H5Pset_chunk(properties, 1, &_chunkSize);
+    const hid_t dataset = H5Dcreate2(group.getId(), name.c_str(), type, space,
+                                     H5P_DEFAULT, properties, H5P_DEFAULT);
+    H5Pclose(properties);
+    H5Sclose(space);
+    if (dataset < 0)
+        LBTHROW(std::runtime_error("Cannot create dataset " + name));
+    H5Dclose(dataset);
+    return group.getDataSet(name);
+}
+
+size_t _getIndexStride(const URI& uri)
+{
+    const auto i = uri.findQuery("time_index");
+    if (i == uri.queryEnd())
+        return 0;
+    return i->second.empty() ? _defaultIndexStride : std::stoul(i->second);
+}
+
+HighFive::File _openFile(const SpikeReportInitData& initData)
+{
+    // For consistency with the other spike plugins, we convert
+    // Highfive exceptions into std::runtime_error
+    try
+    {
+        HighFive::SilenceHDF5 silence;
+        detail::HDF5Lock lock;
+        if (initData.getAccessMode() == MODE_WRITE)
+            return HighFive::File(initData.getURI().getPath(),
+                                  HighFive::File::ReadWrite |
+                                      HighFive::File::Create |
+                                      HighFive::File::Truncate);
+        return HighFive::File(initData.getURI().getPath());
+    }
+    catch (const HighFive::Exception& e)
+    {
+        throw std::runtime_error(e.what());
+    }
+}
+
+HighFive::File _copyFile(const HighFive::File& file)
+{
+    // Copying a HighFive object increments the reference count of its handle
+    detail::HDF5Lock lock;
+    return file;
+}
+}
+
+/**
+ * Appends spikes to the datasets of a new report. Spikes are collected in
+ * blocks which are written by a background thread while the next block is
+ * filled.
+ */
+class SpikeReportHDF5::Writer
+{
+public:
+    Writer(HighFive::File& file, const size_t indexStride)
+        : _indexStride(indexStride)
+    {
+        detail::HDF5Lock lock;
+        _group.reset(new HighFive::Group(file.createGroup("spikes")));
+
+        _gids.reset(new HighFive::DataSet(
+            _createExtensible(*_group, "gids", H5T_NATIVE_UINT32)));
+        _timestamps.reset(new HighFive::DataSet(
+            _createExtensible(*_group, "timestamps", H5T_NATIVE_FLOAT)));
+
+        _thread = std::thread([this] { _run(); });
+    }
+
+    ~Writer()
+    {
         try
         {
-            HighFive::SilenceHDF5 silence;
-            return HighFive::File(initData.getURI().getPath());
+            close();
+        }
+        catch (const std::exception& e)
+        {
+            LBERROR << "Error closing spike report: " << e.what()
+                    << std::endl;
+        }
+        _stop();
+    }
+
+    void write(const Spike* spikes, const size_t size)
+    {
+        _checkError();
+        for (size_t i = 0; i != size; ++i)
+        {
+            const Spike& spike = spikes[i];
+            if (spike.first < _lastTimestamp)
+                _sorted = false;
+            _lastTimestamp = spike.first;
+            if (_indexStride > 0 && _count % _indexStride == 0)
+                _timeIndex.push_back(spike.first);
+            ++_count;
+
+            _block.gids.push_back(spike.second);
+            _block.timestamps.push_back(spike.first);
+            if (_block.gids.size() == _blockSize)
+                _enqueue();
+        }
+    }
+
+    void close()
+    {
+        if (_closed)
+            return;
+        _closed = true;
+
+        // The thread must be joined before an error of a previous block
+        // leaves, or its destruction would terminate the process
+        try
+        {
+            _enqueue();
+        }
+        catch (...)
+        {
+            _stop();
+            throw;
+        }
+        _stop();
+        _checkError();
+
+        detail::HDF5Lock lock;
+        _writeSorting(*_group, _sorted ? Sorting::by_time : Sorting::none);
+        if (!_sorted || _timeIndex.empty())
+            return;
+
+        auto index = _group->createDataSet<float>(
+            "time_index",
+            HighFive::DataSpace(std::vector<size_t>{_timeIndex.size()}));
+        index.write(_timeIndex);
+        auto stride = index.createAttribute<uint64_t>(
+            "stride", HighFive::DataSpace(std::vector<size_t>{1}));
+        stride.write(uint64_t(_indexStride));
+    }
+
+private:
+    struct Block
+    {
+        uint32_ts gids;
+        floats timestamps;
+    };
+
+    // At most this many filled blocks wait for the background thread
+    static constexpr size_t _maxPending = 2;
+
+    std::unique_ptr<HighFive::Group> _group;
+    std::unique_ptr<HighFive::DataSet> _gids;
+    std::unique_ptr<HighFive::DataSet> _timestamps;
+    const size_t _indexStride;
+    floats _timeIndex;
+    size_t _count = 0;   // spikes given to write()
+    size_t _written = 0; // spikes written to the file
+    float _lastTimestamp = -std::numeric_limits<float>::max();
+    bool _sorted = true;
+    bool _closed = false;
+
+    Block _block;
+    std::deque<Block> _pending;
+    std::mutex _mutex;
+    std::condition_variable _blockAvailable;
+    std::condition_variable _spaceAvailable;
+    std::exception_ptr _error;
+    bool _stopping = false;
+    std::thread _thread;
+
+    void _enqueue()
+    {
+        if (_block.gids.empty())
+            return;
+        std::unique_lock<std::mutex> lock(_mutex);
+        _spaceAvailable.wait(lock, [&] {
+            return _pending.size() < _maxPending || _error;
+        });
+        if (_error)
+            std::rethrow_exception(_error);
+        _pending.push_back(std::move(_block));
+        _block = Block();
+        lock.unlock();
+        _blockAvailable.notify_one();
+    }
+
+    void _stop()
+    {
+        if (!_thread.joinable())
+            return;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stopping = true;
+        }
+        _blockAvailable.notify_all();
+        _thread.join();
+    }
+
+    void _checkError()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_error)
+            std::rethrow_exception(_error);
+    }
+
+    void _run()
+    {
+        for (;;)
+        {
+            Block block;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _blockAvailable.wait(lock, [&] {
+                    return !_pending.empty() || _stopping;
+                });
+                if (_pending.empty())
+                    return;
+                block = std::move(_pending.front());
+                _pending.pop_front();
+            }
+            _spaceAvailable.notify_one();
+
+            try
+            {
+                _append(block);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                if (!_error)
+                    _error = std::current_exception();
+            }
+        }
+    }
+
+    void _append(const Block& block)
+    {
+        BRION_TRACE("SpikeReportHDF5::append", "spikes");
+        detail::HDF5Lock lock;
+        const size_t count = block.gids.size();
+        const hsize_t size = _written + count;
+        if (H5Dset_extent(_gids->getId(), &size) < 0 ||
+            H5Dset_extent(_timestamps->getId(), &size) < 0)
+        {
+            LBTHROW(std::runtime_error("Cannot extend spike report"));
+        }
+        try
+        {
+            _gids->select({_written}, {count}).write(block.gids);
+            _timestamps->select({_written}, {count}).write(block.timestamps);
         }
         catch (const HighFive::Exception& e)
         {
-            throw std::runtime_error(e.what());
+            LBTHROW(std::runtime_error(
+                std::string("Cannot write spike report: ") + e.what()));
         }
-    }())
+        _written = size;
+    }
+};
+
+SpikeReportHDF5::SpikeReportHDF5(const SpikeReportInitData& initData)
+    : SpikeReportPlugin(initData)
+    , _file(_openFile(initData))
 {
-    const auto group = _file.getGroup("/spikes");
-    const auto setGids = group.getDataSet("gids");
-    const auto setTimestamps = group.getDataSet("timestamps");
+    if (initData.getAccessMode() == MODE_WRITE)
+    {
+        _writer.reset(new Writer(_file, _getIndexStride(initData.getURI())));
+        return;
+    }
 
     uint32_ts gids;
     floats timestamps;
-    setGids.read(gids);
-    setTimestamps.read(timestamps);
+    {
+        detail::CountedLock lock(detail::hdf5Mutex(), _ioCounters);
+        const auto group = _file.getGroup("/spikes");
+        _gids.reset(new HighFive::DataSet(group.getDataSet("gids")));
+        _timestamps.reset(
+            new HighFive::DataSet(group.getDataSet("timestamps")));
+
+        _numSpikes = _timestamps->getSpace().getDimensions()[0];
+        if (_gids->getSpace().getDimensions()[0] != _numSpikes)
+            LBTHROW(std::runtime_error("Inconsistent spike report " +
+                                       initData.getURI().getPath()));
+        _sortedByTime = _getSorting(group) == "by_time";
+
+        if (_sortedByTime &&
+            H5Lexists(group.getId(), "time_index", H5P_DEFAULT) > 0)
+        {
+            const auto index = group.getDataSet("time_index");
+            if (H5Aexists(index.getId(), "stride") <= 0)
+                LBTHROW(std::runtime_error("Spike time index without stride "
+                                           "in " +
+                                           initData.getURI().getPath()));
+            uint64_t stride = 0;
+            index.getAttribute("stride").read(stride);
+            index.read(_timeIndex);
+            _ioCounters.addRead(_timeIndex.size() * sizeof(float));
+            _indexStride = stride;
+            if (_indexStride == 0)
+                _timeIndex.clear();
+        }
+        else if (!_sortedByTime)
+        {
+            _gids->read(gids);
+            _ioCounters.addRead(gids.size() * sizeof(uint32_t));
+            _timestamps->read(timestamps);
+            _ioCounters.addRead(timestamps.size() * sizeof(float));
+        }
+    }
 
-    const size_t numElements = gids.size();
+    if (!_sortedByTime)
+    {
+        detail::ScopedTimer timer(_ioCounters.decodeTime);
+        Spikes spikes;
+        spikes.reserve(_numSpikes);
+        for (size_t i = 0; i < _numSpikes; i++)
+            spikes.push_back(std::make_pair<>(timestamps[i], gids[i]));
 
-    for (size_t i = 0; i < numElements; i++)
-        _spikes.push_back(std::make_pair<>(timestamps[i], gids[i]));
+        std::sort(spikes.begin(), spikes.end());
+        _spikes = std::make_shared<const Spikes>(std::move(spikes));
+    }
 
-    std::sort(_spikes.begin(), _spikes.end());
-    _lastReadPosition = _spikes.begin();
+    if (_numSpikes > 0)
+    {
+        _startTime = _getTimestamp(0);
+        _endTime = _getTimestamp(_numSpikes - 1);
+    }
+}
 
-    if (!_spikes.empty())
-        _endTime = _spikes.rbegin()->first;
+SpikeReportHDF5::SpikeReportHDF5(const SpikeReportHDF5& from)
+    : SpikeReportPlugin(SpikeReportInitData(from.getURI(), MODE_READ))
+    , _file(_copyFile(from._file))
+    , _gids(from._gids)
+    , _timestamps(from._timestamps)
+    , _numSpikes(from._numSpikes)
+    , _sortedByTime(from._sortedByTime)
+    , _startTime(from._startTime)
+    , _spikes(from._spikes)
+    , _timeIndex(from._timeIndex)
+    , _indexStride(from._indexStride)
+{
+    initCursor(from);
+}
+
+SpikeReportHDF5::~SpikeReportHDF5()
+{
+    // Releasing the last reference to the datasets closes their handles
+    detail::HDF5Lock lock;
+    _gids.reset();
+    _timestamps.reset();
+}
+
+std::unique_ptr<SpikeReportPlugin> SpikeReportHDF5::createCursor() const
+{
+    return std::unique_ptr<SpikeReportPlugin>(new SpikeReportHDF5(*this));
 }
 
 bool SpikeReportHDF5::handles(const SpikeReportInitData& initData)
@@ -98,75 +498,177 @@ Spikes SpikeReportHDF5::read(const float)
 {
     // In file based reports, this function reads all remaining data.
     Spikes spikes;
-    auto start = _lastReadPosition;
-    _lastReadPosition = _spikes.end();
+    _readRange(_position, _numSpikes, spikes);
+    _position = _numSpikes;
     _currentTime = UNDEFINED_TIMESTAMP;
     _state = State::ended;
 
-    for (; start != _spikes.end(); ++start)
-        pushBack(*start, spikes);
-
+    _ioCounters.bytesRequested += spikes.size() * sizeof(Spike);
     return spikes;
 }
 
 Spikes SpikeReportHDF5::readUntil(const float toTimeStamp)
 {
     Spikes spikes;
+    const size_t end = _lowerBound(toTimeStamp, _position);
+    _readRange(_position, end, spikes);
+    _position = end;
 
-    const auto end = _spikes.end();
-
-    for (; _lastReadPosition != end; ++_lastReadPosition)
-    {
-        if (_lastReadPosition->first >= toTimeStamp)
-        {
-            _currentTime = _lastReadPosition->first;
-            break;
-        }
-        pushBack(*_lastReadPosition, spikes);
-    }
-
-    if (_lastReadPosition != _spikes.end())
-        _currentTime = _lastReadPosition->first;
+    if (_position < _numSpikes)
+        _currentTime = _getTimestamp(_position);
     else
     {
         _currentTime = UNDEFINED_TIMESTAMP;
         _state = State::ended;
     }
 
+    _ioCounters.bytesRequested += spikes.size() * sizeof(Spike);
     return spikes;
 }
 
+void SpikeReportHDF5::close()
+{
+    if (_writer)
+        _writer->close();
+}
+
+void SpikeReportHDF5::write(const Spike* spikes, const size_t size)
+{
+    if (size == 0)
+        return;
+
+    _writer->write(spikes, size);
+    const float lastTimestamp = spikes[size - 1].first;
+    _currentTime =
+        std::nextafter(lastTimestamp, std::numeric_limits<float>::max());
+    _endTime = std::max(_endTime, lastTimestamp);
+}
+
+void SpikeReportHDF5::writeSeek(const float toTimeStamp)
+{
+    if (toTimeStamp < _currentTime)
+        LBTHROW(std::runtime_error(
+            "Backward seek not supported when writing SONATA spike reports"));
+    _currentTime = toTimeStamp;
+}
+
 void SpikeReportHDF5::readSeek(const float toTimeStamp)
 {
-    if (_spikes.empty())
+    if (_numSpikes == 0)
     {
         _currentTime = UNDEFINED_TIMESTAMP;
         _state = State::ended;
         return;
     }
 
-    if (toTimeStamp < _spikes.begin()->first)
+    if (toTimeStamp < _startTime)
     {
-        _lastReadPosition = _spikes.begin();
+        _position = 0;
         _state = State::ok;
         _currentTime = toTimeStamp;
     }
-    else if (toTimeStamp > _spikes.rbegin()->first)
+    else if (toTimeStamp > _endTime)
     {
-        _lastReadPosition = _spikes.end();
+        _position = _numSpikes;
         _state = State::ended;
         _currentTime = brion::UNDEFINED_TIMESTAMP;
     }
     else
     {
-        _lastReadPosition =
-            std::lower_bound(_spikes.begin(), _spikes.end(), toTimeStamp,
-                             [](const Spike& spike, float val) {
-                                 return spike.first < val;
-                             });
+        _position = _lowerBound(toTimeStamp, 0);
         _state = State::ok;
         _currentTime = toTimeStamp;
     }
 }
+
+float SpikeReportHDF5::_getTimestamp(const size_t index)
+{
+    if (!_sortedByTime)
+        return (*_spikes)[index].first;
+
+    floats timestamp;
+    detail::CountedLock lock(detail::hdf5Mutex(), _ioCounters);
+    _timestamps->select({index}, {1}).read(timestamp);
+    _ioCounters.addRead(sizeof(float));
+    return timestamp[0];
+}
+
+size_t SpikeReportHDF5::_lowerBound(const float timestamp, const size_t begin)
+{
+    if (!_sortedByTime)
+    {
+        return std::lower_bound(_spikes->begin() + begin, _spikes->end(),
+                                timestamp,
+                                [](const Spike& spike, float val) {
+                                    return spike.first < val;
+                                }) -
+               _spikes->begin();
+    }
+
+    // Narrow down the range with the time index if available, then with
+    // single reads, and search the remaining window in memory.
+    size_t first = begin;
+    size_t last = _numSpikes;
+    if (!_timeIndex.empty())
+    {
+        // _timeIndex[i] is the timestamp of spike i * _indexStride
+        const size_t i =
+            std::lower_bound(_timeIndex.begin(), _timeIndex.end(), timestamp) -
+            _timeIndex.begin();
+        if (i > 0)
+            first = std::max(first, (i - 1) * _indexStride + 1);
+        if (i < _timeIndex.size())
+            last = std::max(first, std::min(last, i * _indexStride));
+    }
+    while (last - first > _searchWindow)
+    {
+        const size_t middle = first + (last - first) / 2;
+        if (_getTimestamp(middle) < timestamp)
+            first = middle + 1;
+        else
+            last = middle;
+    }
+    if (first == last)
+        return first;
+
+    floats window;
+    {
+        detail::CountedLock lock(detail::hdf5Mutex(), _ioCounters);
+        _timestamps->select({first}, {last - first}).read(window);
+        _ioCounters.addRead(window.size() * sizeof(float));
+    }
+    return first + (std::lower_bound(window.begin(), window.end(), timestamp) -
+                    window.begin());
+}
+
+void SpikeReportHDF5::_readRange(const size_t begin, const size_t end,
+                                 Spikes& spikes)
+{
+    if (begin >= end)
+        return;
+
+    if (!_sortedByTime)
+    {
+        pushBack(_spikes->data() + begin, _spikes->data() + end, spikes);
+        return;
+    }
+
+    spikes.reserve(spikes.size() + (_filter.empty() ? end - begin : 0));
+    uint32_ts gids;
+    floats timestamps;
+    for (size_t offset = begin; offset < end; offset += _blockSize)
+    {
+        const size_t count = std::min(_blockSize, end - offset);
+        {
+            detail::CountedLock lock(detail::hdf5Mutex(), _ioCounters);
+            _gids->select({offset}, {count}).read(gids);
+            _timestamps->select({offset}, {count}).read(timestamps);
+            _ioCounters.addRead(count * (sizeof(uint32_t) + sizeof(float)));
+        }
+
+        detail::ScopedTimer timer(_ioCounters.decodeTime);
+        pushBack(timestamps.data(), gids.data(), count, spikes);
+    }
+}
 }
 } // namespaces
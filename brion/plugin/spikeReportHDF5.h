@@ -19,37 +19,87 @@
 
 #pragma once
 
+#include "../detail/ioCounters.h"
+
 #include <brion/spikeReportPlugin.h>
 #include <brion/types.h>
 
 #include <highfive/H5File.hpp>
 
+#include <memory>
+
 namespace brion
 {
 namespace plugin
 {
 class BinaryReportMap;
 /**
- * A HDF spike report reader.
+ * A SONATA HDF5 spike report reader.
+ *
+ * Reports with the "by_time" sorting attribute are streamed from the file:
+ * only the spikes requested by read() and readUntil() are loaded, and seeking
+ * uses a binary search over the timestamps dataset, narrowed down by the
+ * optional /spikes/time_index dataset. Other reports are loaded and sorted in
+ * memory when opened.
  *
+ * In write mode, spikes are appended to chunked, extendible datasets by a
+ * background thread. The sorting attribute is written when the report is
+ * closed, together with a time index of every Nth spike timestamp if the URI
+ * has the query ?time_index[=N].
  */
 class SpikeReportHDF5 : public SpikeReportPlugin
 {
 public:
     explicit SpikeReportHDF5(const SpikeReportInitData& initData);
 
+    /** Create a read cursor sharing the datasets of another report. */
+    explicit SpikeReportHDF5(const SpikeReportHDF5& from);
+    ~SpikeReportHDF5();
+
     static bool handles(const SpikeReportInitData& initData);
     static std::string getDescription();
 
-    void close() final {}
+    void close() final;
     Spikes read(float min) final;
     Spikes readUntil(float toTimeStamp) final;
     void readSeek(float toTimeStamp) final;
-    bool supportsBackwardSeek() const final { return true; }
+    void writeSeek(float toTimeStamp) final;
+    void write(const Spike* spikes, size_t size) final;
+    bool supportsBackwardSeek() const final
+    {
+        return getAccessMode() == MODE_READ;
+    }
+    std::unique_ptr<SpikeReportPlugin> createCursor() const final;
+    IOStatistics getIOStatistics() const final { return _ioCounters.get(); }
+    void resetIOStatistics() final { _ioCounters.reset(); }
+
 private:
     HighFive::File _file;
-    Spikes _spikes;
-    Spikes::iterator _lastReadPosition;
+    // The datasets and the spikes read in memory are shared by the cursors
+    std::shared_ptr<HighFive::DataSet> _gids;
+    std::shared_ptr<HighFive::DataSet> _timestamps;
+    size_t _numSpikes = 0;
+    bool _sortedByTime = false;
+    float _startTime = 0;
+
+    // Spikes of reports not sorted by time, null otherwise
+    std::shared_ptr<const Spikes> _spikes;
+
+    // Index of the next spike to read
+    size_t _position = 0;
+
+    // Timestamps of every _indexStride-th spike, if present in the file
+    floats _timeIndex;
+    size_t _indexStride = 0;
+
+    class Writer;
+    std::unique_ptr<Writer> _writer;
+
+    detail::IOCounters _ioCounters;
+
+    float _getTimestamp(size_t index);
+    size_t _lowerBound(float timestamp, size_t begin);
+    void _readRange(size_t begin, size_t end, Spikes& spikes);
 };
 }
 }
@@ -91,15 +91,16 @@ SpikeReportNEST::SpikeReportNEST(const SpikeReportInitData& initData)
             LBTHROW(std::runtime_error("No files to read found in " +
                                        _uri.getPath()));
 
-        _spikes = parse(files, [](const std::string& buffer, Spike& spike) {
-            return sscanf(buffer.data(), "%20d%20f", &spike.second,
-                          &spike.first) == 2;
-        });
+        _spikes = std::make_shared<const Spikes>(
+            parse(files, [](const char* begin, const char* end, Spike& spike) {
+                return parseNumber(begin, end, spike.second) &&
+                       parseNumber(begin, end, spike.first);
+            }));
     }
 
-    _lastReadPosition = _spikes.begin();
-    if (!_spikes.empty())
-        _endTime = _spikes.rbegin()->first;
+    _lastReadPosition = _spikes->begin();
+    if (!_spikes->empty())
+        _endTime = _spikes->rbegin()->first;
 }
 
 bool SpikeReportNEST::handles(const SpikeReportInitData& initData)
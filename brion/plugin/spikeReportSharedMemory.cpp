@@ -0,0 +1,361 @@
+/* Copyright (c) 2018, EPFL/Blue Brain Project
+ *
+ * This file is part of Brion <https://github.com/BlueBrain/Brion>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "spikeReportSharedMemory.h"
+
+#include <lunchbox/log.h>
+#include <lunchbox/pluginRegisterer.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace brion
+{
+namespace plugin
+{
+namespace
+{
+lunchbox::PluginRegisterer<SpikeReportSharedMemory> registerer;
+
+constexpr uint32_t _magic = 0x5b1e;
+constexpr uint32_t _version = 1;
+constexpr uint64_t _defaultCapacity = 1 << 20;
+// Time between two checks for new spikes while waiting for the writer
+constexpr std::chrono::milliseconds _pollInterval(1);
+
+static_assert(ATOMIC_INT_LOCK_FREE == 2 && ATOMIC_LLONG_LOCK_FREE == 2,
+              "Shared memory spike streams need lock-free atomics");
+
+std::string _getName(const URI& uri)
+{
+    // shm://name has the name as host, shm:///name as path
+    std::string name = uri.getHost() + uri.getPath();
+    name.erase(0, name.find_first_not_of('/'));
+    if (name.empty() || name.find('/') != std::string::npos)
+        LBTHROW(std::runtime_error("Invalid shared memory spike stream " +
+                                   std::to_string(uri)));
+    return "/" + name;
+}
+
+uint64_t _getCapacity(const URI& uri)
+{
+    const auto i = uri.findQuery("capacity");
+    if (i == uri.queryEnd())
+        return _defaultCapacity;
+    const uint64_t capacity = std::stoull(i->second);
+    if (capacity == 0)
+        LBTHROW(std::runtime_error("Invalid spike stream capacity " +
+                                   i->second));
+    return capacity;
+}
+
+bool _byTime(const Spike& spike, const float time)
+{
+    return spike.first < time;
+}
+}
+
+/**
+ * The header of the shared memory object, followed by the ring of spikes.
+ *
+ * The writer reserves the slots of the spikes it writes before copying them,
+ * and commits them after. Readers copy the committed spikes, then check that
+ * none of their slots has been reserved again meanwhile.
+ */
+struct SpikeReportSharedMemory::Ring
+{
+    std::atomic<uint32_t> magic;
+    uint32_t version;
+    uint64_t capacity; // in spikes
+    // Number of spikes being written or written since the stream started
+    std::atomic<uint64_t> reserved;
+    // Number of spikes written since the stream started
+    std::atomic<uint64_t> committed;
+    // Bits of the current time of the writer
+    std::atomic<uint32_t> time;
+    std::atomic<uint32_t> ended;
+
+    float getTime() const
+    {
+        const uint32_t bits = time.load(std::memory_order_acquire);
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    void setTime(const float value)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        time.store(bits, std::memory_order_release);
+    }
+};
+
+SpikeReportSharedMemory::SpikeReportSharedMemory(
+    const SpikeReportInitData& initData)
+    : SpikeReportPlugin(initData)
+    , _name(_getName(initData.getURI()))
+{
+    const bool write = _accessMode == MODE_WRITE;
+    uint64_t capacity = 0;
+    int fd = -1;
+    if (write)
+    {
+        capacity = _getCapacity(_uri);
+        _size = sizeof(Ring) + capacity * sizeof(Spike);
+        // Replace the object left by a writer which was not closed
+        ::shm_unlink(_name.c_str());
+        fd = ::shm_open(_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+        if (fd >= 0 && ::ftruncate(fd, _size) != 0)
+        {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+    else
+    {
+        fd = ::shm_open(_name.c_str(), O_RDONLY, 0);
+        struct stat status;
+        if (fd >= 0 && ::fstat(fd, &status) == 0)
+            _size = status.st_size;
+    }
+    if (fd < 0)
+        LBTHROW(std::runtime_error("Cannot open spike stream " + _name +
+                                   ": " + std::strerror(errno)));
+
+    void* address = MAP_FAILED;
+    if (_size >= sizeof(Ring))
+        address = ::mmap(nullptr, _size,
+                         write ? PROT_READ | PROT_WRITE : PROT_READ,
+                         MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (address == MAP_FAILED)
+        LBTHROW(std::runtime_error("Cannot map spike stream " + _name));
+    _ring = static_cast<Ring*>(address);
+
+    if (write)
+    {
+        _ring->version = _version;
+        _ring->capacity = capacity;
+        _ring->reserved.store(0, std::memory_order_relaxed);
+        _ring->committed.store(0, std::memory_order_relaxed);
+        _ring->setTime(0);
+        _ring->ended.store(0, std::memory_order_relaxed);
+        _ring->magic.store(_magic, std::memory_order_release);
+        return;
+    }
+
+    if (_ring->magic.load(std::memory_order_acquire) != _magic ||
+        _ring->version != _version ||
+        _size != sizeof(Ring) + _ring->capacity * sizeof(Spike))
+    {
+        _unmap();
+        LBTHROW(std::runtime_error("Invalid spike stream " + _name));
+    }
+    // Start with the oldest spike which has not been overwritten
+    const uint64_t reserved = _ring->reserved.load(std::memory_order_acquire);
+    if (reserved > _ring->capacity)
+        _position = reserved - _ring->capacity;
+}
+
+SpikeReportSharedMemory::~SpikeReportSharedMemory()
+{
+    close();
+}
+
+bool SpikeReportSharedMemory::handles(const SpikeReportInitData& initData)
+{
+    return initData.getURI().getScheme() == "shm";
+}
+
+std::string SpikeReportSharedMemory::getDescription()
+{
+    return "Shared memory spike streams: shm://name[?capacity=spikes]";
+}
+
+void SpikeReportSharedMemory::close()
+{
+    if (_ring && _accessMode == MODE_WRITE)
+    {
+        _ring->ended.store(1, std::memory_order_release);
+        ::shm_unlink(_name.c_str());
+    }
+    _unmap();
+}
+
+Spikes SpikeReportSharedMemory::read(const float min)
+{
+    const float time =
+        min == UNDEFINED_TIMESTAMP ? _ring->getTime() : _wait(min, false);
+    Spikes spikes;
+    _consume(time, &spikes);
+    if (_state == State::ok)
+        _currentTime = std::max(_currentTime, time);
+    return spikes;
+}
+
+Spikes SpikeReportSharedMemory::readUntil(const float max)
+{
+    const float time = _wait(max, true);
+    Spikes spikes;
+    _consume(std::min(time, max), &spikes);
+    if (_state == State::ok)
+        _currentTime = std::min(time, max);
+    return spikes;
+}
+
+void SpikeReportSharedMemory::readSeek(const float toTimeStamp)
+{
+    if (toTimeStamp < _currentTime)
+        LBTHROW(std::runtime_error(
+            "Backward seek not supported in spike streams"));
+
+    const float time = _wait(toTimeStamp, true);
+    _consume(std::min(time, toTimeStamp), nullptr);
+    if (_state == State::ok)
+        _currentTime = toTimeStamp;
+}
+
+void SpikeReportSharedMemory::writeSeek(const float toTimeStamp)
+{
+    if (toTimeStamp < _currentTime)
+        LBTHROW(std::runtime_error(
+            "Backward seek not supported when writing spike streams"));
+    _currentTime = toTimeStamp;
+    _ring->setTime(_currentTime);
+}
+
+void SpikeReportSharedMemory::write(const Spike* spikes, const size_t size)
+{
+    if (size == 0)
+        return;
+
+    const uint64_t capacity = _ring->capacity;
+    Spike* ring = _getSpikes();
+    uint64_t position = _ring->committed.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < size;)
+    {
+        const size_t slot = position % capacity;
+        const size_t count = std::min(size - i, size_t(capacity - slot));
+        _ring->reserved.store(position + count, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::copy(spikes + i, spikes + i + count, ring + slot);
+        position += count;
+        i += count;
+        _ring->committed.store(position, std::memory_order_release);
+    }
+
+    const float lastTimestamp = spikes[size - 1].first;
+    _currentTime =
+        std::nextafter(lastTimestamp, std::numeric_limits<float>::max());
+    _endTime = std::max(_endTime, lastTimestamp);
+    _ring->setTime(_currentTime);
+}
+
+Spike* SpikeReportSharedMemory::_getSpikes() const
+{
+    return reinterpret_cast<Spike*>(_ring + 1);
+}
+
+void SpikeReportSharedMemory::_unmap()
+{
+    if (!_ring)
+        return;
+    ::munmap(_ring, _size);
+    _ring = nullptr;
+}
+
+float SpikeReportSharedMemory::_wait(const float time, const bool inclusive)
+{
+    for (;;)
+    {
+        const bool ended = _ring->ended.load(std::memory_order_acquire);
+        const float current = _ring->getTime();
+        if (ended || current > time || (inclusive && current == time))
+            return current;
+        checkNotInterrupted();
+        std::this_thread::sleep_for(_pollInterval);
+    }
+}
+
+void SpikeReportSharedMemory::_consume(const float limit, Spikes* spikes)
+{
+    // The end flag is read first, so that all the spikes are committed if set
+    const bool ended = _ring->ended.load(std::memory_order_acquire);
+    const uint64_t committed =
+        _ring->committed.load(std::memory_order_acquire);
+    const uint64_t capacity = _ring->capacity;
+
+    // Copy the new spikes before the limit, then check that the writer did
+    // not reuse their slots meanwhile. The spikes after the limit are read
+    // again by the next operation.
+    bool overrun = committed - _position > capacity;
+    const Spike* ring = _getSpikes();
+    const size_t numSpikes = spikes ? spikes->size() : 0;
+    uint64_t position = _position;
+    float lastTime = _endTime;
+    if (!overrun && committed > _position)
+        lastTime = ring[(committed - 1) % capacity].first;
+    while (!overrun && position < committed)
+    {
+        const size_t slot = position % capacity;
+        const Spike* first = ring + slot;
+        const Spike* last = first + std::min(committed - position,
+                                             uint64_t(capacity - slot));
+        const Spike* end = std::lower_bound(first, last, limit, _byTime);
+        if (spikes)
+            pushBack(first, end, *spikes);
+        position += end - first;
+        if (end != last)
+            break;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const uint64_t reserved = _ring->reserved.load(std::memory_order_relaxed);
+    if (overrun || reserved - _position > capacity)
+    {
+        _state = State::failed;
+        LBTHROW(std::runtime_error("Spike stream " + _name +
+                                   " overwritten before being read"));
+    }
+
+    _ioCounters.addRead((position - _position) * sizeof(Spike));
+    if (spikes)
+        _ioCounters.bytesRequested +=
+            (spikes->size() - numSpikes) * sizeof(Spike);
+    _endTime = std::max(_endTime, lastTime);
+    _position = position;
+
+    if (ended && _position == committed)
+    {
+        _currentTime = UNDEFINED_TIMESTAMP;
+        _state = State::ended;
+    }
+}
+}
+}
@@ -0,0 +1,82 @@
+/* Copyright (c) 2018, EPFL/Blue Brain Project
+ *
+ * This file is part of Brion <https://github.com/BlueBrain/Brion>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef BRION_PLUGIN_SPIKEREPORTSHAREDMEMORY_H
+#define BRION_PLUGIN_SPIKEREPORTSHAREDMEMORY_H
+
+#include "../detail/ioCounters.h"
+
+#include <brion/spikeReportPlugin.h>
+#include <brion/types.h>
+
+namespace brion
+{
+namespace plugin
+{
+/**
+ * A spike stream in POSIX shared memory, for readers on the same node as the
+ * simulation: shm://name[?capacity=spikes]
+ *
+ * The writer creates the shared memory object, which holds a ring buffer of
+ * the last 'capacity' spikes (2^20 by default), and removes it when closed.
+ * Any number of readers may open the stream while the writer is running. The
+ * writer never waits for the readers: a reader which falls behind by more
+ * than the capacity of the ring fails with std::runtime_error. Readers start
+ * with the oldest spike in the ring and wait for the writer in read() and
+ * readUntil() until the time requested is reached or the writer is closed.
+ */
+class SpikeReportSharedMemory : public SpikeReportPlugin
+{
+public:
+    explicit SpikeReportSharedMemory(const SpikeReportInitData& initData);
+    ~SpikeReportSharedMemory();
+
+    static bool handles(const SpikeReportInitData& initData);
+    static std::string getDescription();
+
+    void close() final;
+    Spikes read(float min) final;
+    Spikes readUntil(float max) final;
+    void readSeek(float toTimeStamp) final;
+    void writeSeek(float toTimeStamp) final;
+    void write(const Spike* spikes, size_t size) final;
+    bool supportsBackwardSeek() const final { return false; }
+    IOStatistics getIOStatistics() const final { return _ioCounters.get(); }
+    void resetIOStatistics() final { _ioCounters.reset(); }
+
+private:
+    struct Ring;
+
+    std::string _name;
+    Ring* _ring = nullptr;
+    size_t _size = 0; // of the mapping in bytes
+
+    // Index of the next spike to read from the ring
+    uint64_t _position = 0;
+
+    detail::IOCounters _ioCounters;
+
+    Spike* _getSpikes() const;
+    void _unmap();
+    float _wait(float time, bool inclusive);
+    void _consume(float limit, Spikes* spikes);
+};
+}
+}
+
+#endif
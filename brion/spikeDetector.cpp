@@ -0,0 +1,298 @@
+/* Copyright (c) 2018, EPFL/Blue Brain Project
+ *
+ * This file is part of Brion <https://github.com/BlueBrain/Brion>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "spikeDetector.h"
+#include "compartmentReport.h"
+#include "executor.h"
+#include "spikeReport.h"
+
+#include "detail/frameWindow.h"
+
+#include <lunchbox/log.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace brion
+{
+namespace
+{
+// Values below which the detection is not split in more tasks
+constexpr size_t _minValuesPerTask = 1 << 12;
+
+// Flags the values crossing the threshold upwards between two frames. The
+// loop has no branches so that the compiler vectorizes it.
+void _flagCrossings(const float* previous, const float* current,
+                    const size_t size, const float threshold, uint8_t* flags)
+{
+    for (size_t i = 0; i < size; ++i)
+        flags[i] = uint8_t(previous[i] < threshold) &
+                   uint8_t(current[i] >= threshold);
+}
+
+// Calls func with the index of each flag set, skipping 8 flags at once since
+// crossings are rare
+template <typename F>
+void _forEachFlag(const uint8_t* flags, const size_t size, const F& func)
+{
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+    {
+        uint64_t word;
+        std::memcpy(&word, flags + i, sizeof(word));
+        if (word == 0)
+            continue;
+        for (size_t j = i; j < i + sizeof(uint64_t); ++j)
+            if (flags[j])
+                func(j);
+    }
+    for (; i < size; ++i)
+        if (flags[i])
+            func(i);
+}
+}
+
+namespace detail
+{
+class SpikeDetector
+{
+public:
+    SpikeDetector(const brion::CompartmentReport& report_,
+                  const float threshold_,
+                  const brion::SpikeDetector::Mode mode,
+                  const size_t maxValuesPerWindow_)
+        : report(report_)
+        , threshold(threshold_)
+        , somas(mode == brion::SpikeDetector::Mode::somas)
+        , maxValuesPerWindow(maxValuesPerWindow_)
+    {
+        if (!somas)
+            return;
+
+        const auto& offsets = report.getOffsets();
+        const auto& counts = report.getCompartmentCounts();
+        for (const uint32_t gid : report.getGIDs())
+        {
+            const size_t index = report.getIndex(gid);
+            if (counts[index].empty() || counts[index][0] == 0)
+                continue;
+            gids.push_back(gid);
+            somaOffsets.push_back(offsets[index][0]);
+        }
+    }
+
+    // Calls emit with the spikes of each window of frames in [start, end)
+    template <typename F>
+    void detect(const double start, const double end, const F& emit)
+    {
+        if (end <= start)
+            LBTHROW(std::logic_error(
+                "Start time should be strictly inferior to end time"));
+
+        const double startTime = report.getStartTime();
+        const double timestep = report.getTimestep();
+        const int64_t frameCount = report.getFrameCount();
+        const auto toFrame = [&](const double time) {
+            const int64_t frame =
+                std::ceil(snapFrames((time - startTime) / timestep));
+            return std::min(std::max(frame, int64_t(0)), frameCount);
+        };
+        const int64_t first = toFrame(start);
+        const int64_t last = toFrame(end);
+        if (first >= last)
+            return;
+
+        // Consecutive windows share one frame, the previous frame of the
+        // first frame tested in a window
+        const size_t frameSize = report.getFrameSize();
+        const int64_t windowSize =
+            getWindowSize(frameSize, 2, maxValuesPerWindow);
+        const auto load = [&](const int64_t begin) {
+            return loadFrameWindow(
+                [&](const double start_, const double end_) {
+                    return report.loadFrames(start_, end_);
+                },
+                startTime, timestep, begin,
+                std::min(begin + windowSize, last));
+        };
+
+        int64_t begin = std::max(first - 1, int64_t(0));
+        std::future<Frames> next = load(begin);
+        for (;;)
+        {
+            const Frames frames = next.get();
+            const int64_t windowEnd = std::min(begin + windowSize, last);
+            const size_t numFrames = windowEnd - begin;
+            checkFrameWindow(frames, numFrames, frameSize,
+                             startTime + begin * timestep);
+            if (windowEnd < last)
+                next = load(windowEnd - 1);
+
+            emit(_detect(frames, numFrames, frameSize));
+            if (windowEnd == last)
+                break;
+            begin = windowEnd - 1;
+        }
+    }
+
+    const brion::CompartmentReport& report;
+    const float threshold;
+    const bool somas;
+    const size_t maxValuesPerWindow;
+    uint32_ts gids;
+    uint64_ts somaOffsets;
+
+private:
+    struct Range
+    {
+        size_t begin;
+        size_t end;
+        Spikes spikes;
+        size_ts counts; // of spikes per frame
+    };
+
+    // @return the spikes of the frames after the first one of the window
+    Spikes _detect(const Frames& frames, const size_t numFrames,
+                   const size_t frameSize)
+    {
+        const size_t numValues = somas ? gids.size() : frameSize;
+        auto executor = brion::Executor::getDefault();
+        const size_t numRanges =
+            std::max(size_t(1), std::min(executor->getSize(),
+                                         numValues / _minValuesPerTask));
+        std::vector<Range> ranges(numRanges);
+        std::vector<std::future<void>> tasks;
+        for (size_t i = 0; i < numRanges; ++i)
+        {
+            Range& range = ranges[i];
+            range.begin = numValues * i / numRanges;
+            range.end = numValues * (i + 1) / numRanges;
+            tasks.push_back(executor->post(
+                [&] { _detect(frames, numFrames, frameSize, range); },
+                brion::Executor::Priority::bulk));
+        }
+        // The tasks refer to this stack frame, wait for all of them before
+        // rethrowing the first exception
+        for (auto& task : tasks)
+            task.wait();
+        for (auto& task : tasks)
+            task.get();
+
+        // Interleave the spikes of the ranges frame by frame, ranges are
+        // sorted by identifier
+        Spikes spikes;
+        std::vector<size_t> positions(numRanges, 0);
+        for (size_t frame = 0; frame + 1 < numFrames; ++frame)
+        {
+            for (size_t i = 0; i < numRanges; ++i)
+            {
+                const auto first = ranges[i].spikes.begin() + positions[i];
+                const size_t count = ranges[i].counts[frame];
+                spikes.insert(spikes.end(), first, first + count);
+                positions[i] += count;
+            }
+        }
+        return spikes;
+    }
+
+    void _detect(const Frames& frames, const size_t numFrames,
+                 const size_t frameSize, Range& range) const
+    {
+        const size_t size = range.end - range.begin;
+        const float* data = frames.data->data();
+        std::vector<uint8_t> flags(size);
+        floats previous, current;
+        const auto gather = [&](const size_t frame, floats& values) {
+            values.resize(size);
+            const float* frameData = data + frame * frameSize;
+            for (size_t i = 0; i < size; ++i)
+                values[i] = frameData[somaOffsets[range.begin + i]];
+        };
+        if (somas)
+            gather(0, previous);
+
+        for (size_t frame = 1; frame < numFrames; ++frame)
+        {
+            const float* before;
+            const float* after;
+            if (somas)
+            {
+                gather(frame, current);
+                before = previous.data();
+                after = current.data();
+            }
+            else
+            {
+                after = data + frame * frameSize + range.begin;
+                before = after - frameSize;
+            }
+            _flagCrossings(before, after, size, threshold, flags.data());
+
+            const float time = (*frames.timeStamps)[frame];
+            const size_t count = range.spikes.size();
+            _forEachFlag(flags.data(), size, [&](const size_t i) {
+                const size_t value = range.begin + i;
+                range.spikes.emplace_back(time, somas ? gids[value]
+                                                      : uint32_t(value));
+            });
+            range.counts.push_back(range.spikes.size() - count);
+            if (somas)
+                previous.swap(current);
+        }
+    }
+};
+}
+
+SpikeDetector::SpikeDetector(const CompartmentReport& report,
+                             const float threshold, const Mode mode)
+    : _impl(new detail::SpikeDetector(report, threshold, mode,
+                                      detail::maxValuesPerWindow))
+{
+}
+
+SpikeDetector::SpikeDetector(const CompartmentReport& report,
+                             const float threshold, const Mode mode,
+                             const size_t maxValuesPerWindow)
+    : _impl(new detail::SpikeDetector(report, threshold, mode,
+                                      maxValuesPerWindow))
+{
+}
+
+SpikeDetector::~SpikeDetector()
+{
+}
+
+Spikes SpikeDetector::detect(const double start, const double end)
+{
+    Spikes spikes;
+    _impl->detect(start, end, [&spikes](const Spikes& window) {
+        spikes.insert(spikes.end(), window.begin(), window.end());
+    });
+    return spikes;
+}
+
+void SpikeDetector::detect(const double start, const double end,
+                           SpikeReport& output)
+{
+    _impl->detect(start, end, [&output](const Spikes& window) {
+        if (!window.empty())
+            output.write(window);
+    });
+}
+}
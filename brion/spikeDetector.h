@@ -0,0 +1,113 @@
+/* Copyright (c) 2018, EPFL/Blue Brain Project
+ *
+ * This file is part of Brion <https://github.com/BlueBrain/Brion>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef BRION_SPIKEDETECTOR_H
+#define BRION_SPIKEDETECTOR_H
+
+#include <brion/api.h>
+#include <brion/types.h>
+
+#include <boost/noncopyable.hpp>
+
+namespace brion
+{
+namespace detail
+{
+class SpikeDetector;
+}
+
+/**
+ * Detects spikes as upward threshold crossings in a compartment report.
+ *
+ * A spike is emitted at the timestamp of a frame whose value is at or above
+ * the threshold while the value in the previous frame was below it. The
+ * frames are streamed from the report in windows of bounded size. The next
+ * window is loaded while the current one is processed in parallel over
+ * ranges of cells by the tasks of Executor::getDefault().
+ *
+ * The report must stay valid and its mapping unchanged while the detector is
+ * used.
+ */
+class SpikeDetector : public boost::noncopyable
+{
+public:
+    /** The values tested for threshold crossings. @version 3.0 */
+    enum class Mode
+    {
+        /** The first compartment of each cell, spikes have the cell GID. */
+        somas,
+        /** All compartments, spikes have the index of the value in the
+            frame instead of a GID. */
+        compartments
+    };
+
+    /**
+     * Create a detector for the cells mapped in a report.
+     *
+     * @param report the compartment report, e.g. of voltages
+     * @param threshold the threshold crossed by the values
+     * @param mode the values tested
+     * @version 3.0
+     */
+    BRION_API SpikeDetector(const CompartmentReport& report, float threshold,
+                            Mode mode = Mode::somas);
+
+    /** @internal Create a detector loading windows of at most the given
+     *  number of values, and at least two frames. */
+    BRION_API SpikeDetector(const CompartmentReport& report, float threshold,
+                            Mode mode, size_t maxValuesPerWindow);
+
+    /** @version 3.0 */
+    BRION_API ~SpikeDetector();
+
+    /**
+     * Detect the spikes of the frames in a time window.
+     *
+     * The frame before the window, if any, is loaded to detect crossings at
+     * the first frame of the window.
+     *
+     * @param start the start of the time window
+     * @param end the end of the time window, open on the right
+     * @return the spikes sorted by time and identifier
+     * @throw std::logic_error if start >= end
+     * @throw std::runtime_error if frames can't be loaded
+     * @version 3.0
+     */
+    BRION_API Spikes detect(double start, double end);
+
+    /**
+     * Detect the spikes of the frames in a time window and write them to a
+     * spike report as they are found.
+     *
+     * @param start the start of the time window
+     * @param end the end of the time window, open on the right
+     * @param output a spike report open in write mode, positioned before
+     *        start
+     * @throw std::logic_error if start >= end
+     * @throw std::runtime_error if frames can't be loaded or spikes can't be
+     *        written
+     * @version 3.0
+     */
+    BRION_API void detect(double start, double end, SpikeReport& output);
+
+private:
+    std::unique_ptr<detail::SpikeDetector> _impl;
+};
+}
+
+#endif
@@ -18,15 +18,17 @@
  */
 
 #include "spikeReport.h"
+#include "executor.h"
 #include "spikeReportPlugin.h"
 
 #include "pluginInitData.h"
 
+#include "detail/trace.h"
+
 #include <brion/version.h>
 
 #include <lunchbox/plugin.h>
 #include <lunchbox/pluginFactory.h>
-#include <lunchbox/threadPool.h>
 
 #include <memory>
 
@@ -68,11 +70,18 @@ public:
     explicit SpikeReport(const SpikeReportInitData& initData)
     {
         _loadPlugins();
+        BRION_TRACE("SpikeReport::open", "spikes",
+                    std::to_string(initData.getURI()));
         plugin.reset(SpikePluginFactory::getInstance().create(initData));
     }
 
+    explicit SpikeReport(std::unique_ptr<SpikeReportPlugin> plugin_)
+        : plugin(std::move(plugin_))
+    {
+    }
+
     std::unique_ptr<SpikeReportPlugin> plugin;
-    lunchbox::ThreadPool threadPool{1};
+    Executor executor{1};
     bool busy = false;
 };
 }
@@ -109,6 +118,11 @@ SpikeReport::SpikeReport(const URI& uri, const GIDSet& ids)
     _impl->plugin->setFilter(ids);
 }
 
+SpikeReport::SpikeReport(std::unique_ptr<detail::SpikeReport> impl)
+    : _impl(std::move(impl))
+{
+}
+
 SpikeReport::~SpikeReport()
 {
     if (_impl)
@@ -138,12 +152,12 @@ void SpikeReport::close()
     if (_impl->plugin->isClosed())
         return;
 
-    if (_impl->threadPool.hasPendingJobs())
+    if (_impl->executor.hasPendingJobs())
     {
         // interrupt the jobs
         _impl->plugin->_setInterrupted(true);
         // blocks until all the pending jobs are done
-        _impl->threadPool.post([] {}).get();
+        _impl->executor.post([] {}).get();
     }
     _impl->plugin->close();
     _impl->plugin->_setClosed();
@@ -178,7 +192,7 @@ void SpikeReport::interrupt()
 {
     _impl->plugin->_setInterrupted(true);
     // blocks until all the pending jobs are done
-    _impl->threadPool.post([] {}).get();
+    _impl->executor.post([] {}).get();
     _impl->busy = false;
     _impl->plugin->_setInterrupted(false);
 }
@@ -193,7 +207,8 @@ std::future<Spikes> SpikeReport::read(float min)
         LBTHROW(std::runtime_error("Can't read: Pending read operation"));
 
     _impl->busy = true;
-    return _impl->threadPool.post([&, min] {
+    return _impl->executor.post([&, min] {
+        BRION_TRACE("SpikeReport::read", "spikes");
         BusyGuard guard(_impl->busy);
         return _impl->plugin->read(min);
     });
@@ -216,7 +231,8 @@ std::future<Spikes> SpikeReport::readUntil(const float max)
         LBTHROW(std::runtime_error("Can't read: Pending read operation"));
 
     _impl->busy = true;
-    return _impl->threadPool.post([&, max] {
+    return _impl->executor.post([&, max] {
+        BRION_TRACE("SpikeReport::readUntil", "spikes");
         BusyGuard guard(_impl->busy);
         return _impl->plugin->readUntil(max);
     });
@@ -231,13 +247,14 @@ std::future<void> SpikeReport::seek(const float toTimeStamp)
             LBTHROW(std::runtime_error("Can't seek: Pending read operation"));
 
         _impl->busy = true;
-        return _impl->threadPool.post([&, toTimeStamp] {
+        return _impl->executor.post([&, toTimeStamp] {
+            BRION_TRACE("SpikeReport::seek", "spikes");
             BusyGuard guard(_impl->busy);
             _impl->plugin->readSeek(toTimeStamp);
         });
     }
 
-    return _impl->threadPool.post(
+    return _impl->executor.post(
         [&, toTimeStamp] { return _impl->plugin->writeSeek(toTimeStamp); });
 }
 
@@ -279,4 +296,40 @@ bool SpikeReport::supportsBackwardSeek() const
 {
     return _impl->plugin->supportsBackwardSeek();
 }
+
+bool SpikeReport::supportsViews() const
+{
+    return _impl->plugin->supportsViews();
+}
+
+SpikesView SpikeReport::getView(const float start, const float end) const
+{
+    _impl->plugin->_checkNotClosed();
+    if (end <= start)
+        LBTHROW(std::logic_error(
+            "Start time should be strictly inferior to end time"));
+    if (!supportsViews())
+        LBTHROW(std::runtime_error("Spike views not supported by " +
+                                   std::to_string(getURI())));
+    return _impl->plugin->getView(start, end);
+}
+
+SpikeReport SpikeReport::createCursor() const
+{
+    _impl->plugin->_checkNotClosed();
+    _impl->plugin->_checkCanRead();
+    std::unique_ptr<detail::SpikeReport> impl(
+        new detail::SpikeReport(_impl->plugin->createCursor()));
+    return SpikeReport(std::move(impl));
+}
+
+IOStatistics SpikeReport::getIOStatistics() const
+{
+    return _impl->plugin->getIOStatistics();
+}
+
+void SpikeReport::resetIOStatistics()
+{
+    _impl->plugin->resetIOStatistics();
+}
 }
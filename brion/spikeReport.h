@@ -79,7 +79,13 @@ public:
      *        - NEST ('gdf' extension). NEST file based reports. In read mode,
      *          shell wildcards are accepted at the file path leaf to load
      *          multiple report files.
-     *        - Binary ('spikes' extension)
+     *        - Binary ('spikes' extension). In write mode, the query
+     *          ?version=2 selects the compressed block format, with
+     *          ?block_duration=ms to set the duration of the blocks.
+     *        - Shared memory streams ('shm' scheme, POSIX only):
+     *          shm://name[?capacity=spikes]. A ring buffer of spikes written
+     *          by a simulation and read by any number of processes on the
+     *          same node. Readers must be opened after the writer.
      *        Support for additional types can be added through plugins; see
      *        SpikeReportPlugin for the details.
      *
@@ -253,7 +259,8 @@ public:
      * In write mode, seeks are only supported in binary reports. Forward
      * seeking
      * simply updates getCurrentTime() and backward seeking followed by a write,
-     * will overwrite the existing data.
+     * will overwrite the existing data. SONATA reports support forward seeking
+     * only.
      *
      * If the seek operation is not supported, a std::runtime_error will be
      * thrown if this method is called.
@@ -310,9 +317,62 @@ public:
      */
     BRION_API bool supportsBackwardSeek() const;
 
+    /**
+     * @return Whether getView() is supported. This is the case for
+     *         unfiltered version 1 binary reports open in read mode.
+     * @version 3.0
+     */
+    BRION_API bool supportsViews() const;
+
+    /**
+     * Get the spikes of a time window without copying them.
+     *
+     * The view points into the storage of the report, it is valid until the
+     * report is destroyed. This function does not change the current time and
+     * it may be called concurrently with any other read operation.
+     *
+     * @param start the start of the time window
+     * @param end the end of the time window, not included
+     * @return the spikes in [start, end)
+     * @throw std::logic_error if end <= start
+     * @throw std::runtime_error if the report is closed or views are not
+     *        supported.
+     * @version 3.0
+     */
+    BRION_API SpikesView getView(float start, float end) const;
+
+    /**
+     * Create an independent reader of the same report.
+     *
+     * The cursor shares the data of this report, so no file is opened or
+     * parsed again, but it has its own current time, state and pending
+     * operation. It starts at the beginning of the report with the GID filter
+     * of this report. Different cursors may be used concurrently from
+     * different threads, a single cursor may not. The cursor remains valid
+     * after this report is closed.
+     *
+     * @throw std::runtime_error if the report is closed, not open in read
+     *        mode or its plugin does not support cursors. Binary, ASCII and
+     *        HDF5 reports support them.
+     * @version 3.0
+     */
+    BRION_API SpikeReport createCursor() const;
+
+    /**
+     * @return the cumulative I/O counters of this report since it was opened
+     *         or resetIOStatistics() was called.
+     * @version 3.0
+     */
+    BRION_API IOStatistics getIOStatistics() const;
+
+    /** Reset all I/O counters to 0. @version 3.0 */
+    BRION_API void resetIOStatistics();
+
 private:
     std::unique_ptr<detail::SpikeReport> _impl;
 
+    explicit SpikeReport(std::unique_ptr<detail::SpikeReport> impl);
+
     SpikeReport(const SpikeReport&) = delete;
     SpikeReport& operator=(const SpikeReport&) = delete;
 };
@@ -22,6 +22,7 @@
 
 #include <brion/api.h>
 #include <brion/enums.h>
+#include <brion/gidFilter.h>
 #include <brion/pluginInitData.h>
 #include <brion/spikeReport.h>
 #include <brion/types.h>
@@ -29,6 +30,7 @@
 #include <boost/noncopyable.hpp>
 
 #include <functional>
+#include <memory>
 
 namespace brion
 {
@@ -140,13 +142,37 @@ public:
     /** @copydoc brion::SpikeReport::supportsBackwardSeek */
     virtual bool supportsBackwardSeek() const = 0;
 
+    /** @copydoc brion::SpikeReport::supportsViews */
+    virtual bool supportsViews() const { return false; }
+
+    /**
+     * @return a new plugin reading the same data as this one, with its own
+     *         read position at the start of the report.
+     * @sa brion::SpikeReport::createCursor
+     */
+    virtual std::unique_ptr<SpikeReportPlugin> createCursor() const
+    {
+        throw std::runtime_error(
+            "Operation not supported in spike report plugin");
+    }
+
+    /** @sa brion::SpikeReport::getView */
+    virtual SpikesView getView(float start BRION_UNUSED,
+                               float end BRION_UNUSED) const
+    {
+        throw std::runtime_error(
+            "Operation not supported in spike report plugin");
+    }
+
+    /** @copydoc brion::SpikeReport::getIOStatistics */
+    virtual IOStatistics getIOStatistics() const { return IOStatistics(); }
+    /** @copydoc brion::SpikeReport::resetIOStatistics */
+    virtual void resetIOStatistics() {}
+
     void setFilter(const GIDSet& ids)
     {
         _idsSubset = ids;
-        if (!_idsSubset.empty())
-            _pushBackFunction = &SpikeReportPlugin::_pushBackFiltered;
-        else
-            _pushBackFunction = &SpikeReportPlugin::_pushBack;
+        _filter = GIDFilter(ids);
     }
 
     virtual const URI& getURI() const { return _uri; }
@@ -157,11 +183,9 @@ public:
     bool isClosed() const { return _closed; }
     bool isInInterruptedState() const { return _interrupted; }
 protected:
-    typedef void (SpikeReportPlugin::*SpikeInsertFunction)(const Spike&,
-                                                           Spikes&) const;
-
     URI _uri;
     brion::GIDSet _idsSubset;
+    GIDFilter _filter;
     int _accessMode = brion::MODE_READ;
     float _currentTime = 0;
     float _endTime = 0;
@@ -169,7 +193,22 @@ protected:
 
     void pushBack(const Spike& spike, Spikes& spikes) const
     {
-        (this->*_pushBackFunction)(spike, spikes);
+        if (_filter.contains(spike.second))
+            spikes.push_back(spike);
+    }
+
+    /** Append the spikes passing the GID filter. Prefer this over pushBack()
+     *  for whole arrays of spikes. */
+    void pushBack(const Spike* begin, const Spike* end, Spikes& spikes) const
+    {
+        _filter.filter(begin, end - begin, spikes);
+    }
+
+    /** Append the spikes given as separate arrays passing the GID filter. */
+    void pushBack(const float* timestamps, const uint32_t* gids,
+                  const size_t size, Spikes& spikes) const
+    {
+        _filter.filter(timestamps, gids, size, spikes);
     }
 
     void checkNotInterrupted()
@@ -180,27 +219,20 @@ protected:
         }
     }
 
+    /** Copy the filter and end time of the plugin a cursor is created from. */
+    void initCursor(const SpikeReportPlugin& from)
+    {
+        _idsSubset = from._idsSubset;
+        _filter = from._filter;
+        _endTime = from._endTime;
+    }
+
 private:
     friend class ::brion::SpikeReport;
 
-    SpikeInsertFunction _pushBackFunction = &SpikeReportPlugin::_pushBack;
     bool _closed = false;
     bool _interrupted = false;
 
-    // Spike filtering.
-    void _pushBack(const Spike& spike, Spikes& spikes) const
-    {
-        spikes.push_back(spike);
-    }
-
-    void _pushBackFiltered(const Spike& spike, Spikes& spikes) const
-    {
-        if (_idsSubset.find(spike.second) != _idsSubset.end())
-        {
-            spikes.push_back(spike);
-        }
-    }
-
     // Used in SpikeReport.
     void _setClosed() { _closed = true; }
     void _checkCanRead()
@@ -0,0 +1,298 @@
+/* Copyright (c) 2018, EPFL/Blue Brain Project
+ *
+ * This file is part of Brion <https://github.com/BlueBrain/Brion>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "spikeReportSorter.h"
+#include "executor.h"
+#include "spikeReport.h"
+
+#include "detail/mergeSpikes.h"
+
+#include <lunchbox/log.h>
+#include <lunchbox/memoryMap.h>
+
+#include <boost/filesystem.hpp>
+
+#include <fstream>
+
+namespace fs = boost::filesystem;
+
+namespace brion
+{
+namespace
+{
+// Below this number of spikes per task, spikes are sorted sequentially
+constexpr size_t _minSortSize = 1 << 16;
+
+size_t _getNumThreads()
+{
+    return Executor::getDefault()->getSize();
+}
+
+// Calls func(i) for i in [0, size) in parallel, one bulk task per index
+template <typename F>
+void _parallel(const size_t size, const F& func)
+{
+    auto executor = Executor::getDefault();
+    std::vector<std::future<void>> tasks;
+    for (size_t i = 0; i < size; ++i)
+        tasks.push_back(
+            executor->post([&func, i] { func(i); }, Executor::Priority::bulk));
+    // The tasks refer to the caller's stack, wait for all of them before
+    // rethrowing the first exception
+    for (auto& task : tasks)
+        task.wait();
+    for (auto& task : tasks)
+        task.get();
+}
+
+bool _byTime(const Spike& spike, const float time)
+{
+    return spike.first < time;
+}
+}
+
+namespace detail
+{
+class SpikeReportSorter
+{
+public:
+    SpikeReportSorter(const URI& uri, const size_t memoryBudget,
+                      const std::string& tmpDir_)
+        : report(uri, MODE_WRITE)
+        , capacity(std::max(size_t(1), memoryBudget / sizeof(Spike)))
+        , tmpDir(tmpDir_.empty() ? fs::temp_directory_path()
+                                 : fs::path(tmpDir_))
+    {
+    }
+
+    ~SpikeReportSorter() { removeRuns(); }
+
+    void write(const Spike* spikes, size_t size)
+    {
+        while (size > 0)
+        {
+            if (buffer.size() == capacity)
+                spill();
+            const size_t count = std::min(size, capacity - buffer.size());
+            buffer.insert(buffer.end(), spikes, spikes + count);
+            spikes += count;
+            size -= count;
+        }
+    }
+
+    void close()
+    {
+        std::vector<SpikeRange> runs;
+        if (files.empty())
+            runs = sortChunks();
+        else
+        {
+            // Free the buffer for the merge
+            if (!buffer.empty())
+                spill();
+            Spikes().swap(buffer);
+            for (size_t i = 0; i < files.size(); ++i)
+            {
+                maps.emplace_back(new lunchbox::MemoryMap(files[i].string()));
+                const Spike* spikes = maps.back()->getAddress<Spike>();
+                if (!spikes)
+                    LBTHROW(std::runtime_error("Cannot read spike run " +
+                                               files[i].string()));
+                for (size_t j = 0; j + 1 < bounds[i].size(); ++j)
+                    runs.emplace_back(spikes + bounds[i][j],
+                                      spikes + bounds[i][j + 1]);
+            }
+        }
+        merge(runs);
+        report.close();
+        removeRuns();
+    }
+
+    brion::SpikeReport report;
+    const size_t capacity; // of the buffer, in spikes
+    const fs::path tmpDir;
+    Spikes buffer;
+
+    // The runs written to temporary files and the boundaries of the sorted
+    // chunks of each file
+    std::vector<fs::path> files;
+    std::vector<std::vector<size_t>> bounds;
+    std::vector<std::unique_ptr<lunchbox::MemoryMap>> maps;
+    size_t numRuns = 0;
+
+private:
+    // Sorts the buffer in chunks in parallel, @return the sorted chunks
+    std::vector<SpikeRange> sortChunks()
+    {
+        const size_t numChunks =
+            std::max(size_t(1),
+                     std::min(_getNumThreads(), buffer.size() / _minSortSize));
+        const auto chunkBegin = [&](const size_t chunk) {
+            return buffer.data() + buffer.size() * chunk / numChunks;
+        };
+        _parallel(numChunks, [&](const size_t chunk) {
+            std::sort(chunkBegin(chunk), chunkBegin(chunk + 1));
+        });
+
+        std::vector<SpikeRange> chunks;
+        for (size_t i = 0; i < numChunks; ++i)
+            chunks.emplace_back(chunkBegin(i), chunkBegin(i + 1));
+        return chunks;
+    }
+
+    void spill()
+    {
+        const auto chunks = sortChunks();
+        files.push_back(tmpDir /
+                        fs::unique_path("brion-spikes-%%%%-%%%%-%%%%.tmp"));
+        std::ofstream file(files.back().string(),
+                           std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(buffer.data()),
+                   buffer.size() * sizeof(Spike));
+        if (!file)
+            LBTHROW(std::runtime_error("Cannot write spike run " +
+                                       files.back().string()));
+
+        bounds.emplace_back(1, 0);
+        for (const auto& chunk : chunks)
+            bounds.back().push_back(chunk.second - buffer.data());
+        buffer.clear();
+        ++numRuns;
+    }
+
+    // Unmaps and removes the temporary files of the runs
+    void removeRuns()
+    {
+        maps.clear();
+        for (const auto& file : files)
+        {
+            boost::system::error_code error;
+            fs::remove(file, error);
+        }
+        files.clear();
+        bounds.clear();
+    }
+
+    // Merges the runs into the report, in parts of about the size of the
+    // buffer. The parts are split at spike times sampled from the runs, so
+    // that the spikes with the same time are written at once.
+    void merge(const std::vector<SpikeRange>& runs)
+    {
+        size_t total = 0;
+        for (const auto& run : runs)
+            total += run.second - run.first;
+        if (total == 0)
+            return;
+
+        const size_t numThreads = _getNumThreads();
+        const size_t partSize =
+            std::max(_minSortSize, capacity / numThreads);
+        const size_t numParts = (total + partSize - 1) / partSize;
+
+        floats samples;
+        for (const auto& run : runs)
+        {
+            const size_t size = run.second - run.first;
+            for (size_t i = 1; size > 0 && i < numParts; ++i)
+                samples.push_back(run.first[size * i / numParts].first);
+        }
+        std::sort(samples.begin(), samples.end());
+        floats splitters;
+        for (size_t i = 1; i < numParts; ++i)
+            splitters.push_back(samples[samples.size() * i / numParts]);
+
+        std::vector<const Spike*> positions;
+        for (const auto& run : runs)
+            positions.push_back(run.first);
+
+        for (size_t first = 0; first < numParts; first += numThreads)
+        {
+            const size_t size = std::min(numThreads, numParts - first);
+            std::vector<std::vector<SpikeRange>> parts(size);
+            std::vector<Spikes> merged(size);
+            for (size_t p = 0; p < size; ++p)
+            {
+                size_t count = 0;
+                for (size_t r = 0; r < runs.size(); ++r)
+                {
+                    const Spike* end =
+                        first + p + 1 < numParts
+                            ? std::lower_bound(positions[r], runs[r].second,
+                                               splitters[first + p], _byTime)
+                            : runs[r].second;
+                    parts[p].emplace_back(positions[r], end);
+                    count += end - positions[r];
+                    positions[r] = end;
+                }
+                merged[p].resize(count);
+            }
+
+            _parallel(size, [&](const size_t p) {
+                mergeSpikes(parts[p], merged[p].data());
+            });
+            for (const auto& spikes : merged)
+                report.write(spikes);
+        }
+    }
+};
+}
+
+SpikeReportSorter::SpikeReportSorter(const URI& uri, const size_t memoryBudget,
+                                     const std::string& tmpDir)
+    : _impl(new detail::SpikeReportSorter(uri, memoryBudget, tmpDir))
+{
+}
+
+SpikeReportSorter::~SpikeReportSorter()
+{
+    if (_impl->report.isClosed())
+        return;
+    try
+    {
+        close();
+    }
+    catch (const std::exception& e)
+    {
+        LBERROR << "Error closing spike report sorter: " << e.what()
+                << std::endl;
+    }
+}
+
+void SpikeReportSorter::write(const Spike* spikes, const size_t size)
+{
+    if (_impl->report.isClosed())
+        LBTHROW(std::runtime_error("Can't write spikes: Sorter is closed"));
+    _impl->write(spikes, size);
+}
+
+void SpikeReportSorter::write(const Spikes& spikes)
+{
+    write(spikes.data(), spikes.size());
+}
+
+void SpikeReportSorter::close()
+{
+    if (!_impl->report.isClosed())
+        _impl->close();
+}
+
+size_t SpikeReportSorter::getNumRuns() const
+{
+    return _impl->numRuns;
+}
+}
@@ -0,0 +1,102 @@
+/* Copyright (c) 2018, EPFL/Blue Brain Project
+ *
+ * This file is part of Brion <https://github.com/BlueBrain/Brion>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef BRION_SPIKEREPORTSORTER_H
+#define BRION_SPIKEREPORTSORTER_H
+
+#include <brion/api.h>
+#include <brion/types.h>
+
+#include <boost/noncopyable.hpp>
+
+namespace brion
+{
+namespace detail
+{
+class SpikeReportSorter;
+}
+
+/**
+ * Writes spikes given in any order to a spike report, sorted by time.
+ *
+ * The spikes are buffered in memory up to a budget. When the buffer is full,
+ * it is sorted and written to a temporary file as a sorted run. close() merges
+ * the runs into the report, in parts of the size of the memory budget which
+ * are merged in parallel. Spikes with equal times are sorted by GID.
+ *
+ * The temporary files are removed when the sorter is closed or destroyed.
+ * This class is not thread-safe.
+ */
+class SpikeReportSorter : public boost::noncopyable
+{
+public:
+    /**
+     * Create a sorter writing to a new spike report.
+     *
+     * @param uri the URI of the spike report, see SpikeReport::SpikeReport.
+     * @param memoryBudget the approximate memory used to buffer and merge
+     *        spikes, in bytes.
+     * @param tmpDir the directory of the temporary files, the temporary
+     *        directory of the system if empty.
+     * @throw std::runtime_error if the report can't be open in write mode.
+     * @version 3.0
+     */
+    BRION_API explicit SpikeReportSorter(
+        const URI& uri, size_t memoryBudget = size_t(1) << 30,
+        const std::string& tmpDir = std::string());
+
+    /** Close the sorter if it was not closed. @version 3.0 */
+    BRION_API ~SpikeReportSorter();
+
+    /**
+     * Add spikes in any order.
+     *
+     * @throw std::runtime_error if the sorter is closed or a temporary file
+     *        can't be written.
+     * @version 3.0
+     */
+    BRION_API void write(const Spike* spikes, size_t size);
+
+    /**
+     * Overload of the function above provided for convenience
+     * @version 3.0
+     */
+    BRION_API void write(const Spikes& spikes);
+
+    /**
+     * Write all the spikes to the report sorted by time and close it.
+     *
+     * Does nothing if the sorter is already closed.
+     *
+     * @throw std::runtime_error on I/O errors.
+     * @version 3.0
+     */
+    BRION_API void close();
+
+    /**
+     * @return the number of sorted runs written to temporary files.
+     * @version 3.0
+     */
+    BRION_API size_t getNumRuns() const;
+
+private:
+    std::unique_ptr<detail::SpikeReportSorter> _impl;
+};
+}
+
+#endif
@@ -22,6 +22,7 @@
 
 #include "synapse.h"
 #include "detail/hdf5Mutex.h"
+#include "detail/trace.h"
 
 #include <highfive/H5DataSet.hpp>
 #include <highfive/H5File.hpp>
@@ -84,7 +85,7 @@ class SynapseFile : public boost::noncopyable
 public:
     explicit SynapseFile(const std::string& source)
     {
-        std::lock_guard<std::mutex> lock(detail::hdf5Mutex());
+        detail::HDF5Lock lock;
 
         try
         {
@@ -115,7 +116,7 @@ public:
 
     ~SynapseFile()
     {
-        std::lock_guard<std::mutex> lock(detail::hdf5Mutex());
+        detail::HDF5Lock lock;
         _file.reset();
     }
 
@@ -126,7 +127,7 @@ public:
         if (!bits.any())
             return SynapseMatrix();
 
-        std::lock_guard<std::mutex> lock(detail::hdf5Mutex());
+        detail::HDF5Lock lock;
         Dataset dataset;
         if (!_openDataset(gid, dataset))
             return SynapseMatrix();
@@ -148,7 +149,7 @@ public:
     size_t getNumAttributes() const { return _numAttributes; }
     size_t getNumSynapses(const GIDSet& gids) const
     {
-        std::lock_guard<std::mutex> lock(detail::hdf5Mutex());
+        detail::HDF5Lock lock;
         size_t numSynapses = 0;
         for (const uint32_t gid : gids)
         {
@@ -375,7 +376,7 @@ private:
         // usually results in waiting for I/O and non-parallizable search thanks
         // to HDF5
 
-        std::lock_guard<std::mutex> lock(detail::hdf5Mutex());
+        detail::HDF5Lock lock;
         HighFive::SilenceHDF5 silence;
 
         // this trial-and-error is the 'fastest' path found
@@ -413,6 +414,7 @@ Synapse::~Synapse()
 
 SynapseMatrix Synapse::read(const uint32_t gid, const uint32_t attributes) const
 {
+    BRION_TRACE("Synapse::read", "synapse", std::to_string(gid));
     return _impl->read(gid, attributes);
 }
 
@@ -45,7 +45,7 @@ class SynapseSummary
 public:
     explicit SynapseSummary(const std::string& source)
     {
-        std::lock_guard<std::mutex> lock(detail::hdf5Mutex());
+        detail::HDF5Lock lock;
 
         try
         {
@@ -77,7 +77,7 @@ public:
 
     ~SynapseSummary()
     {
-        std::lock_guard<std::mutex> lock(detail::hdf5Mutex());
+        detail::HDF5Lock lock;
 
         if (_file)
             _file.reset();
@@ -85,7 +85,7 @@ public:
 
     SynapseSummaryMatrix read(const uint32_t gid)
     {
-        std::lock_guard<std::mutex> lock(detail::hdf5Mutex());
+        detail::HDF5Lock lock;
 
         if (!_loadDataset(gid))
             return SynapseSummaryMatrix();
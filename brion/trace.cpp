@@ -0,0 +1,48 @@
+/* Copyright (c) 2018, EPFL/Blue Brain Project
+ *
+ * This file is part of Brion <https://github.com/BlueBrain/Brion>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "trace.h"
+
+#include "detail/trace.h"
+
+namespace brion
+{
+namespace detail
+{
+Tracer& tracer()
+{
+    static Tracer _tracer;
+    return _tracer;
+}
+}
+
+void startTracing(const std::string& filename)
+{
+    detail::tracer().start(filename);
+}
+
+void stopTracing()
+{
+    detail::tracer().stop();
+}
+
+bool isTracing()
+{
+    return detail::tracer().isEnabled();
+}
+}
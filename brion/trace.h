@@ -0,0 +1,55 @@
+/* Copyright (c) 2018, EPFL/Blue Brain Project
+ *
+ * This file is part of Brion <https://github.com/BlueBrain/Brion>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#pragma once
+
+#include <brion/api.h>
+
+#include <string>
+
+namespace brion
+{
+/** @name Event tracing
+ *
+ * Scoped events of the I/O paths of Brion and Brain (report and morphology
+ * loading, mapping parsing, synapse reads, HDF5 lock waits and asynchronous
+ * tasks) can be recorded together with the thread that executed them. The
+ * result is written in the Chrome trace event format, which can be inspected
+ * in chrome://tracing or https://ui.perfetto.dev.
+ *
+ * Setting the environment variable BRION_TRACE to a file name has the same
+ * effect as calling startTracing() at startup, the trace is written at exit.
+ */
+//@{
+/**
+ * Start recording events, discarding any events recorded before.
+ * @param filename the output file for stopTracing().
+ * @version 3.0
+ */
+BRION_API void startTracing(const std::string& filename);
+
+/**
+ * Stop recording events and write them to the file given to startTracing().
+ * @version 3.0
+ */
+BRION_API void stopTracing();
+
+/** @return true if events are being recorded. @version 3.0 */
+BRION_API bool isTracing();
+//@}
+}
@@ -46,11 +46,14 @@ class BlueConfig;
 class Circuit;
 class CompartmentReport;
 class CompartmentReportPlugin;
+class CompartmentReportStatistics;
 class Mesh;
 class Morphology;
 class MorphologyInitData;
+class SpikeDetector;
 class SpikeReport;
 class SpikeReportPlugin;
+class SpikeReportSorter;
 class Synapse;
 class SynapseSummary;
 class Target;
@@ -118,6 +121,20 @@ typedef boost::multi_array<uint32_t, 2> SynapseSummaryMatrix;
 typedef std::pair<float, uint32_t> Spike;
 typedef std::vector<Spike> Spikes;
 
+/**
+ * A read-only range of spikes owned by a report, see SpikeReport::getView().
+ * @version 3.0
+ */
+struct SpikesView
+{
+    const Spike* data = nullptr;
+    size_t size = 0;
+
+    const Spike* begin() const { return data; }
+    const Spike* end() const { return data + size; }
+    bool empty() const { return size == 0; }
+};
+
 /** A list of Spikes events per cell gid, indexed by spikes times. */
 typedef std::multimap<float, uint32_t> SpikeMap;
 
@@ -137,6 +154,29 @@ struct Frames
     floatsPtr data;
 };
 
+/**
+ * Cumulative I/O counters of a report since its opening or the last reset.
+ *
+ * Not all counters are meaningful for all backends, unsupported ones stay 0.
+ */
+struct IOStatistics
+{
+    /** Payload bytes requested by the callers. */
+    uint64_t bytesRequested = 0;
+    /** Bytes read from storage, including read amplification. */
+    uint64_t bytesRead = 0;
+    /** Number of read system calls, AIO operations or HDF5 reads. */
+    uint64_t readOperations = 0;
+    /** HDF5 chunk accesses served from the chunk cache. */
+    uint64_t cacheHits = 0;
+    /** HDF5 chunk accesses that had to be read from storage. */
+    uint64_t cacheMisses = 0;
+    /** Time spent waiting for the HDF5 lock in milliseconds. */
+    double lockWaitTime = 0;
+    /** Time spent decoding data (parsing, byte swapping) in milliseconds. */
+    double decodeTime = 0;
+};
+
 /** A value for undefined timestamps */
 
 const float UNDEFINED_TIMESTAMP BRION_UNUSED =
@@ -24,11 +24,18 @@
 
 #include <BBP/TestDatasets.h>
 #include <brain/compartmentReport.h>
+#include <brain/compartmentReportGroup.h>
 #include <brain/compartmentReportMapping.h>
+#include <brain/compartmentReportView.h>
+#include <brain/spikeReportReader.h>
+#include <brain/spikeTriggeredFrames.h>
 
 #include <boost/filesystem/operations.hpp>
 #include <boost/test/unit_test.hpp>
 
+#include <chrono>
+#include <cmath>
+
 #define TIMESTEP_PRECISION 0.000005
 
 BOOST_AUTO_TEST_CASE(invalid_open)
@@ -372,3 +379,122 @@ BOOST_AUTO_TEST_CASE(indices_binary)
 {
     testIndices("local/simulations/may17_2011/Control/allCompartments.bbp");
 }
+
+BOOST_AUTO_TEST_CASE(spike_triggered_frames)
+{
+    boost::filesystem::path path(BBP_TESTDATA);
+    path /= "local/simulations/may17_2011/Control/";
+    brain::SpikeReportReader spikes(brion::URI((path / "out.dat").string()));
+    brain::CompartmentReport report(
+        brion::URI((path / "allCompartments.bbp").string()));
+    auto view = report.createView(brion::GIDSet{1, 400});
+    const size_t frameSize = view.getMapping().getFrameSize();
+    const double timestep = report.getMetaData().timeStep;
+
+    const auto result =
+        brain::loadSpikeTriggeredFrames(spikes, {}, 0, 10, view, 0.5, 1);
+    BOOST_REQUIRE(!result.spikes.empty());
+    BOOST_CHECK_EQUAL(result.numFrames, 15);
+    BOOST_CHECK_EQUAL(result.frameSize, frameSize);
+    BOOST_REQUIRE_EQUAL(result.startTimes.size(), result.spikes.size());
+    BOOST_REQUIRE_EQUAL(result.data.size(),
+                        result.spikes.size() * 15 * frameSize);
+
+    for (size_t i = 0; i < result.spikes.size(); ++i)
+    {
+        BOOST_CHECK_LE(result.startTimes[i],
+                       result.spikes[i].first - 0.5 + 1e-4);
+        BOOST_CHECK_GT(result.startTimes[i] + timestep,
+                       result.spikes[i].first - 0.5 + 1e-4);
+        for (size_t k = 0; k < 15; ++k)
+        {
+            const double time = result.startTimes[i] + (k + 0.5) * timestep;
+            const float* values =
+                result.data.data() + (i * 15 + k) * frameSize;
+            if (time < 0 || time >= 10)
+            {
+                BOOST_CHECK(std::isnan(values[0]));
+                continue;
+            }
+            const auto frame = view.load(time).get();
+            BOOST_CHECK_EQUAL_COLLECTIONS(values, values + frameSize,
+                                          frame.data->begin(),
+                                          frame.data->end());
+        }
+    }
+
+    const auto filtered =
+        brain::loadSpikeTriggeredFrames(spikes, {1, 2, 3}, 0, 10, view, 0.5, 1);
+    for (const auto& spike : filtered.spikes)
+        BOOST_CHECK_LE(spike.second, 3);
+
+    BOOST_CHECK_THROW(brain::loadSpikeTriggeredFrames(spikes, {}, 1, 1, view,
+                                                      0.5, 1),
+                      std::logic_error);
+    BOOST_CHECK_THROW(brain::loadSpikeTriggeredFrames(spikes, {}, 0, 10, view,
+                                                      0.5, -0.5),
+                      std::logic_error);
+}
+
+BOOST_AUTO_TEST_CASE(report_group)
+{
+    boost::filesystem::path path(BBP_TESTDATA);
+    path /= "local/simulations/may17_2011/Control/";
+    const brion::URI voltages((path / "voltage.h5").string());
+    const brion::URI compartments((path / "allCompartments.h5").string());
+    brain::CompartmentReportGroup group({voltages, compartments, voltages});
+    BOOST_REQUIRE_EQUAL(group.getSize(), 3);
+    const auto& metaData = group.getMetaData();
+    BOOST_CHECK_EQUAL(metaData.startTime, 0);
+    BOOST_CHECK_EQUAL(metaData.endTime, 10);
+    BOOST_CHECK_EQUAL(metaData.frameCount, 100);
+
+    brion::GIDSet common;
+    for (const auto gid : group.getReport(1).getGIDs())
+        if (group.getReport(0).getGIDs().count(gid))
+            common.insert(gid);
+    BOOST_CHECK(group.getGIDs() == common);
+
+    BOOST_CHECK_THROW(group.createView(brion::GIDSet{123456789}),
+                      std::runtime_error);
+
+    auto view = group.createView(brion::GIDSet{1, 400});
+    BOOST_REQUIRE_EQUAL(view.getSize(), 3);
+    BOOST_CHECK(view.getGIDs() == (brion::GIDSet{1, 400}));
+    // The views of the same report share their mapping index
+    BOOST_CHECK_EQUAL(&view.getView(0).getMapping().getIndex(),
+                      &view.getView(2).getMapping().getIndex());
+
+    // The future is fulfilled by the loads, not deferred until queried
+    auto future = view.load(0.55);
+    BOOST_REQUIRE(future.wait_for(std::chrono::seconds(10)) ==
+                  std::future_status::ready);
+    const auto frames = future.get();
+    BOOST_REQUIRE_EQUAL(frames.size(), 3);
+    for (size_t i = 0; i < frames.size(); ++i)
+    {
+        const auto frame = view.getView(i).load(0.55).get();
+        BOOST_CHECK_EQUAL(frames[i].timestamp, frame.timestamp);
+        BOOST_CHECK_EQUAL_COLLECTIONS(frames[i].data->begin(),
+                                      frames[i].data->end(),
+                                      frame.data->begin(), frame.data->end());
+    }
+
+    const auto windows = view.load(2, 3).get();
+    BOOST_REQUIRE_EQUAL(windows.size(), 3);
+    for (size_t i = 0; i < windows.size(); ++i)
+    {
+        const auto window = view.getView(i).load(2, 3).get();
+        BOOST_CHECK_EQUAL_COLLECTIONS(windows[i].timeStamps->begin(),
+                                      windows[i].timeStamps->end(),
+                                      windows[0].timeStamps->begin(),
+                                      windows[0].timeStamps->end());
+        BOOST_CHECK_EQUAL_COLLECTIONS(windows[i].data->begin(),
+                                      windows[i].data->end(),
+                                      window.data->begin(),
+                                      window.data->end());
+    }
+
+    BOOST_CHECK_THROW(view.load(metaData.endTime), std::logic_error);
+    BOOST_CHECK_THROW(view.load(3, 2), std::logic_error);
+}
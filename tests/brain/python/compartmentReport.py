@@ -210,5 +210,42 @@ class TestMemoryManagement(unittest.TestCase):
         assert(mapping.num_compartments(1) == 1)
         assert(mapping.index.tolist() == [(1, 0), (2, 0), (3, 0)])
 
+class TestSpikeTriggeredFrames(unittest.TestCase):
+    def test_load(self):
+        spikes_path = brain.test.root_data_path + \
+            "/local/simulations/may17_2011/Control/out.dat"
+        reader = SpikeReportReader(spikes_path)
+        view = CompartmentReport(report_path).create_view({1, 2, 3})
+        spikes, start_times, data = load_spike_triggered_frames(
+            reader, [], 1, 9, view, 0.5, 1.0)
+        assert(len(spikes) > 0)
+        assert(len(start_times) == len(spikes))
+        assert(data.shape == (len(spikes), 15, 3))
+
+        timestamp, frame = view.load(start_times[0] + 0.05)
+        assert((data[0][0] == frame).all())
+
+class TestReportGroup(unittest.TestCase):
+    def test_load(self):
+        group = CompartmentReportGroup(
+            [report_path, all_compartments_report_path])
+        assert(len(group) == 2)
+        assert(group.metadata['frame_count'] == 100)
+        assert(group.report(1).cell_count == 35)
+        self.assertRaises(IndexError, lambda: group.report(2))
+
+        view = group.create_view({1, 400})
+        assert(len(view) == 2)
+        assert(view.gids.tolist() == [1, 400])
+        frames = view.load(0.55)
+        assert(len(frames) == 2)
+        for i in range(2):
+            timestamp, frame = view.view(i).load(0.55)
+            assert(frames[i][0] == timestamp)
+            assert((frames[i][1] == frame).all())
+
+        windows = view.load(2, 3)
+        assert((windows[0][0] == windows[1][0]).all())
+
 if __name__ == '__main__':
     unittest.main()
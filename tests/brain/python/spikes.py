@@ -61,6 +61,27 @@ class TestSpikeReportReader(unittest.TestCase):
         for time, gid in spikes:
             assert(gid in gids)
 
+    def test_get_cell_spikes(self):
+        gids = {1, 10, 100}
+        reader = brain.SpikeReportReader(self.filename)
+        spikes = reader.get_spikes(gids, 1, 9)
+        assert(len(spikes) > 0)
+        for time, gid in spikes:
+            assert(gid in gids)
+            assert(time >= 1 and time < 9)
+        all_spikes = reader.get_spikes(1, 9)
+        assert(len(spikes) == len([s for s in all_spikes if s[1] in gids]))
+
+    def test_get_spikes_view(self):
+        reader = brain.SpikeReportReader(self.filename)
+        assert(reader.supports_spikes_view)
+        view = reader.get_spikes_view(1, 5)
+        assert(not view.flags.writeable)
+        assert((view == reader.get_spikes(1, 5)).all())
+        del reader
+        # The view keeps the report alive
+        assert(view[0][0] >= 1)
+
     def test_properties(self):
         reader = brain.SpikeReportReader(self.filename)
         # assertAlmostEqual fails due to a float <-> double conversion error
@@ -75,5 +96,22 @@ class TestSpikeReportReader(unittest.TestCase):
         spikes = reader.get_spikes(0, float("inf"))
         assert(reader.has_ended)
 
+    def test_statistics(self):
+        reader = brain.SpikeReportReader(self.filename)
+        spikes = reader.get_spikes(0, 10)
+        gids = {1, 10, 100}
+        counts = brain.compute_spike_counts(reader, [[], gids], 0, 10, 0.5)
+        assert(len(counts) == 2)
+        assert(len(counts[0]) == 20)
+        assert(counts[0].sum() == len(spikes))
+        assert(counts[1].sum() == len([s for s in spikes if s[1] in gids]))
+
+        rates = brain.compute_firing_rates(reader, gids, 0, 10)
+        assert(len(rates) == len(gids))
+        psth = brain.compute_psth(reader, gids, [2, 7], 1, 2, 0.5)
+        assert(len(psth) == 6)
+        self.assertRaises(RuntimeError,
+            lambda: brain.compute_population_rates(reader, [[]], 0, 10, 1))
+
 if __name__ == '__main__':
     unittest.main()
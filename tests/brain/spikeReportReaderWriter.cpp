@@ -20,6 +20,7 @@
 #include <brain/brain.h>
 #include <brain/spikeReportReader.h>
 #include <brain/spikeReportWriter.h>
+#include <brion/spikeReport.h>
 
 #include <BBP/TestDatasets.h>
 
@@ -31,6 +32,8 @@
 #include <boost/filesystem/path.hpp>
 #include <boost/test/unit_test.hpp>
 
+#include <limits>
+
 #define BLURON_SPIKE_REPORT_FILE "local/simulations/may17_2011/Control/out.dat"
 
 #define BLURON_SPIKES_START_TIME 0.15f
@@ -146,6 +149,99 @@ BOOST_AUTO_TEST_CASE(test_simple_read_filtered)
         BOOST_CHECK(gids.find(spike.second) != gids.end());
 }
 
+BOOST_AUTO_TEST_CASE(test_read_cells)
+{
+    boost::filesystem::path path(BBP_TESTDATA);
+    path /= BLURON_SPIKE_REPORT_FILE;
+
+    brain::SpikeReportReader reader(brion::URI(path.string()));
+    const auto all = reader.getSpikes(0, brion::UNDEFINED_TIMESTAMP);
+    const brain::GIDSet gids{1, 10, 100, BLURON_LAST_SPIKE_GID};
+    brion::Spikes expected;
+    for (const auto& spike : all)
+    {
+        if (gids.count(spike.second) && spike.first >= 1 && spike.first < 9)
+            expected.push_back(spike);
+    }
+    BOOST_REQUIRE(!expected.empty());
+
+    const auto spikes = reader.getSpikes(gids, 1, 9);
+    BOOST_CHECK_EQUAL_COLLECTIONS(spikes.begin(), spikes.end(),
+                                  expected.begin(), expected.end());
+
+    // The index saved to a cache file gives the same results
+    TmpFile cache(".idx");
+    brain::SpikeReportReader writer(brion::URI(path.string()));
+    writer.buildIndex(cache.name);
+    BOOST_REQUIRE(boost::filesystem::exists(cache.name));
+    brain::SpikeReportReader cached(brion::URI(path.string()));
+    cached.buildIndex(cache.name);
+    const auto cachedSpikes = cached.getSpikes(gids, 1, 9);
+    BOOST_CHECK_EQUAL_COLLECTIONS(cachedSpikes.begin(), cachedSpikes.end(),
+                                  expected.begin(), expected.end());
+
+    BOOST_CHECK_THROW(reader.getSpikes(gids, 2.5f, 2.5f), std::logic_error);
+
+    // Indexing leaves the position of the report unchanged
+    brain::SpikeReportReader fresh(brion::URI(path.string()));
+    BOOST_CHECK(fresh.getSpikes(gids, 1, 9) == expected);
+    BOOST_CHECK(!fresh.hasEnded());
+    BOOST_CHECK(fresh.getSpikes(0, brion::UNDEFINED_TIMESTAMP) == all);
+}
+
+BOOST_AUTO_TEST_CASE(test_index_cache)
+{
+    boost::filesystem::path path(BBP_TESTDATA);
+    path /= BLURON_SPIKE_REPORT_FILE;
+    const brion::URI uri(path.string());
+    const brain::GIDSet gids{1, 10, 100};
+    brain::SpikeReportReader reader(uri);
+    const auto expected = reader.getSpikes(gids, 0, 10);
+    BOOST_REQUIRE(!expected.empty());
+
+    // An index of a subset is not reused by a reader of all the cells
+    TmpFile cache(".idx");
+    {
+        brain::SpikeReportReader subset(uri, brain::GIDSet{1});
+        subset.buildIndex(cache.name);
+    }
+    {
+        brain::SpikeReportReader all(uri);
+        all.buildIndex(cache.name);
+        BOOST_CHECK(all.getSpikes(gids, 0, 10) == expected);
+    }
+
+    // nor is the index of another report
+    TmpFile other(".dat");
+    {
+        brain::SpikeReportWriter writer{brion::URI(other.name)};
+        writer.writeSpikes(brion::Spikes{{0.5f, 1}, {1.5f, 10}});
+        writer.close();
+        brain::SpikeReportReader otherReader{brion::URI(other.name)};
+        otherReader.buildIndex(cache.name);
+    }
+    {
+        brain::SpikeReportReader all(uri);
+        all.buildIndex(cache.name);
+        BOOST_CHECK(all.getSpikes(gids, 0, 10) == expected);
+    }
+
+    // or of a report which has been rewritten since
+    {
+        brain::SpikeReportReader otherReader{brion::URI(other.name)};
+        otherReader.buildIndex(cache.name);
+        BOOST_CHECK_EQUAL(otherReader.getSpikes(gids, 0, 10).size(), 2);
+    }
+    {
+        brain::SpikeReportWriter writer{brion::URI(other.name)};
+        writer.writeSpikes(brion::Spikes{{0.5f, 1}, {1.5f, 10}, {2.5f, 100}});
+        writer.close();
+        brain::SpikeReportReader otherReader{brion::URI(other.name)};
+        otherReader.buildIndex(cache.name);
+        BOOST_CHECK_EQUAL(otherReader.getSpikes(gids, 0, 10).size(), 3);
+    }
+}
+
 BOOST_AUTO_TEST_CASE(test_closed_window)
 {
     boost::filesystem::path path(BBP_TESTDATA);
@@ -198,6 +294,89 @@ BOOST_AUTO_TEST_CASE(test_moving_window)
     BOOST_CHECK_EQUAL((--spikes.end())->second, NEST_LAST_SPIKE_GID);
 }
 
+BOOST_AUTO_TEST_CASE(test_retention)
+{
+    boost::filesystem::path path(BBP_TESTDATA);
+    path /= NEST_SPIKE_REPORT_FILE;
+    brain::SpikeReportReader reader(brion::URI(path.string()));
+    BOOST_CHECK_THROW(reader.setRetention(0), std::logic_error);
+
+    // The retention policy only applies to stream reports
+    reader.setRetention(1, 1024);
+    reader.getSpikes(5, brion::UNDEFINED_TIMESTAMP);
+    BOOST_CHECK_EQUAL(reader.getSpikes(0, brion::UNDEFINED_TIMESTAMP).size(),
+                      NEST_SPIKES_COUNT);
+}
+
+#ifndef _WIN32
+namespace
+{
+// The spikes received from a stream are kept in blocks of this size, which
+// the retention policy discards
+const size_t STREAM_BLOCK_SIZE = 1 << 16;
+
+// Writes one block of spikes in [10 * block, 10 * (block + 1))
+brion::Spikes writeStreamBlock(brion::SpikeReport& writer, const size_t block)
+{
+    brion::Spikes spikes;
+    for (size_t i = 0; i < STREAM_BLOCK_SIZE; ++i)
+        spikes.emplace_back(block * 10.f + i * 10.f / STREAM_BLOCK_SIZE,
+                            uint32_t(i % 1000));
+    writer.write(spikes);
+    return spikes;
+}
+}
+
+BOOST_AUTO_TEST_CASE(test_retention_stream_horizon)
+{
+    const std::string name = "shm://brain_" + servus::make_UUID().getString();
+    brion::SpikeReport writer(brion::URI(name + "?capacity=1000000"),
+                              brion::MODE_WRITE);
+    brain::SpikeReportReader reader{brion::URI(name)};
+    reader.setRetention(15);
+
+    // Each window reads the block written before it
+    const auto block0 = writeStreamBlock(writer, 0);
+    BOOST_CHECK_EQUAL(reader.getSpikes(0, 5).size(), STREAM_BLOCK_SIZE / 2);
+    const auto block1 = writeStreamBlock(writer, 1);
+    reader.getSpikes(10, 15);
+
+    // The first block ends less than 15 ms before the latest spike
+    BOOST_CHECK(reader.getSpikes(0, 10) == block0);
+
+    // and is discarded once it does not
+    writeStreamBlock(writer, 2);
+    reader.getSpikes(20, 25);
+    BOOST_CHECK_THROW(reader.getSpikes(5, 15), std::runtime_error);
+    BOOST_CHECK(reader.getSpikes(10, 20) == block1);
+    writer.close();
+}
+
+BOOST_AUTO_TEST_CASE(test_retention_stream_bytes)
+{
+    const std::string name = "shm://brain_" + servus::make_UUID().getString();
+    brion::SpikeReport writer(brion::URI(name + "?capacity=1000000"),
+                              brion::MODE_WRITE);
+    brain::SpikeReportReader reader{brion::URI(name)};
+
+    // A budget of two and a half blocks keeps the latest two blocks
+    reader.setRetention(std::numeric_limits<float>::infinity(),
+                        STREAM_BLOCK_SIZE * sizeof(brion::Spike) * 5 / 2);
+    std::vector<brion::Spikes> blocks;
+    for (size_t block = 0; block < 4; ++block)
+    {
+        blocks.push_back(writeStreamBlock(writer, block));
+        reader.getSpikes(block * 10.f, block * 10.f + 5);
+    }
+
+    BOOST_CHECK_THROW(reader.getSpikes(0, 10), std::runtime_error);
+    BOOST_CHECK_THROW(reader.getSpikes(15, 25), std::runtime_error);
+    BOOST_CHECK(reader.getSpikes(20, 30) == blocks[2]);
+    BOOST_CHECK_EQUAL(reader.getSpikes(25, 35).size(), STREAM_BLOCK_SIZE);
+    writer.close();
+}
+#endif
+
 BOOST_AUTO_TEST_CASE(TestSpikes_nest_spikes_read_write)
 {
     boost::filesystem::path path(BBP_TESTDATA);
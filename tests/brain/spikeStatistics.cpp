@@ -0,0 +1,137 @@
+/* Copyright (c) 2018, EPFL/Blue Brain Project
+ *
+ * This file is part of Brion <https://github.com/BlueBrain/Brion>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <brain/spikeReportReader.h>
+#include <brain/spikeStatistics.h>
+
+#include <BBP/TestDatasets.h>
+
+#define BOOST_TEST_MODULE SpikeStatistics
+#include <boost/filesystem/path.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <numeric>
+
+#define BLURON_SPIKE_REPORT_FILE "local/simulations/may17_2011/Control/out.dat"
+#define BLURON_SPIKES_END_TIME 9.975f
+#define BLURON_SPIKES_COUNT 274
+
+namespace
+{
+const float endTime = BLURON_SPIKES_END_TIME + 0.025f;
+
+std::string _getReportPath()
+{
+    boost::filesystem::path path(BBP_TESTDATA);
+    path /= BLURON_SPIKE_REPORT_FILE;
+    return path.string();
+}
+
+uint32_t _sum(const brain::uint32_ts& counts)
+{
+    return std::accumulate(counts.begin(), counts.end(), 0u);
+}
+}
+
+BOOST_AUTO_TEST_CASE(spike_counts)
+{
+    brain::SpikeReportReader reader{brion::URI(_getReportPath())};
+    const auto all = reader.getSpikes(0, endTime);
+    BOOST_REQUIRE_EQUAL(all.size(), BLURON_SPIKES_COUNT);
+
+    const brain::GIDSet gids{1, 10, 100, 290};
+    const auto counts =
+        brain::spikeStatistics::computeSpikeCounts(reader,
+                                                   {brain::GIDSet(), gids}, 0,
+                                                   endTime, 0.1f);
+    BOOST_REQUIRE_EQUAL(counts.size(), 2);
+    BOOST_CHECK_EQUAL(counts[0].size(), 100);
+    BOOST_CHECK_EQUAL(_sum(counts[0]), BLURON_SPIKES_COUNT);
+
+    brain::uint32_ts expected(counts[1].size(), 0);
+    for (const auto& spike : all)
+        if (gids.count(spike.second))
+            ++expected[std::min(size_t(spike.first / 0.1f),
+                                expected.size() - 1)];
+    BOOST_CHECK_EQUAL(_sum(counts[1]), _sum(expected));
+
+    BOOST_CHECK_THROW(brain::spikeStatistics::computeSpikeCounts(
+                          reader, {gids}, 1, 1, 0.1f),
+                      std::logic_error);
+    BOOST_CHECK_THROW(brain::spikeStatistics::computeSpikeCounts(
+                          reader, {gids}, 0, 1, 0),
+                      std::logic_error);
+}
+
+BOOST_AUTO_TEST_CASE(rates)
+{
+    brain::SpikeReportReader reader{brion::URI(_getReportPath())};
+    const auto all = reader.getSpikes(0, endTime);
+    const brain::GIDSet gids{1, 10, 100, 290};
+
+    const auto firingRates =
+        brain::spikeStatistics::computeFiringRates(reader, gids, 0, endTime);
+    BOOST_REQUIRE_EQUAL(firingRates.size(), gids.size());
+    auto rate = firingRates.begin();
+    for (const uint32_t gid : gids)
+    {
+        const size_t count =
+            std::count_if(all.begin(), all.end(), [gid](const brion::Spike& s) {
+                return s.second == gid;
+            });
+        BOOST_CHECK_CLOSE(*rate++, count * 1000 / endTime, 0.001);
+    }
+
+    // A single bin over the whole report gives the mean firing rate
+    const auto populationRates =
+        brain::spikeStatistics::computePopulationRates(reader, {gids}, 0,
+                                                       endTime, endTime);
+    BOOST_REQUIRE_EQUAL(populationRates[0].size(), 1);
+    BOOST_CHECK_CLOSE(populationRates[0][0],
+                      std::accumulate(firingRates.begin(), firingRates.end(),
+                                      0.f) /
+                          gids.size(),
+                      0.001);
+    BOOST_CHECK_THROW(brain::spikeStatistics::computePopulationRates(
+                          reader, {brain::GIDSet()}, 0, endTime, 1),
+                      std::logic_error);
+}
+
+BOOST_AUTO_TEST_CASE(psth)
+{
+    brain::SpikeReportReader reader{brion::URI(_getReportPath())};
+    const auto all = reader.getSpikes(0, endTime);
+    brain::GIDSet gids;
+    for (const auto& spike : all)
+        gids.insert(spike.second);
+
+    // The PSTH of a single stimulus is the population rate around it
+    const auto psth = brain::spikeStatistics::computePSTH(reader, gids, {5},
+                                                          5, 5, 0.5f);
+    const auto rates =
+        brain::spikeStatistics::computePopulationRates(reader, {gids}, 0, 10,
+                                                       0.5f);
+    BOOST_REQUIRE_EQUAL(psth.size(), 20);
+    for (size_t i = 0; i != psth.size(); ++i)
+        BOOST_CHECK_CLOSE(psth[i], rates[0][i], 0.001);
+
+    BOOST_CHECK_THROW(brain::spikeStatistics::computePSTH(reader, gids, {}, 5,
+                                                          5, 0.5f),
+                      std::logic_error);
+}
@@ -78,6 +78,31 @@ BOOST_AUTO_TEST_CASE(projection_stream)
     BOOST_CHECK_EQUAL(totalSize, 9520);
 }
 
+BOOST_AUTO_TEST_CASE(projection_stream_destroyed_while_reading)
+{
+    const brain::Circuit circuit(brion::URI(BBP_TEST_BLUECONFIG3));
+    std::vector<std::future<brain::Synapses>> futures;
+    {
+        brain::SynapsesStream stream =
+            circuit.getProjectedSynapses(circuit.getGIDs("Layer2"),
+                                         circuit.getGIDs("Layer5"));
+        while (!stream.eos())
+            futures.push_back(stream.read(4));
+    }
+    // The stream waited for its reads, the results remain valid.
+    size_t totalSize = 0;
+    for (auto& future : futures)
+        totalSize += future.get().size();
+    BOOST_CHECK_EQUAL(totalSize, 9520);
+
+    // Dropping the futures together with the stream must be safe as well.
+    brain::SynapsesStream stream =
+        circuit.getProjectedSynapses(circuit.getGIDs("Layer2"),
+                                     circuit.getGIDs("Layer5"));
+    for (size_t i = 0; i < 4; ++i)
+        stream.read(8);
+}
+
 BOOST_AUTO_TEST_CASE(afferent_synapses)
 {
     const brain::Circuit circuit(brion::URI(BBP_TEST_BLUECONFIG3));
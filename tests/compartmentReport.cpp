@@ -20,6 +20,10 @@
 
 #include <BBP/TestDatasets.h>
 #include <brion/brion.h>
+#include <brion/executor.h>
+#include <servus/uint128_t.h>
+
+#include <hdf5.h>
 
 #define BOOST_TEST_MODULE CompartmentReport
 #include <boost/date_time/posix_time/posix_time.hpp>
@@ -29,6 +33,10 @@
 #include <boost/test/unit_test.hpp>
 #include <lunchbox/log.h>
 
+#include <fstream>
+#include <set>
+#include <thread>
+
 using boost::lexical_cast;
 
 boost::filesystem::path bbpTestData(BBP_TESTDATA);
@@ -650,6 +658,40 @@ BOOST_AUTO_TEST_CASE(test_read_frames_sonata)
         "local/simulations/may17_2011/Control/allCompartments_sonata.h5");
 }
 
+void testIOStatistics(const char* relativePath)
+{
+    const auto path = bbpTestData / relativePath;
+    brion::CompartmentReport report(brion::URI(path.string()),
+                                    brion::MODE_READ);
+    report.resetIOStatistics();
+
+    const double startTime = report.getStartTime();
+    report.loadFrame(startTime).get();
+    report.loadFrames(startTime, startTime + report.getTimestep() * 3).get();
+
+    const auto stats = report.getIOStatistics();
+    BOOST_CHECK_EQUAL(stats.bytesRequested,
+                      report.getFrameSize() * sizeof(float) * 4);
+    BOOST_CHECK_GE(stats.bytesRead, stats.bytesRequested);
+    BOOST_CHECK_GT(stats.readOperations, 0);
+
+    report.resetIOStatistics();
+    BOOST_CHECK_EQUAL(report.getIOStatistics().bytesRequested, 0);
+    BOOST_CHECK_EQUAL(report.getIOStatistics().readOperations, 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_io_statistics_binary)
+{
+    testIOStatistics(
+        "local/simulations/may17_2011/Control/allCompartments.bbp");
+}
+
+BOOST_AUTO_TEST_CASE(test_io_statistics_sonata)
+{
+    testIOStatistics(
+        "local/simulations/may17_2011/Control/allCompartments_sonata.h5");
+}
+
 BOOST_AUTO_TEST_CASE(test_perf_binary)
 {
     const auto path =
@@ -733,6 +775,91 @@ BOOST_AUTO_TEST_CASE(test_convert_and_compare)
     boost::filesystem::remove_all({temp.string() + ".ldbo"});
 }
 
+BOOST_AUTO_TEST_CASE(map_report_local_store)
+{
+    const auto path = bbpTestData / "local/simulations/may17_2011/Control/";
+    const brion::URI source(path.string() + "allCompartments.bbp");
+    const auto temp =
+        boost::filesystem::temp_directory_path() / createUniquePath();
+    const brion::URI uri("local://" + temp.string());
+
+    // Local stores are read concurrently, also from the executor threads
+    brion::Executor::setDefault(std::make_shared<brion::Executor>(4));
+    if (!convert(source, uri)) // built without keyv
+    {
+        brion::Executor::setDefault(nullptr);
+        return;
+    }
+    test_compare(source, uri);
+    boost::filesystem::remove(temp);
+
+    const brion::URI compressed("local://" + temp.string() +
+                                "?compression=zlib");
+    BOOST_CHECK(convert(source, compressed));
+    test_compare(source, compressed);
+    boost::filesystem::remove(temp);
+
+    // A value which does not match the mapping fails the frame load
+    {
+        brion::CompartmentReport report(uri, brion::MODE_OVERWRITE);
+        report.writeHeader(0, 1, 1, "mV", "ms");
+        BOOST_CHECK(report.writeCompartments(1, {2}));
+        BOOST_CHECK(report.writeCompartments(2, {2}));
+        BOOST_CHECK(report.writeFrame(1, brion::floats{1, 2}, 0.5));
+        BOOST_CHECK(report.writeFrame(2, brion::floats{1, 2, 3}, 0.5));
+        BOOST_CHECK(report.flush());
+    }
+    {
+        const brion::CompartmentReport report(uri, brion::MODE_READ);
+        BOOST_CHECK_THROW(report.loadFrame(0.5).get(), std::runtime_error);
+    }
+    boost::filesystem::remove(temp);
+
+    // Enough cells for 4 batches of keys, which are loaded by distinct
+    // threads with one store per hardware thread
+    const uint32_t cellCount = 1024;
+    {
+        brion::CompartmentReport report(uri, brion::MODE_OVERWRITE);
+        report.writeHeader(0, 1, 1, "mV", "ms");
+        for (uint32_t gid = 1; gid <= cellCount; ++gid)
+        {
+            BOOST_CHECK(report.writeCompartments(gid, {1}));
+            BOOST_CHECK(report.writeFrame(gid, brion::floats{float(gid)}, 0));
+        }
+        BOOST_CHECK(report.flush());
+    }
+    const auto tracePath =
+        boost::filesystem::temp_directory_path() / createUniquePath();
+    brion::startTracing(tracePath.string());
+    {
+        const brion::CompartmentReport report(uri, brion::MODE_READ);
+        const auto frame = report.loadFrame(0).get();
+        BOOST_REQUIRE(frame.data);
+        BOOST_CHECK_EQUAL((*frame.data)[cellCount - 1], float(cellCount));
+    }
+    brion::stopTracing();
+
+    std::ifstream trace(tracePath.string());
+    const std::string events((std::istreambuf_iterator<char>(trace)),
+                             std::istreambuf_iterator<char>());
+    std::set<std::string> threads;
+    const std::string name = "\"name\":\"CompartmentReportMap::loadStore\"";
+    const std::string tid = "\"tid\":";
+    for (size_t i = events.find(name); i != std::string::npos;
+         i = events.find(name, i + 1))
+    {
+        const size_t start = events.find(tid, i) + tid.size();
+        threads.insert(events.substr(start, events.find_first_of(",}", start) -
+                                                start));
+    }
+    const size_t stores = std::max(1u, std::thread::hardware_concurrency());
+    BOOST_CHECK_EQUAL(threads.size(), std::min(stores, size_t(4)));
+
+    boost::filesystem::remove(tracePath);
+    boost::filesystem::remove(temp);
+    brion::Executor::setDefault(nullptr);
+}
+
 BOOST_AUTO_TEST_CASE(dummy_report)
 {
     const boost::filesystem::path& temp = createUniquePath();
@@ -749,3 +876,504 @@ BOOST_AUTO_TEST_CASE(dummy_report)
 
     BOOST_CHECK_NE(report3a.getFrameSize(), report2.getFrameSize());
 }
+
+namespace
+{
+// Detects the threshold crossings with a plain loop over all the frames
+brion::Spikes detectCrossings(const brion::CompartmentReport& report,
+                              const std::vector<size_t>& positions,
+                              const brion::uint32_ts& ids,
+                              const float threshold)
+{
+    const auto frames =
+        report.loadFrames(report.getStartTime(), report.getEndTime()).get();
+    const size_t frameSize = report.getFrameSize();
+    brion::Spikes spikes;
+    for (size_t frame = 1; frame < frames.timeStamps->size(); ++frame)
+    {
+        const float* previous = frames.data->data() + (frame - 1) * frameSize;
+        const float* current = previous + frameSize;
+        for (size_t i = 0; i < positions.size(); ++i)
+            if (previous[positions[i]] < threshold &&
+                current[positions[i]] >= threshold)
+            {
+                spikes.emplace_back((*frames.timeStamps)[frame], ids[i]);
+            }
+    }
+    return spikes;
+}
+}
+
+BOOST_AUTO_TEST_CASE(spike_detector_somas)
+{
+    const auto path =
+        bbpTestData / "local/simulations/may17_2011/Control/voltage.h5";
+    brion::CompartmentReport report(brion::URI(path.string()),
+                                    brion::MODE_READ, brion::GIDSet());
+    std::vector<size_t> positions;
+    brion::uint32_ts gids;
+    for (const uint32_t gid : report.getGIDs())
+    {
+        positions.push_back(report.getOffsets()[report.getIndex(gid)][0]);
+        gids.push_back(gid);
+    }
+
+    const float threshold = -30.f;
+    const auto expected = detectCrossings(report, positions, gids, threshold);
+    BOOST_REQUIRE(!expected.empty());
+
+    brion::SpikeDetector detector(report, threshold);
+    const auto spikes = detector.detect(report.getStartTime(),
+                                        report.getEndTime());
+    BOOST_CHECK_EQUAL_COLLECTIONS(spikes.begin(), spikes.end(),
+                                  expected.begin(), expected.end());
+
+    // A window in the middle of the report includes the crossings at its
+    // first frame
+    const auto window = detector.detect(2, 6);
+    brion::Spikes expectedWindow;
+    for (const auto& spike : expected)
+        if (spike.first >= 2 - 0.0001f && spike.first < 6 - 0.0001f)
+            expectedWindow.push_back(spike);
+    BOOST_CHECK_EQUAL_COLLECTIONS(window.begin(), window.end(),
+                                  expectedWindow.begin(),
+                                  expectedWindow.end());
+
+    const std::string output = "/tmp/" + servus::make_UUID().getString() +
+                               ".spikes";
+    {
+        brion::SpikeReport spikeReport(brion::URI(output), brion::MODE_WRITE);
+        detector.detect(report.getStartTime(), report.getEndTime(),
+                        spikeReport);
+    }
+    brion::SpikeReport spikeReport(brion::URI(output), brion::MODE_READ);
+    const auto written = spikeReport.read(brion::UNDEFINED_TIMESTAMP).get();
+    boost::filesystem::remove(output);
+    BOOST_CHECK_EQUAL_COLLECTIONS(written.begin(), written.end(),
+                                  expected.begin(), expected.end());
+
+    BOOST_CHECK_THROW(detector.detect(5, 5), std::logic_error);
+
+    // Windows of a few frames share their boundary frames
+    for (const size_t numFrames : {2, 3, 5})
+    {
+        brion::SpikeDetector small(report, threshold,
+                                   brion::SpikeDetector::Mode::somas,
+                                   numFrames * report.getFrameSize());
+        const auto smallSpikes =
+            small.detect(report.getStartTime(), report.getEndTime());
+        BOOST_CHECK_EQUAL_COLLECTIONS(smallSpikes.begin(), smallSpikes.end(),
+                                      expected.begin(), expected.end());
+        const auto smallWindow = small.detect(2, 6);
+        BOOST_CHECK_EQUAL_COLLECTIONS(smallWindow.begin(), smallWindow.end(),
+                                      expectedWindow.begin(),
+                                      expectedWindow.end());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(spike_detector_compartments)
+{
+    const auto path =
+        bbpTestData / "local/simulations/may17_2011/Control/allCompartments.h5";
+    brion::CompartmentReport report(brion::URI(path.string()),
+                                    brion::MODE_READ, brion::GIDSet{1, 400});
+    std::vector<size_t> positions(report.getFrameSize());
+    brion::uint32_ts ids(report.getFrameSize());
+    for (size_t i = 0; i < positions.size(); ++i)
+        positions[i] = ids[i] = i;
+
+    const float threshold = -30.f;
+    const auto expected = detectCrossings(report, positions, ids, threshold);
+    BOOST_REQUIRE(!expected.empty());
+
+    brion::SpikeDetector detector(report, threshold,
+                                  brion::SpikeDetector::Mode::compartments);
+    const auto spikes = detector.detect(report.getStartTime(),
+                                        report.getEndTime());
+    BOOST_CHECK_EQUAL_COLLECTIONS(spikes.begin(), spikes.end(),
+                                  expected.begin(), expected.end());
+
+    for (const size_t numFrames : {2, 3, 5})
+    {
+        brion::SpikeDetector small(report, threshold,
+                                   brion::SpikeDetector::Mode::compartments,
+                                   numFrames * report.getFrameSize());
+        const auto smallSpikes =
+            small.detect(report.getStartTime(), report.getEndTime());
+        BOOST_CHECK_EQUAL_COLLECTIONS(smallSpikes.begin(), smallSpikes.end(),
+                                      expected.begin(), expected.end());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(report_statistics)
+{
+    const auto path =
+        bbpTestData / "local/simulations/may17_2011/Control/allCompartments.h5";
+    const brion::URI uri(path.string());
+    const std::string statsPath =
+        "/tmp/" + servus::make_UUID().getString() + ".stats";
+    BOOST_CHECK_THROW((brion::CompartmentReportStatistics(uri, statsPath,
+                                                          false)),
+                      std::runtime_error);
+
+    const brion::CompartmentReportStatistics computed(uri, statsPath);
+    BOOST_CHECK_EQUAL(computed.getPath(), statsPath);
+    const brion::CompartmentReportStatistics loaded(uri, statsPath, false);
+
+    // The statistics of another report are stale, even if they are newer
+    const brion::URI somas(
+        (bbpTestData / "local/simulations/may17_2011/Control/voltage.h5")
+            .string());
+    BOOST_CHECK_THROW((brion::CompartmentReportStatistics(somas, statsPath,
+                                                          false)),
+                      std::runtime_error);
+    boost::filesystem::remove(statsPath);
+
+    brion::CompartmentReport report(uri, brion::MODE_READ, brion::GIDSet());
+    BOOST_CHECK_EQUAL(loaded.getFrameCount(), report.getFrameCount());
+    BOOST_CHECK_EQUAL(loaded.getFrameSize(), report.getFrameSize());
+    BOOST_CHECK_EQUAL(loaded.getCellCount(), report.getCellCount());
+    const brion::uint32_ts gids(report.getGIDs().begin(),
+                                report.getGIDs().end());
+    BOOST_CHECK(loaded.getGIDs() == gids);
+    BOOST_CHECK_THROW(loaded.getFrameStatistics(report.getFrameCount()),
+                      std::logic_error);
+
+    const auto check = [](const brion::ValueStatistics& statistics,
+                          brion::floats values) {
+        std::sort(values.begin(), values.end());
+        const auto rank = [&values](const double percentile) {
+            return values[std::round(percentile * (values.size() - 1))];
+        };
+        double sum = 0;
+        for (const float value : values)
+            sum += value;
+        BOOST_CHECK_EQUAL(statistics.min, values.front());
+        BOOST_CHECK_EQUAL(statistics.max, values.back());
+        BOOST_CHECK_CLOSE(statistics.mean, sum / values.size(), 0.0001);
+        BOOST_CHECK_EQUAL(statistics.p5, rank(0.05));
+        BOOST_CHECK_EQUAL(statistics.median, rank(0.5));
+        BOOST_CHECK_EQUAL(statistics.p95, rank(0.95));
+    };
+
+    float min = std::numeric_limits<float>::max();
+    float max = -std::numeric_limits<float>::max();
+    for (size_t i = 0; i < report.getFrameCount(); ++i)
+    {
+        const double time =
+            report.getStartTime() + (i + 0.5) * report.getTimestep();
+        const brion::floats frame = *report.loadFrame(time).get().data;
+        min = std::min(min, *std::min_element(frame.begin(), frame.end()));
+        max = std::max(max, *std::max_element(frame.begin(), frame.end()));
+        if (i % 10 != 0)
+            continue;
+
+        for (const auto* statistics : {&computed, &loaded})
+        {
+            check(statistics->getFrameStatistics(i), frame);
+            for (size_t j = 0; j < gids.size(); ++j)
+            {
+                brion::floats values;
+                const auto& offsets = report.getOffsets()[j];
+                const auto& counts = report.getCompartmentCounts()[j];
+                for (size_t k = 0; k < offsets.size(); ++k)
+                    if (counts[k] > 0)
+                        values.insert(values.end(), &frame[offsets[k]],
+                                      &frame[offsets[k]] + counts[k]);
+                if (!values.empty())
+                    check(statistics->getCellStatistics(i)[j], values);
+            }
+        }
+    }
+    BOOST_CHECK_EQUAL(loaded.getRange().first, min);
+    BOOST_CHECK_EQUAL(loaded.getRange().second, max);
+
+    // Without a writable sidecar file, the statistics are written to a
+    // temporary file removed with them
+    const auto countTemporaryFiles = [] {
+        size_t count = 0;
+        for (boost::filesystem::directory_iterator i(
+                 boost::filesystem::temp_directory_path());
+             i != boost::filesystem::directory_iterator(); ++i)
+        {
+            if (i->path().filename().string().find("brion-statistics-") == 0)
+                ++count;
+        }
+        return count;
+    };
+    const size_t temporaryFiles = countTemporaryFiles();
+    {
+        const brion::CompartmentReportStatistics unwritable(
+            uri, "/proc/" + servus::make_UUID().getString() + ".stats");
+        BOOST_CHECK(unwritable.getPath().empty());
+        BOOST_CHECK_EQUAL(countTemporaryFiles(), temporaryFiles + 1);
+        BOOST_CHECK_EQUAL(unwritable.getFrameCount(), report.getFrameCount());
+        BOOST_CHECK_EQUAL(unwritable.getRange().first, min);
+        BOOST_CHECK_EQUAL(unwritable.getRange().second, max);
+        check(unwritable.getFrameStatistics(0),
+              *report.loadFrame(report.getStartTime() +
+                                0.5 * report.getTimestep())
+                   .get()
+                   .data);
+    }
+    BOOST_CHECK_EQUAL(countTemporaryFiles(), temporaryFiles);
+}
+
+BOOST_AUTO_TEST_CASE(tail_binary)
+{
+    const auto source =
+        bbpTestData / "local/simulations/may17_2011/Control/voltage.bbp";
+    const brion::CompartmentReport complete(brion::URI(source.string()),
+                                            brion::MODE_READ, brion::GIDSet());
+    const size_t frameCount = complete.getFrameCount();
+    BOOST_REQUIRE_GT(frameCount, 3);
+
+    // The frames are stored at the end of the file
+    std::ifstream input(source.string(), std::ios::binary);
+    const std::string content((std::istreambuf_iterator<char>(input)),
+                              std::istreambuf_iterator<char>());
+    const size_t frameBytes = complete.getFrameSize() * sizeof(float);
+    const size_t dataOffset = content.size() - frameCount * frameBytes;
+
+    // Writing two frames and a half before opening the report
+    const std::string path =
+        "/tmp/" + servus::make_UUID().getString() + ".bbp";
+    std::ofstream output(path, std::ios::binary);
+    output.write(content.data(), dataOffset + frameBytes * 5 / 2);
+    output.flush();
+
+    brion::CompartmentReport report(brion::URI(path), brion::MODE_READ,
+                                    brion::GIDSet());
+    BOOST_CHECK_EQUAL(report.getFrameCount(), 2);
+    BOOST_CHECK_CLOSE(report.getEndTime(),
+                      report.getStartTime() + 2 * report.getTimestep(),
+                      0.0001);
+    BOOST_CHECK(report.refresh());
+    BOOST_CHECK(!report.waitForFrames(3, 0));
+    BOOST_CHECK(!report.loadFrame(report.getEndTime()).get().data);
+
+    output.write(content.data() + dataOffset + frameBytes * 5 / 2,
+                 content.size() - dataOffset - frameBytes * 5 / 2);
+    output.close();
+
+    BOOST_CHECK(report.waitForFrames(frameCount, 1000));
+    BOOST_CHECK(!report.refresh());
+    BOOST_CHECK_EQUAL(report.getFrameCount(), frameCount);
+    BOOST_CHECK_EQUAL(report.getEndTime(), complete.getEndTime());
+
+    const double lastTime =
+        report.getStartTime() + (frameCount - 0.5) * report.getTimestep();
+    const auto frame = report.loadFrame(lastTime).get();
+    const auto expected = complete.loadFrame(lastTime).get();
+    BOOST_CHECK_EQUAL_COLLECTIONS(frame.data->begin(), frame.data->end(),
+                                  expected.data->begin(),
+                                  expected.data->end());
+    boost::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(tail_sonata)
+{
+    const auto path = bbpTestData /
+                      "local/simulations/may17_2011/Control/voltage_sonata.h5";
+    brion::CompartmentReport report(brion::URI(path.string() + "?tail"),
+                                    brion::MODE_READ, brion::GIDSet());
+    const brion::CompartmentReport complete(brion::URI(path.string()),
+                                            brion::MODE_READ, brion::GIDSet());
+
+    BOOST_CHECK(!report.refresh());
+    BOOST_CHECK_EQUAL(report.getFrameCount(), complete.getFrameCount());
+    BOOST_CHECK_EQUAL(report.getEndTime(), complete.getEndTime());
+    BOOST_CHECK(report.waitForFrames(report.getFrameCount()));
+    BOOST_CHECK(!report.waitForFrames(report.getFrameCount() + 1));
+
+    const auto frame = report.loadFrame(report.getStartTime()).get();
+    const auto expected = complete.loadFrame(complete.getStartTime()).get();
+    BOOST_CHECK_EQUAL_COLLECTIONS(frame.data->begin(), frame.data->end(),
+                                  expected.data->begin(),
+                                  expected.data->end());
+}
+
+namespace
+{
+const hsize_t swmrFrameSize = 4;
+const size_t swmrFrameCount = 5;
+
+// A SONATA report of 2 cells of 2 compartments written with SWMR, frame i
+// has the values i * 10 + compartment.
+class SWMRReport
+{
+public:
+    explicit SWMRReport(const std::string& path)
+        : _path(path)
+    {
+        const hid_t access = H5Pcreate(H5P_FILE_ACCESS);
+        H5Pset_libver_bounds(access, H5F_LIBVER_LATEST, H5F_LIBVER_LATEST);
+        _file = H5Fcreate(path.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, access);
+        H5Pclose(access);
+        BOOST_REQUIRE_GE(_file, 0);
+
+        const uint32_t magic = 0x0A7A;
+        const uint32_t version[] = {0, 1};
+        _write(_createAttribute("magic", H5T_NATIVE_UINT32, 1),
+               H5T_NATIVE_UINT32, &magic);
+        _write(_createAttribute("version", H5T_NATIVE_UINT32, 2),
+               H5T_NATIVE_UINT32, version);
+
+        const hid_t mapping = H5Gcreate2(_file, "mapping", H5P_DEFAULT,
+                                         H5P_DEFAULT, H5P_DEFAULT);
+        const double time[] = {0, swmrFrameCount * 0.1, 0.1};
+        const uint32_t gids[] = {1, 2};
+        const uint64_t offsets[] = {0, 2, 4};
+        const uint32_t sections[] = {0, 1, 0, 1};
+        _writeDataSet(mapping, "time", H5T_NATIVE_DOUBLE, 3, time);
+        _writeDataSet(mapping, "gids", H5T_NATIVE_UINT32, 2, gids);
+        _writeDataSet(mapping, "index_pointer", H5T_NATIVE_UINT64, 3,
+                      offsets);
+        _writeDataSet(mapping, "element_id", H5T_NATIVE_UINT32, 4, sections);
+        H5Gclose(mapping);
+
+        const hsize_t dims[] = {0, swmrFrameSize};
+        const hsize_t maxDims[] = {H5S_UNLIMITED, swmrFrameSize};
+        const hsize_t chunk[] = {1, swmrFrameSize};
+        const hid_t space = H5Screate_simple(2, dims, maxDims);
+        const hid_t properties = H5Pcreate(H5P_DATASET_CREATE);
+        H5Pset_chunk(properties, 2, chunk);
+        _data = H5Dcreate2(_file, "data", H5T_NATIVE_FLOAT, space, H5P_DEFAULT,
+                           properties, H5P_DEFAULT);
+        H5Pclose(properties);
+        H5Sclose(space);
+        BOOST_REQUIRE_GE(_data, 0);
+    }
+
+    ~SWMRReport()
+    {
+        H5Dclose(_data);
+        H5Fclose(_file);
+        boost::filesystem::remove(_path);
+    }
+
+    void startSWMR() { BOOST_REQUIRE_GE(H5Fstart_swmr_write(_file), 0); }
+
+    void appendFrames(const size_t count)
+    {
+        for (size_t i = 0; i != count; ++i, ++_frames)
+        {
+            const hsize_t dims[] = {_frames + 1, swmrFrameSize};
+            BOOST_REQUIRE_GE(H5Dset_extent(_data, dims), 0);
+
+            const hsize_t start[] = {_frames, 0};
+            const hsize_t size[] = {1, swmrFrameSize};
+            const hid_t fileSpace = H5Dget_space(_data);
+            H5Sselect_hyperslab(fileSpace, H5S_SELECT_SET, start, nullptr,
+                                size, nullptr);
+            const hid_t memorySpace = H5Screate_simple(2, size, nullptr);
+            const std::vector<float> values = getFrame(_frames);
+            BOOST_REQUIRE_GE(H5Dwrite(_data, H5T_NATIVE_FLOAT, memorySpace,
+                                      fileSpace, H5P_DEFAULT, values.data()),
+                             0);
+            H5Sclose(memorySpace);
+            H5Sclose(fileSpace);
+        }
+        BOOST_REQUIRE_GE(H5Dflush(_data), 0);
+    }
+
+    static std::vector<float> getFrame(const size_t index)
+    {
+        std::vector<float> values;
+        for (size_t i = 0; i != swmrFrameSize; ++i)
+            values.push_back(float(index * 10 + i));
+        return values;
+    }
+
+private:
+    const std::string _path;
+    hid_t _file = -1;
+    hid_t _data = -1;
+    size_t _frames = 0;
+
+    hid_t _createAttribute(const char* name, const hid_t type,
+                           const hsize_t size)
+    {
+        const hid_t space = H5Screate_simple(1, &size, nullptr);
+        const hid_t attribute =
+            H5Acreate2(_file, name, type, space, H5P_DEFAULT, H5P_DEFAULT);
+        H5Sclose(space);
+        return attribute;
+    }
+
+    static void _write(const hid_t attribute, const hid_t type,
+                       const void* data)
+    {
+        BOOST_REQUIRE_GE(H5Awrite(attribute, type, data), 0);
+        H5Aclose(attribute);
+    }
+
+    static void _writeDataSet(const hid_t group, const char* name,
+                              const hid_t type, const hsize_t size,
+                              const void* data)
+    {
+        const hid_t space = H5Screate_simple(1, &size, nullptr);
+        const hid_t dataset = H5Dcreate2(group, name, type, space, H5P_DEFAULT,
+                                         H5P_DEFAULT, H5P_DEFAULT);
+        H5Sclose(space);
+        BOOST_REQUIRE_GE(H5Dwrite(dataset, type, H5S_ALL, H5S_ALL, H5P_DEFAULT,
+                                  data),
+                         0);
+        H5Dclose(dataset);
+    }
+};
+}
+
+BOOST_AUTO_TEST_CASE(tail_sonata_swmr)
+{
+    const std::string path = "/tmp/" + servus::make_UUID().getString() + ".h5";
+    SWMRReport writer(path);
+    writer.appendFrames(2);
+    writer.startSWMR();
+
+    brion::CompartmentReport report(brion::URI(path + "?tail"),
+                                    brion::MODE_READ, brion::GIDSet());
+    BOOST_CHECK_EQUAL(report.getFrameSize(), swmrFrameSize);
+    BOOST_CHECK_EQUAL(report.getFrameCount(), 2);
+    BOOST_CHECK(report.refresh());
+    BOOST_CHECK_EQUAL(report.getFrameCount(), 2);
+    BOOST_CHECK(!report.waitForFrames(3, 0));
+    BOOST_CHECK(!report.loadFrame(report.getEndTime()).get().data);
+
+    // The new frames are seen once the extent of the dataset is refreshed
+    writer.appendFrames(1);
+    BOOST_CHECK(report.refresh());
+    BOOST_CHECK_EQUAL(report.getFrameCount(), 3);
+
+    writer.appendFrames(swmrFrameCount - 3);
+    BOOST_CHECK(report.waitForFrames(swmrFrameCount, 1000));
+    BOOST_CHECK(!report.refresh());
+    BOOST_CHECK_EQUAL(report.getFrameCount(), swmrFrameCount);
+    BOOST_CHECK_CLOSE(report.getEndTime(), swmrFrameCount * 0.1,
+                      0.0001);
+
+    for (size_t i = 0; i != swmrFrameCount; ++i)
+    {
+        const auto frame = report.loadFrame((i + 0.5) * 0.1).get();
+        BOOST_REQUIRE(frame.data);
+        const auto expected = SWMRReport::getFrame(i);
+        BOOST_CHECK_EQUAL_COLLECTIONS(frame.data->begin(), frame.data->end(),
+                                      expected.begin(), expected.end());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(refresh_sonata_writer)
+{
+    const std::string path = "/tmp/" + servus::make_UUID().getString() + ".h5";
+    {
+        brion::CompartmentReport report(brion::URI(path),
+                                        brion::MODE_OVERWRITE);
+        report.writeHeader(0, 1, 0.1, "mV", "ms");
+
+        // A writer has all its frames, its end time is the one of the header
+        BOOST_CHECK(!report.refresh());
+        BOOST_CHECK_EQUAL(report.getEndTime(), 1);
+        BOOST_CHECK_EQUAL(report.getFrameCount(), 10);
+    }
+    boost::filesystem::remove(path);
+}
@@ -0,0 +1,97 @@
+/* Copyright (c) 2018, EPFL/Blue Brain Project
+ *
+ * This file is part of Brion <https://github.com/BlueBrain/Brion>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <brion/executor.h>
+
+#define BOOST_TEST_MODULE Executor
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using Priority = brion::Executor::Priority;
+
+BOOST_AUTO_TEST_CASE(post)
+{
+    brion::Executor executor(2);
+    BOOST_CHECK_EQUAL(executor.getSize(), 2u);
+    BOOST_CHECK(!executor.isWorkerThread());
+    BOOST_CHECK_EQUAL(executor.post([] { return 42; }).get(), 42);
+    BOOST_CHECK_EQUAL(executor.post([] { return 7; }, Priority::bulk).get(),
+                      7);
+    BOOST_CHECK(executor.post([&] { return executor.isWorkerThread(); }).get());
+    BOOST_CHECK_THROW(
+        executor.post([] { throw std::runtime_error("failed"); }).get(),
+        std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(nested_post_does_not_deadlock)
+{
+    brion::Executor executor(1);
+    auto future = executor.post(
+        [&] { return executor.post([] { return 42; }, Priority::bulk).get(); });
+    BOOST_CHECK_EQUAL(future.get(), 42);
+}
+
+BOOST_AUTO_TEST_CASE(interactive_not_starved_by_bulk)
+{
+    brion::Executor executor(2);
+    std::atomic<bool> release{false};
+    std::vector<std::future<void>> bulk;
+    for (size_t i = 0; i < 8; ++i)
+        bulk.push_back(executor.post(
+            [&] {
+                while (!release)
+                    std::this_thread::yield();
+            },
+            Priority::bulk));
+
+    // One thread is reserved for interactive tasks
+    auto interactive = executor.post([] { return true; });
+    BOOST_CHECK(interactive.wait_for(std::chrono::seconds(10)) ==
+                std::future_status::ready);
+    BOOST_CHECK(executor.hasPendingJobs());
+
+    release = true;
+    for (auto& future : bulk)
+        future.get();
+}
+
+BOOST_AUTO_TEST_CASE(bounded_queue)
+{
+    brion::Executor executor(1, 2);
+    std::atomic<size_t> done{0};
+    for (size_t i = 0; i < 16; ++i)
+        executor.post([&] { ++done; });
+    executor.post([] {}).get();
+    BOOST_CHECK_EQUAL(done.load(), 16u);
+}
+
+BOOST_AUTO_TEST_CASE(default_executor)
+{
+    auto executor = std::make_shared<brion::Executor>(1);
+    brion::Executor::setDefault(executor);
+    BOOST_CHECK_EQUAL(brion::Executor::getDefault(), executor);
+    BOOST_CHECK(
+        brion::Executor::getDefault()->post([] { return true; }).get());
+
+    brion::Executor::setDefault(nullptr);
+    BOOST_CHECK_NE(brion::Executor::getDefault(), executor);
+    BOOST_CHECK_GT(brion::Executor::getDefault()->getSize(), 0u);
+}
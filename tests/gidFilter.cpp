@@ -0,0 +1,103 @@
+/* Copyright (c) 2018, EPFL/Blue Brain Project
+ *
+ * This file is part of Brion <https://github.com/BlueBrain/Brion>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <brion/gidFilter.h>
+
+#define BOOST_TEST_MODULE GIDFilter
+#include <boost/test/unit_test.hpp>
+
+#include <limits>
+
+BOOST_AUTO_TEST_CASE(empty_filter)
+{
+    const brion::GIDFilter filter;
+    BOOST_CHECK(filter.empty());
+    BOOST_CHECK(filter.contains(0));
+    BOOST_CHECK(filter.contains(std::numeric_limits<uint32_t>::max()));
+
+    const brion::Spikes spikes{{0.1f, 1}, {0.2f, 2}};
+    brion::Spikes filtered;
+    filter.filter(spikes.data(), spikes.size(), filtered);
+    BOOST_CHECK(filtered == spikes);
+}
+
+BOOST_AUTO_TEST_CASE(contains)
+{
+    // Sparse GIDs spread over several pages, including the largest GID
+    const uint32_t max = std::numeric_limits<uint32_t>::max();
+    const brion::GIDSet gids{10, 11, 70000, 1000000, max};
+    const brion::GIDFilter filter(gids);
+    BOOST_CHECK(!filter.empty());
+
+    for (const uint32_t gid : gids)
+        BOOST_CHECK(filter.contains(gid));
+    for (const uint32_t gid : {0u, 9u, 12u, 69999u, 70001u, 999999u, max - 1})
+        BOOST_CHECK(!filter.contains(gid));
+}
+
+BOOST_AUTO_TEST_CASE(filter)
+{
+    const brion::GIDFilter filter(brion::GIDSet{2, 4});
+    const brion::Spikes spikes{{0.1f, 1}, {0.2f, 2}, {0.3f, 3}, {0.4f, 4}};
+    const brion::Spikes expected{{0.0f, 0}, {0.2f, 2}, {0.4f, 4}};
+
+    // Accepted spikes are appended
+    brion::Spikes filtered{{0.0f, 0}};
+    filter.filter(spikes.data(), spikes.size(), filtered);
+    BOOST_CHECK_EQUAL_COLLECTIONS(filtered.begin(), filtered.end(),
+                                  expected.begin(), expected.end());
+
+    const brion::floats timestamps{0.1f, 0.2f, 0.3f, 0.4f};
+    const brion::uint32_ts ids{1, 2, 3, 4};
+    filtered = {{0.0f, 0}};
+    filter.filter(timestamps.data(), ids.data(), ids.size(), filtered);
+    BOOST_CHECK_EQUAL_COLLECTIONS(filtered.begin(), filtered.end(),
+                                  expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(filter_large_input)
+{
+    // One spike in a thousand is accepted
+    const brion::GIDFilter filter(brion::GIDSet{7});
+    brion::Spikes spikes;
+    brion::floats timestamps;
+    brion::uint32_ts ids;
+    for (size_t i = 0; i < 1000000; ++i)
+    {
+        spikes.push_back({float(i), uint32_t(i % 1000)});
+        timestamps.push_back(float(i));
+        ids.push_back(uint32_t(i % 1000));
+    }
+
+    brion::Spikes expected;
+    for (const auto& spike : spikes)
+        if (spike.second == 7)
+            expected.push_back(spike);
+
+    // The output does not grow by the size of the input
+    brion::Spikes filtered;
+    filter.filter(spikes.data(), spikes.size(), filtered);
+    BOOST_CHECK(filtered == expected);
+    BOOST_CHECK_LT(filtered.capacity(), spikes.size() / 4);
+
+    filtered.clear();
+    filtered.shrink_to_fit();
+    filter.filter(timestamps.data(), ids.data(), ids.size(), filtered);
+    BOOST_CHECK(filtered == expected);
+    BOOST_CHECK_LT(filtered.capacity(), spikes.size() / 4);
+}
@@ -0,0 +1,254 @@
+/* Copyright (c) 2018, EPFL/Blue Brain Project
+ *
+ * This file is part of Brion <https://github.com/BlueBrain/Brion>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <BBP/TestDatasets.h>
+#include <brain/brain.h>
+#include <keyv/Map.h>
+
+#define BOOST_TEST_MODULE KeyvLocal
+#include <boost/filesystem/operations.hpp>
+#include <boost/filesystem/path.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <cstdlib>
+#include <fstream>
+
+namespace fs = boost::filesystem;
+
+namespace
+{
+// The layout of a record written by the store, see keyvLocal.cpp
+const uint64_t fileHeaderSize = 16;
+const uint32_t recordMagic = 0x6b76726c;
+struct RecordHeader
+{
+    uint32_t magic;
+    uint32_t flags;
+    uint64_t keySize;
+    uint64_t size;
+    uint64_t rawSize;
+};
+
+// A record of a one character key and an eight characters value
+const uint64_t recordSize = sizeof(RecordHeader) + 8 + 8;
+
+struct Store
+{
+    Store()
+        : path(fs::temp_directory_path() / fs::unique_path())
+    {
+    }
+    ~Store() { fs::remove(path); }
+
+    servus::URI getURI(const std::string& query = std::string()) const
+    {
+        return servus::URI("local://" + path.string() + query);
+    }
+
+    void write(const uint64_t offset, const void* data,
+               const size_t size) const
+    {
+        std::fstream file(path.string(), std::ios::in | std::ios::out |
+                                             std::ios::binary);
+        file.seekp(offset);
+        file.write(static_cast<const char*>(data), size);
+    }
+
+    const fs::path path;
+};
+}
+
+BOOST_AUTO_TEST_CASE(insert_get_erase)
+{
+    const Store store;
+    keyv::Map map(store.getURI());
+
+    BOOST_CHECK(map["a"].empty());
+    BOOST_CHECK(map.insert("a", std::string("value a1")));
+    BOOST_CHECK(map.insert("b", std::string("value b1")));
+    BOOST_CHECK_EQUAL(map["a"], "value a1");
+    BOOST_CHECK_EQUAL(map["b"], "value b1");
+
+    BOOST_CHECK(map.insert("a", std::string("value a2")));
+    BOOST_CHECK_EQUAL(map["a"], "value a2");
+
+    BOOST_CHECK(map.erase("b"));
+    BOOST_CHECK(map["b"].empty());
+    BOOST_CHECK(map.flush());
+}
+
+BOOST_AUTO_TEST_CASE(reopen)
+{
+    const Store store;
+    {
+        keyv::Map map(store.getURI());
+        BOOST_CHECK(map.insert("a", std::string("value a1")));
+        BOOST_CHECK(map.insert("b", std::string("value b1")));
+        BOOST_CHECK(map.insert("a", std::string("value a2")));
+        BOOST_CHECK(map.erase("b"));
+    }
+
+    const keyv::Map map(store.getURI());
+    BOOST_CHECK_EQUAL(map["a"], "value a2");
+    BOOST_CHECK(map["b"].empty());
+}
+
+BOOST_AUTO_TEST_CASE(compression)
+{
+    const Store store;
+    const std::string value(65536, 'x');
+    {
+        keyv::Map map(store.getURI("?compression=zlib"));
+        BOOST_CHECK(map.insert("a", value));
+        BOOST_CHECK(map.insert("b", std::string("value b1")));
+        BOOST_CHECK_EQUAL(map["a"], value);
+    }
+#ifdef BRION_USE_ZLIB
+    BOOST_CHECK_LT(fs::file_size(store.path), value.size());
+#endif
+
+    // compressed values are readable regardless of the compression setting
+    const keyv::Map map(store.getURI());
+    BOOST_CHECK_EQUAL(map["a"], value);
+    BOOST_CHECK_EQUAL(map["b"], "value b1");
+}
+
+BOOST_AUTO_TEST_CASE(torn_tail_recovery)
+{
+    const Store store;
+    {
+        keyv::Map map(store.getURI());
+        BOOST_CHECK(map.insert("a", std::string("value a1")));
+    }
+    BOOST_REQUIRE_EQUAL(fs::file_size(store.path), fileHeaderSize + recordSize);
+
+    // an interrupted write of a record, which has its header and key only
+    const RecordHeader header{recordMagic, 0, 1, 8, 8};
+    const char key[8] = {'x'};
+    store.write(fileHeaderSize + recordSize, &header, sizeof(header));
+    store.write(fileHeaderSize + recordSize + sizeof(header), key, sizeof(key));
+
+    {
+        keyv::Map map(store.getURI());
+        BOOST_CHECK_EQUAL(map["a"], "value a1");
+        BOOST_CHECK(map["x"].empty());
+
+        // the torn record is overwritten by the next append
+        BOOST_CHECK(map.insert("b", std::string("value b1")));
+    }
+    BOOST_CHECK_EQUAL(fs::file_size(store.path),
+                      fileHeaderSize + 2 * recordSize);
+
+    const keyv::Map map(store.getURI());
+    BOOST_CHECK_EQUAL(map["a"], "value a1");
+    BOOST_CHECK_EQUAL(map["b"], "value b1");
+    BOOST_CHECK(map["x"].empty());
+}
+
+BOOST_AUTO_TEST_CASE(corrupt_record)
+{
+    const Store store;
+    {
+        keyv::Map map(store.getURI());
+        BOOST_CHECK(map.insert("a", std::string("value a1")));
+        BOOST_CHECK(map.insert("b", std::string("value b1")));
+        BOOST_CHECK(map.insert("c", std::string("value c1")));
+    }
+    const uint64_t size = fileHeaderSize + 3 * recordSize;
+    BOOST_REQUIRE_EQUAL(fs::file_size(store.path), size);
+
+    const uint32_t badMagic = 0;
+    store.write(fileHeaderSize + recordSize, &badMagic, sizeof(badMagic));
+
+    keyv::Map map(store.getURI());
+    BOOST_CHECK_EQUAL(map["a"], "value a1");
+    BOOST_CHECK(map["b"].empty());
+    BOOST_CHECK(map["c"].empty());
+
+    // appending must not drop the valid record after the corrupt one
+    BOOST_CHECK_THROW(map.insert("d", std::string("value d1")),
+                      std::runtime_error);
+    BOOST_CHECK_THROW(map.erase("a"), std::runtime_error);
+    BOOST_CHECK_EQUAL(fs::file_size(store.path), size);
+
+    store.write(fileHeaderSize + recordSize, &recordMagic, sizeof(recordMagic));
+    const keyv::Map repaired(store.getURI());
+    BOOST_CHECK_EQUAL(repaired["c"], "value c1");
+}
+
+BOOST_AUTO_TEST_CASE(cross_instance_visibility)
+{
+    const Store store;
+    keyv::Map map1(store.getURI());
+    keyv::Map map2(store.getURI());
+
+    BOOST_CHECK(map1.insert("a", std::string("value a1")));
+    BOOST_CHECK_EQUAL(map2["a"], "value a1");
+
+    BOOST_CHECK(map2.insert("b", std::string("value b1")));
+    BOOST_CHECK_EQUAL(map1["b"], "value b1");
+
+    // appends of both instances are interleaved without loss
+    for (size_t i = 0; i < 100; ++i)
+    {
+        const std::string key = std::to_string(i);
+        BOOST_CHECK((i % 2 ? map1 : map2).insert(key, key));
+    }
+    for (size_t i = 0; i < 100; ++i)
+    {
+        const std::string key = std::to_string(i);
+        BOOST_CHECK_EQUAL(map1[key], key);
+        BOOST_CHECK_EQUAL(map2[key], key);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(local_cache)
+{
+    const Store store;
+    ::unsetenv("MEMCACHED_SERVERS");
+    ::unsetenv("LEVELDB_CACHE");
+    ::setenv("BRION_LOCAL_CACHE", store.path.string().c_str(), 1);
+
+    const brain::GIDSet gids{1, 2, 3};
+    brain::neuron::Morphologies loaded;
+    {
+        const brain::Circuit circuit((brion::URI(BBP_TEST_BLUECONFIG3)));
+        loaded =
+            circuit.loadMorphologies(gids, brain::Circuit::Coordinates::local);
+    }
+    // the loaded morphologies have been saved in the cache file
+    BOOST_REQUIRE(fs::exists(store.path));
+    const auto size = fs::file_size(store.path);
+    BOOST_CHECK_GT(size, fileHeaderSize);
+
+    // and are served from there by a new circuit without further appends
+    const brain::Circuit circuit((brion::URI(BBP_TEST_BLUECONFIG3)));
+    const auto cached =
+        circuit.loadMorphologies(gids, brain::Circuit::Coordinates::local);
+    BOOST_CHECK_EQUAL(fs::file_size(store.path), size);
+
+    BOOST_REQUIRE_EQUAL(cached.size(), loaded.size());
+    for (size_t i = 0; i < cached.size(); ++i)
+    {
+        const auto& points1 = loaded[i]->getPoints();
+        const auto& points2 = cached[i]->getPoints();
+        BOOST_CHECK_EQUAL_COLLECTIONS(points1.begin(), points1.end(),
+                                      points2.begin(), points2.end());
+    }
+    ::unsetenv("BRION_LOCAL_CACHE");
+}
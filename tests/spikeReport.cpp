@@ -20,14 +20,26 @@
 
 #include <BBP/TestDatasets.h>
 #include <brion/brion.h>
+#include <brion/executor.h>
 #include <servus/uint128_t.h>
 #include <tests/paths.h>
 
+#include <hdf5.h>
+
 #define BOOST_TEST_MODULE SpikeReport
 #include <boost/filesystem/operations.hpp>
 #include <boost/filesystem/path.hpp>
 #include <boost/test/unit_test.hpp>
 
+#include <algorithm>
+#include <fstream>
+#include <thread>
+
+#ifndef _WIN32
+#include <csignal>
+#include <sys/resource.h>
+#endif
+
 constexpr auto BLURON_SPIKE_FILE = "spikes/spikes.dat";
 constexpr auto NEST_SPIKE_FILE = "spikes/spikes-*.gdf";
 constexpr auto BINARY_SPIKE_FILE = "spikes/binary.spikes";
@@ -415,6 +427,32 @@ BOOST_AUTO_TEST_CASE(invalid_read_binary)
         test(file);
 }
 
+BOOST_AUTO_TEST_CASE(io_statistics)
+{
+    auto test = [](const char* suffix) {
+        boost::filesystem::path path(BRION_TESTDATA);
+        brion::SpikeReport report(brion::URI((path / suffix).string()),
+                                  brion::MODE_READ);
+
+        const auto spikes = report.read(brion::UNDEFINED_TIMESTAMP).get();
+        const auto stats = report.getIOStatistics();
+        BOOST_CHECK_MESSAGE(stats.bytesRequested ==
+                                spikes.size() * sizeof(brion::Spike),
+                            suffix << " bad requested bytes "
+                                   << stats.bytesRequested);
+        BOOST_CHECK_MESSAGE(stats.bytesRead > 0, suffix << " no bytes read");
+        BOOST_CHECK_MESSAGE(stats.readOperations > 0,
+                            suffix << " no read operations");
+
+        report.resetIOStatistics();
+        BOOST_CHECK_EQUAL(report.getIOStatistics().bytesRequested, 0);
+        BOOST_CHECK_EQUAL(report.getIOStatistics().bytesRead, 0);
+    };
+
+    for (auto&& file : ALL_FILES)
+        test(file);
+}
+
 // write
 
 inline void testWrite(const char* format)
@@ -444,6 +482,117 @@ inline void testWrite(const char* format)
                                   spikes.begin(), spikes.end());
 }
 
+namespace
+{
+// @return the message of the exception thrown when opening the report
+std::string getOpenError(const std::string& filename)
+{
+    try
+    {
+        brion::SpikeReport report(brion::URI(filename), brion::MODE_READ);
+    }
+    catch (const std::runtime_error& e)
+    {
+        return e.what();
+    }
+    return std::string();
+}
+}
+
+BOOST_AUTO_TEST_CASE(parse_ascii_ranges)
+{
+    // Large enough for the file to be split in ranges over 4 threads. The
+    // lines have different lengths, so the ranges start within lines.
+    brion::Executor::setDefault(std::make_shared<brion::Executor>(4));
+    TemporaryData data{"dat"};
+    data.spikes.clear();
+    {
+        std::ofstream file(data.tmpFileName);
+        file << "/scatter\n";
+        for (uint32_t i = 0; i < 600000; ++i)
+        {
+            const brion::Spike spike{float((i * 7919) % 20000) * 0.25f,
+                                     i % 100000};
+            file << spike.first << " " << spike.second << "\n";
+            data.spikes.push_back(spike);
+        }
+    }
+    BOOST_REQUIRE_GT(boost::filesystem::file_size(data.tmpFileName),
+                     4 * (1 << 20));
+    std::sort(data.spikes.begin(), data.spikes.end());
+
+    {
+        brion::SpikeReport report(brion::URI(data.tmpFileName),
+                                  brion::MODE_READ);
+        const auto spikes = report.read(brion::UNDEFINED_TIMESTAMP).get();
+        BOOST_CHECK(spikes == data.spikes);
+    }
+
+    // The line of an error in the last range is counted from the file start
+    {
+        std::ofstream file(data.tmpFileName, std::ios::app);
+        file << "1.5 x\n";
+    }
+    BOOST_CHECK_MESSAGE(getOpenError(data.tmpFileName).find("at line 600002") !=
+                            std::string::npos,
+                        getOpenError(data.tmpFileName));
+
+    // and in a file parsed in a single range
+    {
+        std::ofstream file(data.tmpFileName);
+        file << "0.1 1\n0.2 2\n\n0.3 x\n";
+    }
+    BOOST_CHECK_MESSAGE(getOpenError(data.tmpFileName).find("at line 4") !=
+                            std::string::npos,
+                        getOpenError(data.tmpFileName));
+    brion::Executor::setDefault(nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(merge_nest_files)
+{
+    // Enough spikes for the sorted runs of the files to be merged in several
+    // parts over 4 threads. The spike times of the files interleave.
+    brion::Executor::setDefault(std::make_shared<brion::Executor>(4));
+    const auto dir = boost::filesystem::temp_directory_path() /
+                     boost::filesystem::unique_path();
+    boost::filesystem::create_directory(dir);
+
+    brion::Spikes expected;
+    for (uint32_t f = 0; f < 5; ++f)
+    {
+        std::ofstream file(
+            (dir / ("spikes-" + std::to_string(f) + ".gdf")).string());
+        for (uint32_t i = 0; i < 60000; ++i)
+        {
+            const brion::Spike spike{float((i * 5 + f) % 40000) * 0.25f,
+                                     f * 60000 + i};
+            file << spike.second << " " << spike.first << "\n";
+            expected.push_back(spike);
+        }
+    }
+    std::sort(expected.begin(), expected.end());
+
+    const std::string uri = (dir / "spikes-*.gdf").string();
+    {
+        brion::SpikeReport report(brion::URI(uri), brion::MODE_READ);
+        const auto spikes = report.read(brion::UNDEFINED_TIMESTAMP).get();
+        BOOST_CHECK(spikes == expected);
+    }
+
+    // An error in one of the files is reported with its name and line
+    {
+        std::ofstream file((dir / "spikes-3.gdf").string(), std::ios::app);
+        file << "12 x\n";
+    }
+    const std::string error = getOpenError(uri);
+    BOOST_CHECK_MESSAGE(error.find("spikes-3.gdf failed at line 60001") !=
+                            std::string::npos,
+                        error);
+
+    boost::filesystem::remove_all(dir);
+    brion::Executor::setDefault(nullptr);
+}
+
 BOOST_AUTO_TEST_CASE(write_data_binary)
 {
     testWrite("spikes");
@@ -459,6 +608,168 @@ BOOST_AUTO_TEST_CASE(write_data_bluron)
     testWrite("dat");
 }
 
+BOOST_AUTO_TEST_CASE(write_data_sonata)
+{
+    TemporaryData data{"h5"};
+    {
+        // A stride of 2 gives a time index entry for every other spike
+        brion::SpikeReport report{brion::URI(data.tmpFileName +
+                                             "?time_index=2"),
+                                  brion::MODE_WRITE};
+        report.write(brion::Spikes{data.spikes.begin(),
+                                   data.spikes.begin() + 3});
+        report.write(brion::Spikes{data.spikes.begin() + 3,
+                                   data.spikes.end()});
+        report.close();
+    }
+
+    brion::SpikeReport report{brion::URI(data.tmpFileName), brion::MODE_READ};
+    BOOST_CHECK_EQUAL(report.getEndTime(), data.spikes.back().first);
+
+    brion::Spikes spikes = report.readUntil(0.3f).get();
+    BOOST_CHECK_EQUAL_COLLECTIONS(data.spikes.begin(),
+                                  data.spikes.begin() + 3, spikes.begin(),
+                                  spikes.end());
+
+    report.seek(0.2f).get();
+    spikes = report.read(brion::UNDEFINED_TIMESTAMP).get();
+    BOOST_CHECK_EQUAL_COLLECTIONS(data.spikes.begin() + 1, data.spikes.end(),
+                                  spikes.begin(), spikes.end());
+}
+
+BOOST_AUTO_TEST_CASE(read_sonata_index_without_stride)
+{
+    TemporaryData data{"h5"};
+    {
+        brion::SpikeReport report{brion::URI(data.tmpFileName +
+                                             "?time_index=2"),
+                                  brion::MODE_WRITE};
+        report.write(data.spikes);
+        report.close();
+    }
+    {
+        const hid_t file =
+            H5Fopen(data.tmpFileName.c_str(), H5F_ACC_RDWR, H5P_DEFAULT);
+        BOOST_REQUIRE_GE(file, 0);
+        const hid_t index = H5Dopen2(file, "/spikes/time_index", H5P_DEFAULT);
+        BOOST_REQUIRE_GE(index, 0);
+        BOOST_CHECK_GE(H5Adelete(index, "stride"), 0);
+        H5Dclose(index);
+        H5Fclose(file);
+    }
+    BOOST_CHECK_THROW(brion::SpikeReport(brion::URI(data.tmpFileName),
+                                         brion::MODE_READ),
+                      std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(stream_sonata_by_time)
+{
+    // Large enough for the binary search of the timestamps, with 10 spikes
+    // per timestamp to have equal timestamps across index entries
+    TemporaryData data{"h5"};
+    data.spikes.clear();
+    for (size_t i = 0; i < 20000; ++i)
+        data.spikes.push_back({i / 10 * 0.5f, uint32_t(i % 10)});
+
+    const auto test = [&](const std::string& query) {
+        {
+            brion::SpikeReport report{brion::URI(data.tmpFileName + query),
+                                      brion::MODE_WRITE};
+            report.write(data.spikes);
+            report.close();
+        }
+
+        brion::SpikeReport report{brion::URI(data.tmpFileName),
+                                  brion::MODE_READ};
+        BOOST_CHECK_EQUAL(report.getEndTime(), data.spikes.back().first);
+
+        // Seeks landing on, before, after and between index entries
+        for (const float time : {0.f, 0.25f, 49.75f, 50.f, 50.25f, 123.4f,
+                                 499.9f, 999.5f, 10.f, -1.f})
+        {
+            report.seek(time).get();
+            BOOST_CHECK_EQUAL(report.getState(), brion::SpikeReport::State::ok);
+            const auto first =
+                std::lower_bound(data.spikes.begin(), data.spikes.end(),
+                                 brion::Spike(time, 0));
+            const auto middle =
+                std::lower_bound(first, data.spikes.end(),
+                                 brion::Spike(time + 7.f, 0));
+
+            auto spikes = report.readUntil(time + 7.f).get();
+            BOOST_CHECK_MESSAGE(spikes.size() == size_t(middle - first) &&
+                                    std::equal(spikes.begin(), spikes.end(),
+                                               first),
+                                query << " bad spikes until " << time + 7.f);
+
+            if (report.getState() == brion::SpikeReport::State::ok)
+                spikes = report.read(brion::UNDEFINED_TIMESTAMP).get();
+            else
+                spikes.clear();
+            BOOST_CHECK_MESSAGE(spikes.size() ==
+                                        size_t(data.spikes.end() - middle) &&
+                                    std::equal(spikes.begin(), spikes.end(),
+                                               middle),
+                                query << " bad spikes after " << time);
+            BOOST_CHECK_EQUAL(report.getState(),
+                              brion::SpikeReport::State::ended);
+        }
+
+        report.seek(1000.f).get();
+        BOOST_CHECK_EQUAL(report.getState(), brion::SpikeReport::State::ended);
+
+        // The bytes read by a seek between two index entries
+        report.resetIOStatistics();
+        report.seek(500.25f).get();
+        return report.getIOStatistics().bytesRead;
+    };
+
+    const auto unindexed = test("");
+    const auto indexed = test("?time_index=1000");
+    test("?time_index=7");
+    BOOST_CHECK_LT(indexed, unindexed);
+}
+
+BOOST_AUTO_TEST_CASE(seek_and_write_sonata)
+{
+    TemporaryData data{"h5"};
+    brion::SpikeReport report(brion::URI(data.tmpFileName), brion::MODE_WRITE);
+    BOOST_CHECK(!report.supportsBackwardSeek());
+    report.write({{0.1f, 1}});
+    BOOST_CHECK_THROW(report.seek(0.05f).get(), std::runtime_error);
+    report.seek(0.5f).get();
+    BOOST_CHECK_EQUAL(report.getCurrentTime(), 0.5f);
+}
+
+#ifndef _WIN32
+BOOST_AUTO_TEST_CASE(write_error_sonata)
+{
+    TemporaryData data{"h5"};
+    data.spikes.clear();
+    // Enough blocks of spikes for the writer to wait for a failed append
+    for (size_t i = 0; i < 5 * 1024 * 1024; ++i)
+        data.spikes.push_back({i * 0.001f, uint32_t(i % 100)});
+
+    brion::SpikeReport report(brion::URI(data.tmpFileName), brion::MODE_WRITE);
+
+    // Limiting the file size fails the appends like a full disk would
+    rlimit limit;
+    ::getrlimit(RLIMIT_FSIZE, &limit);
+    const rlimit previous = limit;
+    limit.rlim_cur = 1024 * 1024;
+    const auto handler = ::signal(SIGXFSZ, SIG_IGN);
+    ::setrlimit(RLIMIT_FSIZE, &limit);
+
+    // The error of the background thread is raised by the write, then by
+    // close, which still has a block to write
+    BOOST_CHECK_THROW(report.write(data.spikes), std::runtime_error);
+    BOOST_CHECK_THROW(report.close(), std::runtime_error);
+
+    ::setrlimit(RLIMIT_FSIZE, &previous);
+    ::signal(SIGXFSZ, handler);
+}
+#endif
+
 BOOST_AUTO_TEST_CASE(invalid_write)
 {
     auto test = [](const char* format) {
@@ -539,3 +850,284 @@ BOOST_AUTO_TEST_CASE(seek_and_write_binary)
 {
     testSeekAndWrite("spikes");
 }
+
+BOOST_AUTO_TEST_CASE(write_data_binary_v2)
+{
+    TemporaryData data{"spikes"};
+    {
+        // Blocks of 0.15 ms give several blocks for the test data
+        brion::SpikeReport report{brion::URI(data.tmpFileName +
+                                             "?version=2&block_duration=0.15"),
+                                  brion::MODE_WRITE};
+        report.write(brion::Spikes{data.spikes.begin(),
+                                   data.spikes.begin() + 3});
+        report.write(brion::Spikes{data.spikes.begin() + 3,
+                                   data.spikes.end()});
+        report.close();
+    }
+
+    brion::SpikeReport report{brion::URI(data.tmpFileName), brion::MODE_READ};
+    BOOST_CHECK_EQUAL(report.getEndTime(), data.spikes.back().first);
+
+    brion::Spikes spikes = report.readUntil(0.3f).get();
+    BOOST_CHECK_EQUAL_COLLECTIONS(data.spikes.begin(),
+                                  data.spikes.begin() + 3, spikes.begin(),
+                                  spikes.end());
+
+    report.seek(0.2f).get();
+    spikes = report.read(brion::UNDEFINED_TIMESTAMP).get();
+    BOOST_CHECK_EQUAL_COLLECTIONS(data.spikes.begin() + 1, data.spikes.end(),
+                                  spikes.begin(), spikes.end());
+
+    brion::SpikeReport filtered{brion::URI(data.tmpFileName), {22, 25}};
+    spikes = filtered.read(brion::UNDEFINED_TIMESTAMP).get();
+    const brion::Spikes expected{data.spikes[1], data.spikes[4]};
+    BOOST_CHECK_EQUAL_COLLECTIONS(spikes.begin(), spikes.end(),
+                                  expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(filtered_read_binary_v2_skips_blocks)
+{
+    // 100 blocks of 2000 cells, which have a Bloom filter, then 5 blocks of
+    // 10 cells, which list them. Cell 7 only fires in 3 of these blocks.
+    TemporaryData data{"spikes"};
+    const std::set<uint32_t> firing{10, 50, 102};
+    brion::Spikes expected;
+    {
+        brion::SpikeReport report{brion::URI(data.tmpFileName +
+                                             "?version=2&block_duration=10"),
+                                  brion::MODE_WRITE};
+        for (uint32_t block = 0; block < 105; ++block)
+        {
+            const uint32_t numCells = block < 100 ? 2000 : 10;
+            brion::Spikes spikes;
+            for (uint32_t i = 0; i < numCells; ++i)
+            {
+                const float time = block * 10.f + i * 5.f / numCells;
+                const uint32_t gid =
+                    i == 0 && firing.count(block)
+                        ? 7
+                        : 8 + (block * 7919 + i * 104729) % 100000;
+                spikes.emplace_back(time, gid);
+                if (gid == 7)
+                    expected.emplace_back(time, gid);
+            }
+            report.write(spikes);
+        }
+        report.close();
+    }
+
+    brion::SpikeReport report{brion::URI(data.tmpFileName), {7}};
+    const auto spikes = report.read(brion::UNDEFINED_TIMESTAMP).get();
+    BOOST_CHECK_EQUAL_COLLECTIONS(spikes.begin(), spikes.end(),
+                                  expected.begin(), expected.end());
+
+    // Only the blocks of cell 7, and rare false positives of the Bloom
+    // filters, are decoded
+    const auto stats = report.getIOStatistics();
+    BOOST_CHECK_GE(stats.cacheMisses, firing.size());
+    BOOST_CHECK_LE(stats.cacheMisses, firing.size() + 2);
+}
+
+BOOST_AUTO_TEST_CASE(seek_and_write_binary_v2)
+{
+    TemporaryData data{"spikes"};
+    brion::SpikeReport reportWrite(brion::URI(data.tmpFileName +
+                                              "?version=2&block_duration=0.1"),
+                                   brion::MODE_WRITE);
+    reportWrite.write({{0.1, 1}});
+    reportWrite.write({{0.2, 1}});
+    reportWrite.write({{0.3, 1}});
+    reportWrite.seek(0.2).get();
+    reportWrite.write({{0.4, 1}});
+    reportWrite.write({{0.8, 1}});
+    reportWrite.close();
+
+    brion::SpikeReport reportRead(brion::URI(data.tmpFileName),
+                                  brion::MODE_READ);
+    const brion::Spikes spikes =
+        reportRead.read(brion::UNDEFINED_TIMESTAMP).get();
+    static const brion::Spikes expected = {{0.1, 1}, {0.4, 1}, {0.8, 1}};
+    BOOST_CHECK_EQUAL_COLLECTIONS(spikes.begin(), spikes.end(),
+                                  expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(view_binary)
+{
+    boost::filesystem::path path(BRION_TESTDATA);
+    path /= BINARY_SPIKE_FILE;
+    brion::SpikeReport report(brion::URI(path.string()), brion::MODE_READ);
+    BOOST_REQUIRE(report.supportsViews());
+
+    const auto view = report.getView(0.1f, 0.3f);
+    report.seek(0.1f).get();
+    const auto spikes = report.readUntil(0.3f).get();
+    BOOST_REQUIRE(!view.empty());
+    BOOST_CHECK_EQUAL_COLLECTIONS(view.begin(), view.end(), spikes.begin(),
+                                  spikes.end());
+    BOOST_CHECK(report.getView(100.f, 200.f).empty());
+    BOOST_CHECK_THROW(report.getView(0.3f, 0.1f), std::logic_error);
+
+    brion::SpikeReport filtered(brion::URI(path.string()), {100, 101});
+    BOOST_CHECK(!filtered.supportsViews());
+    BOOST_CHECK_THROW(filtered.getView(0.1f, 0.3f), std::runtime_error);
+
+    report.close();
+    BOOST_CHECK_THROW(report.getView(0.1f, 0.3f), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(seek_indexed_binary)
+{
+    // Large enough for the time index to be saved
+    TemporaryData data{"spikes"};
+    const std::string indexFile = data.tmpFileName + ".idx";
+    data.spikes.clear();
+    for (size_t i = 0; i < (1 << 20) + 1000; ++i)
+        data.spikes.push_back({i / 1000 * 0.5f, uint32_t(i % 1000)});
+    {
+        brion::SpikeReport report(brion::URI(data.tmpFileName),
+                                  brion::MODE_WRITE);
+        report.write(data.spikes);
+    }
+
+    const auto checkSeeks = [&] {
+        brion::SpikeReport report(brion::URI(data.tmpFileName),
+                                  brion::MODE_READ);
+        for (const float time : {0.f, 0.25f, 100.f, 255.75f, 300.f, 524.5f,
+                                 524.75f, 1000.f, 10.f})
+        {
+            report.seek(time).get();
+            const auto spikes =
+                report.getState() == brion::SpikeReport::State::ok
+                    ? report.readUntil(time + 1.f).get()
+                    : brion::Spikes();
+            const auto first =
+                std::lower_bound(data.spikes.begin(), data.spikes.end(),
+                                 brion::Spike(time, 0));
+            const auto last =
+                std::lower_bound(first, data.spikes.end(),
+                                 brion::Spike(time + 1.f, 0));
+            BOOST_CHECK_EQUAL_COLLECTIONS(spikes.begin(), spikes.end(), first,
+                                          last);
+        }
+    };
+
+    checkSeeks();
+    BOOST_CHECK(boost::filesystem::exists(indexFile));
+    checkSeeks(); // with the saved index
+
+    // A corrupt index is rebuilt
+    {
+        std::ofstream file(indexFile, std::ios::binary);
+        file << "garbage";
+    }
+    checkSeeks();
+    BOOST_CHECK_GT(boost::filesystem::file_size(indexFile), 7);
+
+    // Writing the report again removes the index
+    {
+        brion::SpikeReport report(brion::URI(data.tmpFileName),
+                                  brion::MODE_WRITE);
+    }
+    BOOST_CHECK(!boost::filesystem::exists(indexFile));
+}
+
+BOOST_AUTO_TEST_CASE(read_cursors)
+{
+    auto test = [](const char* suffix) {
+        boost::filesystem::path path(BRION_TESTDATA);
+        brion::SpikeReport report(brion::URI((path / suffix).string()),
+                                  brion::GIDSet{100, 101});
+        const auto expected = report.read(brion::UNDEFINED_TIMESTAMP).get();
+
+        // Each thread reads a different time window with its own cursor
+        const float windows[] = {0, 2.5, 5, 7.5, 10};
+        std::vector<brion::SpikeReport> cursors;
+        std::vector<brion::Spikes> spikes(4);
+        for (size_t i = 0; i < 4; ++i)
+            cursors.push_back(report.createCursor());
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < 4; ++i)
+        {
+            threads.emplace_back([&, i] {
+                cursors[i].seek(windows[i]).get();
+                spikes[i] = cursors[i].readUntil(windows[i + 1]).get();
+            });
+        }
+        for (auto& thread : threads)
+            thread.join();
+
+        brion::Spikes merged;
+        for (const auto& window : spikes)
+            merged.insert(merged.end(), window.begin(), window.end());
+        BOOST_CHECK_MESSAGE(merged == expected, suffix << " bad spikes");
+
+        // Cursors start at the beginning and outlive the report
+        report.close();
+        BOOST_CHECK_THROW(report.createCursor(), std::runtime_error);
+        BOOST_CHECK_EQUAL(cursors[0].getState(),
+                          brion::SpikeReport::State::ok);
+        cursors[0].seek(0).get();
+        BOOST_CHECK(cursors[0].read(brion::UNDEFINED_TIMESTAMP).get() ==
+                    expected);
+    };
+
+    for (auto&& file : ALL_FILES)
+        test(file);
+
+    TemporaryData data{"spikes"};
+    brion::SpikeReport writer(brion::URI(data.tmpFileName), brion::MODE_WRITE);
+    BOOST_CHECK_THROW(writer.createCursor(), std::runtime_error);
+}
+
+#ifndef _WIN32
+BOOST_AUTO_TEST_CASE(shared_memory_stream)
+{
+    const std::string name = "shm://brion_" + servus::make_UUID().getString();
+    brion::SpikeReport writer(brion::URI(name + "?capacity=100000"),
+                              brion::MODE_WRITE);
+    brion::SpikeReport reader(brion::URI(name), brion::MODE_READ);
+    BOOST_CHECK(!reader.supportsBackwardSeek());
+
+    brion::Spikes expected;
+    for (size_t i = 0; i < 10000; ++i)
+        expected.push_back({i * 0.01f, uint32_t(i % 100)});
+
+    brion::Spikes spikes;
+    std::thread thread([&] {
+        for (float t = 1; reader.getState() == brion::SpikeReport::State::ok;
+             t += 1)
+        {
+            const auto window = reader.readUntil(t).get();
+            spikes.insert(spikes.end(), window.begin(), window.end());
+        }
+    });
+    for (size_t i = 0; i < expected.size(); i += 100)
+        writer.write(expected.data() + i, 100);
+    writer.close();
+    thread.join();
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(spikes.begin(), spikes.end(),
+                                  expected.begin(), expected.end());
+    BOOST_CHECK_EQUAL(reader.getCurrentTime(), brion::UNDEFINED_TIMESTAMP);
+
+    // The stream is removed when the writer is closed
+    BOOST_CHECK_THROW(brion::SpikeReport(brion::URI(name), brion::MODE_READ),
+                      std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(shared_memory_stream_overrun)
+{
+    const std::string name = "shm://brion_" + servus::make_UUID().getString();
+    brion::SpikeReport writer(brion::URI(name + "?capacity=10"),
+                              brion::MODE_WRITE);
+    brion::SpikeReport reader(brion::URI(name), brion::MODE_READ);
+    brion::Spikes spikes;
+    for (size_t i = 0; i < 20; ++i)
+        spikes.push_back({float(i), 1});
+    writer.write(spikes);
+
+    BOOST_CHECK_THROW(reader.readUntil(5).get(), std::runtime_error);
+    BOOST_CHECK_EQUAL(reader.getState(), brion::SpikeReport::State::failed);
+}
+#endif
@@ -0,0 +1,118 @@
+/* Copyright (c) 2018, EPFL/Blue Brain Project
+ *
+ * This file is part of Brion <https://github.com/BlueBrain/Brion>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <brion/brion.h>
+#include <servus/uint128_t.h>
+
+#define BOOST_TEST_MODULE SpikeReportSorter
+#include <boost/filesystem/operations.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <random>
+
+namespace
+{
+brion::Spikes createSpikes(const size_t size)
+{
+    // Few distinct times, so that many spikes share the same time
+    std::mt19937 generator(0);
+    std::uniform_int_distribution<int> time(0, 999);
+    std::uniform_int_distribution<uint32_t> gid(1, 1000);
+    brion::Spikes spikes;
+    for (size_t i = 0; i < size; ++i)
+        spikes.emplace_back(time(generator) * 0.1f, gid(generator));
+    return spikes;
+}
+
+brion::Spikes readAll(const std::string& file)
+{
+    brion::SpikeReport report(brion::URI(file), brion::MODE_READ);
+    return report.read(brion::UNDEFINED_TIMESTAMP).get();
+}
+
+class TemporaryFile
+{
+public:
+    explicit TemporaryFile(const std::string& extension)
+        : name("/tmp/" + servus::make_UUID().getString() + extension)
+    {
+    }
+    ~TemporaryFile() { boost::filesystem::remove_all(name); }
+    const std::string name;
+};
+
+void testSort(const std::string& extension, const size_t numSpikes,
+              const size_t memoryBudget, const bool spills)
+{
+    const TemporaryFile file(extension);
+    const TemporaryFile tmpDir("");
+    boost::filesystem::create_directory(tmpDir.name);
+    const auto isEmpty = [&tmpDir] {
+        return boost::filesystem::is_empty(tmpDir.name);
+    };
+    brion::Spikes spikes = createSpikes(numSpikes);
+    {
+        brion::SpikeReportSorter sorter(brion::URI(file.name), memoryBudget,
+                                        tmpDir.name);
+        // Write in several calls of different sizes
+        for (size_t i = 0; i < spikes.size(); i += 1000 + i % 777)
+            sorter.write(spikes.data() + i,
+                         std::min(spikes.size() - i, 1000 + i % 777));
+        BOOST_CHECK_EQUAL(isEmpty(), !spills);
+        sorter.close();
+        BOOST_CHECK_EQUAL(sorter.getNumRuns() > 1, spills);
+        // The runs are removed by close(), not only by the destructor
+        BOOST_CHECK(isEmpty());
+        BOOST_CHECK_THROW(sorter.write(spikes), std::runtime_error);
+        BOOST_CHECK_NO_THROW(sorter.close());
+    }
+
+    std::sort(spikes.begin(), spikes.end());
+    const brion::Spikes sorted = readAll(file.name);
+    BOOST_REQUIRE_EQUAL(sorted.size(), spikes.size());
+    BOOST_CHECK(sorted == spikes);
+}
+}
+
+BOOST_AUTO_TEST_CASE(sort_in_memory)
+{
+    testSort(".spikes", 100000, size_t(1) << 30, false);
+}
+
+BOOST_AUTO_TEST_CASE(sort_external)
+{
+    // A budget of 2^16 spikes forces several runs
+    testSort(".spikes", 500000, (size_t(1) << 16) * sizeof(brion::Spike),
+             true);
+    testSort(".gdf", 200000, 100000 * sizeof(brion::Spike), true);
+}
+
+BOOST_AUTO_TEST_CASE(sort_empty)
+{
+    const TemporaryFile file(".spikes");
+    {
+        brion::SpikeReportSorter sorter(brion::URI(file.name));
+    }
+    BOOST_CHECK(readAll(file.name).empty());
+}
+
+BOOST_AUTO_TEST_CASE(sort_invalid_uri)
+{
+    BOOST_CHECK_THROW(brion::SpikeReportSorter(brion::URI("/tmp/foo.bar")),
+                      std::runtime_error);
+}
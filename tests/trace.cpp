@@ -0,0 +1,103 @@
+/* Copyright (c) 2018, EPFL/Blue Brain Project
+ *
+ * This file is part of Brion <https://github.com/BlueBrain/Brion>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <BBP/TestDatasets.h>
+#include <brain/compartmentReport.h>
+#include <brain/compartmentReportView.h>
+#include <brion/brion.h>
+#include <tests/paths.h>
+
+#define BOOST_TEST_MODULE Trace
+#include <boost/filesystem/operations.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+std::string readFile(const boost::filesystem::path& path)
+{
+    std::ifstream file(path.string());
+    std::stringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+}
+}
+
+BOOST_AUTO_TEST_CASE(trace_spike_report)
+{
+    const auto path = boost::filesystem::unique_path();
+    BOOST_CHECK(!brion::isTracing());
+    brion::startTracing(path.string());
+    BOOST_CHECK(brion::isTracing());
+    {
+        brion::SpikeReport report(
+            brion::URI(std::string(BRION_TESTDATA) + "/spikes/binary.spikes"),
+            brion::MODE_READ);
+        report.read(0.3).get();
+    }
+    brion::stopTracing();
+    BOOST_CHECK(!brion::isTracing());
+
+    const auto trace = readFile(path);
+    boost::filesystem::remove(path);
+    BOOST_CHECK_EQUAL(trace.find("{\"displayTimeUnit\":\"ms\""), 0);
+    BOOST_CHECK(trace.find("\"name\":\"SpikeReport::open\"") !=
+                std::string::npos);
+    BOOST_CHECK(trace.find("\"name\":\"SpikeReport::read\"") !=
+                std::string::npos);
+    BOOST_CHECK(trace.find("binary.spikes") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(trace_plugins_and_brain)
+{
+    // The events of BrionPlugins and Brain are recorded by the same tracer
+    // as the ones of Brion
+    const auto path = boost::filesystem::unique_path();
+    brion::startTracing(path.string());
+    {
+        const brion::URI uri(
+            std::string(BBP_TESTDATA) +
+            "/local/simulations/may17_2011/Control/voltage.bbp");
+        brain::CompartmentReport report(uri);
+        auto view = report.createView();
+        view.load(report.getMetaData().startTime).get();
+    }
+    brion::stopTracing();
+
+    const auto trace = readFile(path);
+    boost::filesystem::remove(path);
+    BOOST_CHECK(
+        trace.find("\"name\":\"CompartmentReportBinary::parseMapping\"") !=
+        std::string::npos);
+    BOOST_CHECK(trace.find("\"name\":\"CompartmentReportView::load\"") !=
+                std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(trace_disabled)
+{
+    const auto path = boost::filesystem::unique_path();
+    brion::startTracing(path.string());
+    brion::stopTracing();
+    boost::filesystem::remove(path);
+
+    // Nothing is written once tracing is stopped.
+    brion::stopTracing();
+    BOOST_CHECK(!boost::filesystem::exists(path));
+}